@@ -1,889 +1,4260 @@
-/**
- * @file gshell.c
- * @brief gshell C file
- * @author gfcwfzkm
- * @version 2.2
- */
-
-#include "gshell.h"
-
-/* Strings used by the library are defined here */
-#define _G_UNKCMD	"Unknown command: "
-#define _G_HLPCMD	G_CRLF"Type 'help' to list all available commands"G_CRLF
-#define _G_HLPDESC	"Lists all available commands"
-#define _G_PROMT			G_CRLF G_TEXTBOLD"gshell> "G_TEXTNORMAL
-
-/* For weird terminals that send \r instead of \n at enter-keypresses */
-#ifdef G_CR_INSTEADOF_LF
-#define _G_ENT_IGNORE	'\n'
-#define _G_STR_PROCESS	" \r"
-#define _G_STR_COMPSLIT	"\"'"
-#define _G_ENT_PROCESS	'\r'
-#else
-#define _G_ENT_IGNORE	'\r'
-#define _G_STR_PROCESS	" \n"
-#define _G_STR_COMPSLIT	"\"'"
-#define _G_ENT_PROCESS	'\n'
-#endif
-
-/* Escape Sequence Buffer Length */
-#define ESCSEQ_BUFLEN	8
-
-/* String-Functions for strings stored in flash memory */
-#ifdef AVR
-	#define _G_STRNLEN(key,length)		strnlen_PF((__uint24)(key),length)
-	#define _G_STRNCMP(str,key,length)	strncmp_PF(str,(__uint24)(key),length)
-#else
-	#define _G_STRNLEN(key,length)		strnlen(key,length)
-	#define _G_STRNCMP(str,key,length)	strncmp(str,key,length)
-#endif
-
-#define _G_MAXCMD	127	// Maximum of 127 commands allowed!
-
-/* Internal Variable Structure */
-static struct {
-	void (*fp_putChar)(char);			/**< Functionspointer to send a char */
-	uint32_t (*fp_msTimeStamp)(void);	/**< Functionspointer to get the milliseconds tick */
-	uint8_t chain_len;					/**< length of the command struct chain */
-	gshell_cmd_t *lastChain;			/**< Dynamic Command Chain, pointer to the last registered command */
-	uint8_t rx_index;					/**< Receive Buffer Index */
-	char rx_buf[G_RX_BUFSIZE];			/**< Receive Buffer, G_RX_BUFSIZE Bytes */
-	char vsprintf_buf[G_RX_BUFSIZE];	/**< vsprintf buffer used in gshell_printf and glog functions */
-	uint8_t isActive:1;					/**< Enable the whole shell, including any basic printing or reading */
-	uint8_t promtEnabled:1;				/**< Enable the shell promt, controls input processing by the user */
-	uint8_t helpCmdDescLength;			/**< Optimizing of the help function for faster yet nicer screen output */
-	uint8_t helpCmdNameLength;			/**< Optimizing of the help function for faster yet nicer screen output */
-#ifdef AVR
-	char tempBuf[G_RX_BUFSIZE];
-#endif
-} sInternals = {0};
-
-
-/* Internal 'help' command, to list all other commands
- * It is also the head/first element of the command list */
-static uint8_t gshell_cmd_help(uint8_t argc, char *argv[]);
-static gshell_cmd_t cmd_help = {
-	G_XARR("help"),
-	gshell_cmd_help,
-	G_XARR(_G_HLPDESC),
-	NULL
-};
-
-/* Logging Texts with additonal formatting, stored in the program flash */
-static const _GMEMX char * const _GMEMX console_levels[6] =
-{
-	G_XARR("[      ] "),																/**< GLOG_NORMAL */
-	G_XARR("["G_TEXTBOLD" INFO "G_TEXTNORMAL"] "),										/**< GLOG_INFO */
-	G_XARR("["G_TEXTBOLD G_COLORGREEN"  OK  "G_COLORRESET G_TEXTNORMAL"] "),			/**< GLOG_OK */
-	G_XARR("["G_TEXTBOLD G_COLORYELLOW" WARN "G_COLORRESET G_TEXTNORMAL"] "),			/**< GLOG_WARN */
-	G_XARR("["G_TEXTBOLD G_COLORRED"ERROR!"G_COLORRESET G_TEXTNORMAL"] "),				/**< GLOG_ERROR */
-	G_XARR("["G_TEXTBOLD G_TEXTBLINK G_COLORRED"PANIC!"G_COLORRESET G_TEXTNORMAL"] ")	/**< GLOG_FATAL */
-};
-
-/* Echoes back to the terminal / serial port
- * Filters out certain special characters
- * Can be disabled via the define G_ENABLE_ECHO */
-static void _gshell_echo(char c)
-{
-#ifdef G_ENABLE_ECHO
-
-	if (C_NEWLINE == c) // Echoing newline?
-	{
-		// Add carriage return to newline
-		gshell_putChar(C_CARRET);
-		gshell_putChar(C_NEWLINE);
-	}
-	else if ((c == C_BACKSPCE1) || (c == C_BACKSPCE2)) // Echoing backspace?
-	{
-		// remove previous character on screen
-		gshell_putChar(C_BACKSPCE1);
-		gshell_putChar(C_WITESPCE);
-		gshell_putChar(C_BACKSPCE1);
-	}
-	else
-	{
-		gshell_putChar(c);
-	}
-#else
-	// Supress compiler warning
-	(void)(c);
-#endif
-}
-
-/* Find the right gshell_cmd_t command structure, which name
- * matches the name passed over to this function. Also returns the ID
- * of said command if found!
- *
- * If no command has been found, it returns a null-pointer and pi8CmdID with -1 */
-static const gshell_cmd_t *_gshellFindCmd(const char *name, int8_t *pi8CmdID)
-{
-	const gshell_cmd_t *command;
-	uint8_t u8_cnt;
-	
-	/* First check the linked chain
-	 * The first entry in the chain are always the internal commands, the
-	 * last entry being sInternals.lastChain. With that the chain can be
-	 * quicklychecked.
-	*/
-	for (u8_cnt = 0; u8_cnt < sInternals.chain_len; u8_cnt++)
-	{
-		// First entry always is cmd_help, from there follow the chain
-		if (u8_cnt)
-		{
-			command = command->next;
-		}
-		else
-		{
-			command = &cmd_help;
-		}
-		// Check if 'name' matches the command struct's name
-		if (_G_STRNCMP(name, command->cmdName, G_RX_BUFSIZE) == 0)
-		{
-			*pi8CmdID = u8_cnt;	// Command-ID
-			return command;		// Pointer to Command Structure
-		}
-	}
-
-	*pi8CmdID = u8_cnt;
-#ifdef ENABLE_STATIC_COMMANDS
-	/* Then check the command list */
-	for (u8_cnt = 0; u8_cnt < gshell_list_num_commands; u8_cnt++)
-	{
-		command = &gshell_list_commands[u8_cnt];
-		// Similar as before, search the name in the command struct list
-		// and return it's ID and pointer when found
-		if (_G_STRNCMP(name, command->cmdName, G_RX_BUFSIZE) == 0)
-		{
-			*pi8CmdCnt += u8_cnt;
-			return command;
-		}
-	}
-#endif 
-
-	/* None of the commands matched? Return a NULL-pointer and
-	 * the invalid command ID '-1'! */
-	*pi8CmdID = -1;
-	return NULL;
-}
-
-/* Checks if a character contains any character inside the string.
- * If yes, it returns that, otherwise it returns zero */
-static char _gshell_CharCmpStr(const char cInput, const char *strCheck)
-{
-	while(*strCheck != '\0')
-	{
-		if (cInput != *strCheck)
-		{
-			strCheck++;
-		}
-		else
-		{
-			return *strCheck;
-		}
-	}
-	return 0;
-}
-
-/* strtok replacement to support additional, special arguments
- *
- * In order to support string splitting with " or ' characters, a
- * extended strtok function has been coded. It behaves similarly as the
- * original function from string.h, but takes an additional string parameter.
- *
- * Otherwise arguments and return pointers are the same and it should
- * behave the same too.
- */
-static char *_gshell_strtok(char *strInput, const char *delim, const char *special)
-{
-	static char *strProcess = NULL;	// Process string pointer
-	char *strStart = NULL;			// Start pointer of a string to split
-	static uint8_t bSpecialMode = 0;// Special Mode, enabled if a special character has been found
-
-	// New string passed over?
-	if (strInput != NULL)
-	{
-		strProcess = strInput;
-		bSpecialMode = 0;
-	}
-
-	// Process-String-Pointer empty?
-	if ((strProcess == NULL) || (*strProcess == '\0'))
-	{
-		return NULL;
-	}
-
-	// Work loop where the string is splitted
-	do
-	{
-		// Set the starting pointer to a valid character (non-delim or special)
-		if (strStart == NULL)
-		{
-			// Check if a normal split operation is detected
-			if ((bSpecialMode == 0) && _gshell_CharCmpStr(*strProcess, delim))
-			{
-				*strProcess = '\0';
-			}
-			// Check if a special split operation is detected
-			else if (_gshell_CharCmpStr(*strProcess, special))
-			{
-				*strProcess = '\0';
-
-				if (bSpecialMode)
-				{
-					bSpecialMode = 0;
-				}
-				else
-				{
-					bSpecialMode = 1;
-				}
-			}
-			else
-			{
-				// None of the other two? Character to set the start pointer on found!
-				strStart = strProcess;
-			}
-		}
-		else
-		{
-			// Check if a normal split operation is detected
-			if ((bSpecialMode == 0) && _gshell_CharCmpStr(*strProcess, delim))
-			{
-				*strProcess = '\0';
-				strProcess++;
-
-				return strStart;
-			}
-			// Check if a special split operation is detected
-			else if (_gshell_CharCmpStr(*strProcess, special))
-			{
-				*strProcess = '\0';
-				strProcess++;
-
-				if (bSpecialMode)
-				{
-					bSpecialMode = 0;
-				}
-				else
-				{
-					bSpecialMode = 1;
-				}
-				return strStart;
-			}
-		}
-	}
-	while(*++strProcess != '\0');
-	// Finish if the work-string-pointer reaches the end
-	// and return the last start pointer
-	return strStart;
-}
-
-/* Processes the complete string, inputted by the user
- * Splits the string by spaces and searches for a matching command,
- * before calling it and passing over the arguments in a standard-c-style fashion.
- * If the command returns a value, it too is processed and returned back
- * for the user to handle the command's return value.
- *
- * Lower 8-bits is the enum 'gshell_return', upper 8-bits for the command return value. */
-static int16_t _gshell_process()
-{
-	enum gshell_return eGshellPrc = GSHELL_OK;	// Function Status uppon exit
-	uint8_t argc = 0;			// Classic C-Style argc to fill in
-	char *argv[G_MAX_ARGS];		// Classic C-Style argv to fill in
-	uint16_t u8CmdRet = 0;		// Return Value of the command
-	int8_t i8CmdID = 0;			// ID of the command
-
-	// No newline, no command to process!
-	if (sInternals.rx_buf[sInternals.rx_index - 1] != _G_ENT_PROCESS)
-	{
-		return GSHELL_OK;
-	}
-
-	// Split by spaces into seperate strings, store the pointers in argv (command + arguments)
-	// and increase argc
-#ifdef G_ENABLE_SPECIALCMDSTR
-	// Pay attention to special characters like " or ' and split accordingly
-	char *pch = _gshell_strtok(sInternals.rx_buf, _G_STR_PROCESS, _G_STR_COMPSLIT);
-	while (pch != NULL)
-	{
-		if (argc < G_MAX_ARGS)
-		{
-			argv[argc++] = pch;
-			pch = _gshell_strtok(NULL, _G_STR_PROCESS, _G_STR_COMPSLIT);
-		}
-		else
-		{
-			break;
-		}
-	}
-#else
-	char *pch = strtok(sInternals.rx_buf, _G_STR_PROCESS);
-    while (pch != NULL)
-	{
-		if (argc < G_MAX_ARGS)
-		{
-			argv[argc++] = pch;
-			pch = strtok(NULL, _G_STR_PROCESS);
-		}
-		else
-		{
-			break;
-		}
-	}
-#endif
-
-	// Just making sure we have actually found *any* argument
-	if (argc >= 1)
-	{
-		// Actual text has been received! Time to find the fitting command to it, else
-		// print the error
-		const gshell_cmd_t *command = _gshellFindCmd(argv[0], &i8CmdID);
-		if (!command)
-		{
-			// command not found, return error
-			gshell_putString(_G_UNKCMD);
-			gshell_putStringRAM(argv[0]);
-			gshell_putString(_G_HLPCMD);
-			eGshellPrc = GSHELL_CMDINV;
-		}
-		else
-		{
-			// Command found, calling the function pointer with the command line arguments
-			if (command->handler != NULL)
-			{
-				u8CmdRet = command->handler(argc, argv);
-			}
-		}
-	}
-	else
-	{
-		// User probably just spammed the enter key
-		gshell_putString(_G_HLPCMD);
-		eGshellPrc = GSHELL_RUBBISH;
-	}
-
-	/* Resetting the input buffer */
-	memset(sInternals.rx_buf, 0, G_RX_BUFSIZE);
-	sInternals.rx_index = 0;
-
-	// If the shell promt is enabled, reprint it (showing the user that we're ready
-	// for new commands)
-	if (sInternals.promtEnabled)
-	{
-		gshell_putString(_G_PROMT);
-	}
-
-	// If the called command returned a value, return it on the upper half of the word,
-	// and the command's ID on the lower half.
-	if (u8CmdRet)
-	{
-		return (u8CmdRet << 8) | (GSHELL_CMDRET | i8CmdID);
-	}
-	else
-	{
-		return eGshellPrc;
-	}
-}
-
-int8_t gshell_init(void (*put_char)(char), uint32_t (*get_msTimeStamp)(void))
-{
-	// Storing function pointers in the internal variable structure
-	sInternals.fp_putChar = put_char;
-	sInternals.fp_msTimeStamp = get_msTimeStamp;
-
-	// Terminal turned on by default, prompt turned off by default
-	sInternals.isActive = 1;
-	sInternals.promtEnabled = 0;
-	
-#ifdef ENABLE_STATIC_COMMANDS
-	// Make sure not too many static commands have been added
-	if (gshell_list_num_commands == _G_MAXCMD)
-	{
-
-	}
-	else if (gshell_list_num_commands > _G_MAXCMD)
-	{
-		return -1;
-	}
-	else
-	{
-		gshell_register_cmd(&cmd_help);
-	}
-#else
-	// Register the default help command
-	gshell_register_cmd(&cmd_help);
-#endif
-	
-	// Resetting Input Buffer
-	memset(sInternals.rx_buf, 0, G_RX_BUFSIZE);
-
-	// New lines for good measure
-	gshell_putString(G_CRLF G_CRLF);
-
-	return 0;
-}
-
-int8_t gshell_register_cmd(gshell_cmd_t *cmd)
-{
-	// Check if max. amount of commands already have been reached
-	uint8_t u8CheckCmdCnt = sInternals.chain_len;
-#ifdef ENABLE_STATIC_COMMANDS
-	u8CheckCmdCnt += gshell_list_num_commands;
-#endif
-	if (u8CheckCmdCnt >= _G_MAXCMD)
-	{
-		return -1;
-	}
-
-	// Check if the lastChain variable as been assigned -> set it in as first entry!
-	if (sInternals.lastChain == NULL)
-	{
-		sInternals.lastChain = cmd;
-		sInternals.chain_len++;
-	}
-	else
-	{
-		// If not, rebuild and extend the command chain, and increase the chain length counter
-		sInternals.lastChain->next = cmd;
-		sInternals.lastChain = cmd;
-		sInternals.chain_len++;
-	}
-
-	// Help function needs to rebuild the "spaces" length for nice formatting
-	sInternals.helpCmdDescLength = 0;
-	sInternals.helpCmdNameLength = 0;
-
-	// Return the length of the command chain
-	return sInternals.chain_len - 1;
-}
-
-// Returns the command ID from the string, returns -1 if it hasn't been found
-int8_t gshell_getCmdIDbyName(const char* cmd_name)
-{
-	int8_t cmdID = 0;
-	_gshellFindCmd(cmd_name, &cmdID);
-	return cmdID;
-}
-
-// Returns the command ID from the command structure pointer, returns -1 if it hasn't been found
-int8_t gshell_getCmdIDbyStruct(gshell_cmd_t *cmd)
-{
-	int8_t cmdID;
-	uint8_t u8_cnt;
-	const gshell_cmd_t *command;
-
-	// Similar as _gshellFindCmd, but comparing the pointer addresses instead of the
-	// command's name
-	for (u8_cnt = 0; u8_cnt < sInternals.chain_len; u8_cnt++)
-	{
-		/* First entry always is cmd_help, from there follow the chain */
-		if (u8_cnt)
-		{
-			command = command->next;
-		}
-		else
-		{
-			command = &cmd_help;
-		}
-
-		if (command == cmd)	// Just compare the pointer addresses against eachother
-		{
-			return (int8_t)u8_cnt;
-		}
-	}
-
-	cmdID = u8_cnt;
-#ifdef ENABLE_STATIC_COMMANDS
-	/* Then check the command list */
-	for (u8_cnt = 0; u8_cnt < gshell_list_num_commands; u8_cnt++)
-	{
-		command = &gshell_list_commands[u8_cnt];
-		if (command == cmd)	// Just compare the pointer addresses against eachother
-		{
-			return (int8_t)(u8_cnt + cmdID);
-		}
-	}
-#else
-	// Supress compiler warning
-	(void)(cmdID);
-#endif
-
-	// If no ID has been returned by now, return -1
-	return -1;
-}
-
-void gshell_setActive(uint8_t activeStatus)
-{
-	// Set active means all activities are enabled...
-	if (activeStatus)
-	{
-		sInternals.isActive = 1;
-	}
-	else
-	{
-		//... or halted if disabled! No printing of any functions, input is ignored
-		sInternals.isActive = 0;
-	}
-}
-
-void gshell_setPromt(uint8_t promtStatus)
-{
-	if (promtStatus)
-	{
-		// Enabling the prompt? Check if it has already been enabled...
-		if (sInternals.promtEnabled == 0)
-		{
-			// .. if no, print the prompt and enable it internally
-			sInternals.promtEnabled = 1;
-			gshell_putString(_G_PROMT);
-		}
-	}
-	else
-	{
-		// If the promt was enabled before, erase it from the terminal screen
-		if (sInternals.promtEnabled)
-		{
-			gshell_putString(G_CLEARLINE);
-			gshell_putChar('\r');
-		}
-		sInternals.promtEnabled = 0;
-	}
-}
-
-/*** WIP WIP WIP - Do not enable G_ENABLE_INESCAPES - WIP WIP WIP ***/
-/**
- * @brief Enables incoming Escape-Sequence Processing
- */
-//#define G_ENABLE_INESCAPES
-
-uint16_t gshell_processShell(char c)
-{
-#ifdef G_ENABLE_INESCAPES
-	static uint8_t u8EscapeSequenceCnt = 0;
-	static char cEscapeSequenceBuf[ESCSEQ_BUFLEN];
-	int32_t i32EscapeSequenceValue= 0;
-#endif
-
-	// Main function to process each incoming character!
-	// CR/LF or \0 is ignored
-	if ((c == _G_ENT_IGNORE) || (c == '\0'))
-	{
-		return GSHELL_OK;
-	}
-	else if ((sInternals.isActive == 0) || (sInternals.promtEnabled == 0))
-	{
-		// If the shell isn't even set active, avoid any further processing!
-		return GSHELL_INACTIVE;
-	}
-
-#ifdef G_ENABLE_INESCAPES
-	/* ANSI Escape Sequence check & processing */
-	if ((u8EscapeSequenceCnt) || (c == 0x1B))
-	{
-		if (u8EscapeSequenceCnt)
-		{
-			if ((u8EscapeSequenceCnt == 1) && (c == '['))
-			{
-				u8EscapeSequenceCnt = 2;
-			}
-			else
-			{
-				// Letter, number or something else received?
-				if (((c >=0x41) && (c <= 0x5A)) || ((c >= 0x61) && (c <= 0x7A)))
-				{
-					// Letter received! Finish sequence handling
-					// and process it.
-
-				}
-				else if ((c >= 0x30) && (c <= 0x39))
-				{
-					// Number received!
-
-				}
-				else
-				{
-					// Something else received!
-				}
-			}
-		}
-		else
-		{
-			u8EscapeSequenceCnt = 1;
-		}
-
-		return GSHELL_OK;
-	}
-#endif
-
-	/* Backspace handling */
-	if ((c == C_BACKSPCE1) || (c == C_BACKSPCE2))
-	{
-		// Interpreting backspace, removing the character from the input buffer
-		// and removing it also from the user's screen!
-
-		if (sInternals.rx_index > 0)
-		{
-			sInternals.rx_buf[--sInternals.rx_index] = C_NULLCHAR;
-			_gshell_echo(c);
-		}
-		return GSHELL_OK;
-	}
-	else if (sInternals.rx_index >= G_RX_BUFSIZE)
-	{
-		// Input buffer full? Stop processing and inform the user!
-		return GSHELL_BUFFULL;
-	}
-
-	// Echo the (valid) character back to the terminal/user
-#ifdef G_CR_INSTEADOF_LF
-	// Some terminals send a CR instead of LF, handle things here-
-	if (c == _G_ENT_PROCESS)
-	{
-		_gshell_echo(_G_ENT_IGNORE);
-	}
-	else
-	{
-		_gshell_echo(c);
-	}
-#else
-	_gshell_echo(c);
-#endif
-
-	// Storing the received character, increading index
-	sInternals.rx_buf[sInternals.rx_index++] = c;
-
-	// Call the main processing function, return it's return-value
-	return _gshell_process();
-}
-
-void gshell_putChar(char c)
-{
-	// If shell is not inactive, print character
-	if (sInternals.isActive == 0)	return;
-	sInternals.fp_putChar(c);
-}
-
-void gshell_putStringRAM(const char *str)
-{
-	// If shell is not inactive, print string
-	if (sInternals.isActive == 0)	return;
-	while (*str)
-	{
-		gshell_putChar(*str++);
-	}
-}
-
-void gshell_putString_flash(const _GMEMX char *progmem_s)
-{
-	char character;
-
-	// If shell is not inactive, print string from program memory
-	if (sInternals.isActive == 0)	return;
-
-	while ( (character = *progmem_s++) )
-	{
-		gshell_putChar(character);
-	}
-}
-
-void gshell_printf_flash(const _GMEMX char *progmem_s, ...)
-{
-	va_list args;
-	// If shell is not inactive, return directly back
-	if (sInternals.isActive == 0)	return;
-	
-	// Printf with the main string stored in the program memory! First get the argument list
-	va_start(args, progmem_s);
-#ifdef AVR
-	// Copy the program-memory string into the SRAM memory, store it in the
-	// additional vsprintf buffer for further processing
-	// Handle printf-processing via vsprintf
-	strncpy_PF(sInternals.tempBuf, (__uint24)progmem_s, G_RX_BUFSIZE);
-	vsprintf(sInternals.vsprintf_buf, sInternals.tempBuf, args);
-#else
-	// Handle printf-processing via vsprintf
-	vsprintf(sInternals.vsprintf_buf, progmem_s, args);
-#endif
-	va_end(args);
-	
-	// Print the result of vsprintf back to the user
-	gshell_putStringRAM(sInternals.vsprintf_buf);
-}
-
-void gshell_log_flash(enum glog_level loglvl, const _GMEMX char *logText, ...)
-{
-	va_list args;
-	uint32_t timestamp = 0;
-
-	// Shell not set active? Abort further processing!
-	if (sInternals.isActive == 0)	return;
-
-	// If the promt is enabled, it is likely also printed out -> erase it (and anything typed by the user)
-	if (sInternals.promtEnabled)
-	{
-		gshell_putStringRAM(G_CLEARLINE);
-		gshell_putChar(C_CARRET);
-	}
-	
-	// Print the logging level
-	gshell_putString_flash(console_levels[loglvl]);
-	
-	// If a timestamp function pointer has been given, call it to get the ms-Tick
-	if (sInternals.fp_msTimeStamp != NULL)
-	{
-		// Print the msTick / Timestamp
-		timestamp = sInternals.fp_msTimeStamp();
-		gshell_printf_flash(G_XSTR("[%09u] "), timestamp);
-	}
-
-	// Similar "printf / vsprintf" processing as in gshell_printf_flash
-#ifdef AVR
-	strncpy_PF(sInternals.tempBuf, (__uint24)logText, G_RX_BUFSIZE);
-	va_start(args, logText);
-	vsprintf(sInternals.vsprintf_buf, sInternals.tempBuf, args);
-    va_end(args);
-#else
-	va_start(args, logText);
-	vsprintf(sInternals.vsprintf_buf, logText, args);
-	va_end(args);
-#endif
-
-	// Print the result from vsprintf
-	gshell_putStringRAM(sInternals.vsprintf_buf);
-
-	if (sInternals.promtEnabled)
-	{
-		// If the promt was enabled before, reprint not only
-		// the prompt itself, but also what the user has typed in!
-		// Thus, restoring any command / typing flow of the user despite random logging
-		gshell_putString(_G_PROMT);
-		gshell_putStringRAM(sInternals.rx_buf);
-	}
-	else
-	{
-		gshell_putString(G_CRLF);
-	}
-}
-
-/*****************************************************************************/
-/*****************   DEFAULT COMMANDS INCLUDED WITH GSHELL *******************/
-/*****************************************************************************/
-static uint8_t gshell_cmd_help(uint8_t argc, char *argv[])
-{
-	const gshell_cmd_t *command;
-
-	uint8_t longestCommand = sInternals.helpCmdNameLength;
-	uint8_t longestDescription = sInternals.helpCmdDescLength;
-	uint8_t tempLen = 0;
-	uint8_t u8_cnt;
-
-	// Supress 'unused parameter' warning:
-	(void)(argc);
-	(void)(argv);
-
-	// If we haven't found the longest command and description yet, find it
-	if ((longestCommand == 0) || (longestDescription == 0))
-	{
-		// Loop through every dynamic command!
-		for (u8_cnt = 0; u8_cnt < sInternals.chain_len; u8_cnt++)
-		{
-			if (u8_cnt)
-			{
-				command = command->next;
-			}
-			else
-			{
-				command = &cmd_help;
-			}
-
-			// Get the length of the command name and description!
-			//
-			tempLen = _G_STRNLEN(command->cmdName, G_RX_BUFSIZE);
-			if (tempLen > longestCommand)	longestCommand = tempLen;
-
-			tempLen = _G_STRNLEN(command->desc, G_RX_BUFSIZE);
-			if (tempLen > longestDescription)	longestDescription = tempLen;
-
-		}
-#ifdef ENABLE_STATIC_COMMANDS
-		for (u8_cnt = 0; u8_cnt < gshell_list_num_commands; u8_cnt++)
-		{
-			command = &gshell_list_commands[u8_cnt];
-			tempLen = _G_STRNLEN(command->cmdName, G_RX_BUFSIZE);
-			if (tempLen > longestCommand)	longestCommand = tempLen;
-
-			tempLen = _G_STRNLEN(command->desc, G_RX_BUFSIZE);
-			if (tempLen > longestDescription)	longestDescription = tempLen;
-		}
-#endif
-		sInternals.helpCmdDescLength = longestDescription;
-		sInternals.helpCmdNameLength = longestCommand;
-	}
-
-	// Print the command, followed by some spacing, and finally the description
-	// The amount of "spaces" between the command name and description is
-	// based on the longest command name.
-	for (u8_cnt = 0; u8_cnt < sInternals.chain_len; u8_cnt++)
-	{
-		// If u8Cnt is zero, start with the help command, otherwise with the dynamic command chain
-		if (u8_cnt)
-		{
-			command = command->next;
-		}
-		else
-		{
-			command = &cmd_help;
-		}
-
-		// Some boundary checks in order to print long descriptions nicely:
-		if (2+longestDescription+longestCommand >= G_RX_BUFSIZE)
-		{
-			gshell_putString("\r"G_TEXTBOLD);
-			gshell_putString_flash(command->cmdName);
-			gshell_putString(G_TEXTNORMAL":"G_CRLF"     ");
-			gshell_putString_flash(command->desc);
-			gshell_putString(G_CRLF);
-		}
-		else
-		{
-			// Command name + description not too large?
-			// Print the spaces, then the description, then use
-			// CR to return back to the start to print the command name
-			// Go to the next line (LF) and repeat as long a there are commands
-			for (uint8_t j = 0; j < (longestCommand+2); j++)
-			{
-				gshell_putChar(' ');
-			}
-			gshell_putString_flash(command->desc);
-			gshell_putString("\r"G_TEXTBOLD);
-			gshell_putString_flash(command->cmdName);
-			gshell_putString(G_TEXTNORMAL":"G_CRLF);
-		}
-	}
-#ifdef ENABLE_STATIC_COMMANDS
-	// Same as with the dynamic commands above!
-	for (u8_cnt = 0; u8_cnt < gshell_list_num_commands; u8_cnt++)
-	{
-		command = &gshell_list_commands[u8_cnt];
-		if (2+longestDescription+longestCommand >= G_RX_BUFSIZE)
-		{
-			gshell_putString("\r"G_TEXTBOLD);
-			gshell_putString_flash(command->cmdName);
-			gshell_putString(G_TEXTNORMAL":"G_CRLF"     ");
-			gshell_putString_flash(command->desc);
-			gshell_putString(G_CRLF);
-		}
-		else
-		{
-			for (uint8_t j = 0; j < (longestCommand+2); j++)
-			{
-				gshell_putChar(' ');
-			}
-			gshell_putString_flash(command->desc);
-			gshell_putString("\r"G_TEXTBOLD);
-			gshell_putString_flash(command->cmdName);
-			gshell_putString(G_TEXTNORMAL":"G_CRLF);
-		}
-	}
-#endif
-	return 0;
-}
+/**
+ * @file gshell.c
+ * @brief gshell C file
+ * @author gfcwfzkm
+ * @version 2.3
+ */
+
+#include "gshell.h"
+
+#ifdef G_ENABLE_SIMDSCAN
+	#if defined(__AVX2__)
+		#include <immintrin.h>
+	#elif defined(__SSE2__)
+		#include <emmintrin.h>
+	#elif defined(__ARM_NEON)
+		#include <arm_neon.h>
+	#endif
+#endif
+
+#if defined(G_ENABLE_TRACE) && defined(AVR)
+	#include <avr/interrupt.h>
+#endif
+
+/* Strings used by the library are defined here */
+#define _G_UNKCMD	"Unknown command: "
+#define _G_HLPCMD	G_CRLF"Type 'help' to list all available commands"G_CRLF
+#define _G_HLPDESC	"Lists all available commands"
+#define _G_USAGE	"Usage: "
+#define _G_ARGINV	"Invalid argument: "
+#define _G_ARGMISS	"Missing argument: "
+#define _G_ARGMANY	"Too many arguments"
+#define _G_DMESGDESC	"Prints the log history [-l <level>] [-s <since ms>] [-c]"
+#define _G_TRACEDESC	"Trace events: 'trace dump' prints Chrome trace JSON, 'trace clear'"
+#define _G_LOGSITEDESC	"Log call sites: 'logsite list|enable|disable [<file>[:line]]'"
+#define _G_WATCHDESC	"Runs a command periodically [-n <ms>] [-c] <cmd ...>, any key stops"
+#define _G_REPEATDESC	"Runs a command N times <N> [-n <ms>] <cmd ...>, any key stops"
+#define _G_PROMT			G_TEXTBOLD"gshell> "G_TEXTNORMAL
+#define _G_PROMT_PLAIN		"gshell> "
+#define _G_DAQUERY			G_ESCAPE"c"
+
+/* For weird terminals that send \r instead of \n at enter-keypresses */
+#ifdef G_CR_INSTEADOF_LF
+#define _G_ENT_IGNORE	'\n'
+#define _G_STR_PROCESS	" \r"
+#define _G_STR_COMPSLIT	"\"'"
+#define _G_ENT_PROCESS	'\r'
+#else
+#define _G_ENT_IGNORE	'\r'
+#define _G_STR_PROCESS	" \n"
+#define _G_STR_COMPSLIT	"\"'"
+#define _G_ENT_PROCESS	'\n'
+#endif
+
+/* Log records are formatted even if the terminal is inactive, if someone else stores them */
+#if defined(G_ENABLE_LOGSINKS) || defined(G_ENABLE_LOGHISTORY)
+#define _G_LOG_ALWAYS
+#endif
+
+/* Bytes per line of gshell_hexdump: address, hex bytes, ASCII column, CR LF and terminator */
+#define _G_HEXDUMP_BYTES	16
+#define _G_HEXDUMP_LINELEN	(11 + _G_HEXDUMP_BYTES * 4 + 3)
+
+/* Escape Sequence Buffer Length */
+#define ESCSEQ_BUFLEN	_G_ESCSEQ_BUFLEN
+
+#ifdef G_ENABLE_TXQUEUES
+#if (G_TXQUEUE_SIZE & (G_TXQUEUE_SIZE - 1)) != 0
+	#error "G_TXQUEUE_SIZE has to be a power of two"
+#endif
+/* Output queues, the highest one is sent first */
+#define _G_TXQ_OUT		0	// Command output, echo and promt
+#define _G_TXQ_LOG		1	// Log messages below GLOG_ERROR
+#define _G_TXQ_CRIT		2	// Error and fatal log messages
+#define _G_TXQ_COUNT	3
+
+/* Final output stage of the selected session */
+#define _G_OUT(c)		_gshell_txPut(c)
+#else
+#define _G_OUT(c)		_G_SES.fp_putChar(c)
+#endif
+
+/* Selected terminal session, always the one set up by gshell_init if sessions are disabled */
+#ifdef G_ENABLE_SESSIONS
+#define _G_SES		(*sThread.session)
+#else
+#define _G_SES		(sInternals.mainSession)
+#endif
+
+/* String-Functions for strings stored in flash memory */
+#ifdef AVR
+	#define _G_STRNLEN(key,length)		strnlen_PF((__uint24)(key),length)
+	#define _G_STRNCMP(str,key,length)	strncmp_PF(str,(__uint24)(key),length)
+#else
+	#define _G_STRNLEN(key,length)		strnlen(key,length)
+	#define _G_STRNCMP(str,key,length)	strncmp(str,key,length)
+#endif
+
+#define _G_MAXCMD	0x7FFF	// Maximum of 32767 commands allowed (16-bit command IDs)!
+
+/* Internal Variable Structure */
+static struct {
+	uint32_t (*fp_msTimeStamp)(void);	/**< Functionspointer to get the milliseconds tick */
+#ifdef G_ENABLE_LOGSINKS
+	gshell_sink_t *sinks;				/**< Registered log sinks */
+	uint8_t consoleLevel;				/**< Lowest logging level printed on the terminal */
+#endif
+	uint16_t chain_len;					/**< length of the command struct chain */
+	uint16_t cmd_count;					/**< amount of registered commands, subcommands included */
+	gshell_cmd_t *lastChain;			/**< Dynamic Command Chain, pointer to the last registered command */
+	gshell_session_t mainSession;		/**< Terminal set up by gshell_init */
+	uint8_t helpCmdDescLength;			/**< Optimizing of the help function for faster yet nicer screen output */
+	uint8_t helpCmdNameLength;			/**< Optimizing of the help function for faster yet nicer screen output */
+#ifdef G_ENABLE_WORKERS
+	/** Takes over commands marked as blocking, non-zero if it did */
+	uint8_t (*fp_dispatch)(const gshell_cmd_t *cmd, int16_t cmdID, uint8_t argc, char *argv[]);
+	void (*fp_lock)(uint8_t acquire);	/**< Serializes the log sinks and history between threads */
+#endif
+	void (*fp_wakeup)(void);			/**< Called once work becomes pending, possibly within an interrupt */
+} sInternals = {0};
+
+/* State of the executing command / log call, one per thread if worker threads are enabled */
+#ifdef G_ENABLE_WORKERS
+	#ifndef G_ENABLE_SESSIONS
+		#error "G_ENABLE_WORKERS requires G_ENABLE_SESSIONS"
+	#endif
+	#define _G_THREADLOCAL	_Thread_local
+#else
+	#define _G_THREADLOCAL
+#endif
+#if defined(G_ENABLE_ARGSCHEMA) && (G_MAX_ARGS > 32)
+	#error "G_ENABLE_ARGSCHEMA supports up to 32 arguments, argGivenMask holds one bit each"
+#endif
+static _G_THREADLOCAL struct {
+#ifdef G_ENABLE_SESSIONS
+	gshell_session_t *session;			/**< Selected terminal session */
+#endif
+	char vsprintf_buf[G_RX_BUFSIZE];	/**< vsprintf buffer used in gshell_printf and glog functions */
+#ifdef G_ENABLE_ARGSCHEMA
+	gshell_argval_t argValues[G_MAX_ARGS];	/**< Converted arguments of the running command */
+	uint32_t argGivenMask;				/**< Bit set for each schema entry given by the user */
+#endif
+#ifdef G_ENABLE_TXQUEUES
+	uint8_t txPrio;						/**< Output queue of the characters printed now */
+#endif
+#ifdef G_ENABLE_RESULTQUEUE
+	uint32_t resultValue;				/**< Value posted by the running command */
+	uint8_t resultPosted;				/**< gshell_setResult has been called by the running command */
+#endif
+#ifdef AVR
+	char tempBuf[G_RX_BUFSIZE];
+#endif
+} sThread = {
+#ifdef G_ENABLE_SESSIONS
+	.session = &sInternals.mainSession	// Usable (inactive) even before gshell_init
+#else
+	0
+#endif
+};
+
+#ifdef G_ENABLE_WORKERS
+static void _gshell_lock(uint8_t bAcquire);
+#endif
+
+
+#ifdef G_ENABLE_LOGHISTORY
+#define _G_HIST_MAGIC	0x474C4F47	// 'GLOG'
+#define _G_HIST_RECHDR	7			// Record header: length, level, 4 bytes timestamp, CRC
+
+/* Header of the log history. Two copies are written alternately, so a reset
+ * while publishing one leaves the other valid. The valid one with the higher
+ * sequence number is the current state */
+typedef struct {
+	uint32_t magic;					/**< _G_HIST_MAGIC if the history has been initialised */
+	uint32_t sequence;				/**< Incremented on each update */
+	uint16_t tail;					/**< Position of the oldest record */
+	uint16_t used;					/**< Amount of bytes used by the records */
+	uint16_t count;					/**< Amount of records */
+	uint8_t crc;					/**< CRC-8 of the fields above */
+} _g_histhdr_t;
+
+/* Log history ring buffer, not cleared during startup to survive a warm reset.
+ * Records: [text length][level][timestamp, 4 bytes LE][CRC-8 of the record][text] */
+static struct {
+	_g_histhdr_t hdr[2];			/**< Shadow headers */
+	uint8_t active;					/**< Index of the current header, recovered after a reset */
+	uint8_t buf[G_LOGHISTORY_SIZE];	/**< Ring buffer holding the records */
+} sHistory G_NOINIT;
+#endif
+
+#ifdef G_ENABLE_RXRING
+#if (G_RXRING_SIZE & (G_RXRING_SIZE - 1)) != 0
+	#error "G_RXRING_SIZE has to be a power of two"
+#endif
+
+/* Free-running ring indices, 8 bit wide where possible so they are read and written atomically on 8-bit cores */
+#if G_RXRING_SIZE <= 128
+typedef uint8_t _g_rxidx_t;
+#else
+typedef uint16_t _g_rxidx_t;
+#endif
+
+/* Receive ring, written by gshell_rxPush (producer) and read by gshell_poll (consumer) */
+static struct {
+	_g_rxidx_t head;					/**< Next index to write, only changed by the producer */
+	_g_rxidx_t tail;					/**< Next index to read, only changed by the consumer */
+	uint16_t overruns;					/**< Characters dropped as the ring was full */
+	uint16_t watermark;					/**< Fill level calling fp_watermark */
+	void (*fp_watermark)(uint16_t);		/**< High-watermark callback */
+	char buf[G_RXRING_SIZE];			/**< Received characters */
+} sRxRing;
+#endif
+
+#ifdef G_ENABLE_TRACE
+#if (G_TRACE_SIZE & (G_TRACE_SIZE - 1)) != 0
+	#error "G_TRACE_SIZE has to be a power of two"
+#endif
+
+/* Short critical section reserving a trace slot, events may be recorded within
+ * interrupts. AVR and Cortex-M0/M0+ have no lock-free 16-bit fetch-add (it would
+ * become a libatomic call), so the interrupts are masked instead */
+#if defined(AVR)
+	#define _G_TRACE_ENTER()	uint8_t u8Sreg = SREG; cli()
+	#define _G_TRACE_EXIT()		SREG = u8Sreg
+#elif defined(__ARM_ARCH_PROFILE) && (__ARM_ARCH_PROFILE == 'M')
+	#define _G_TRACE_ENTER()	uint32_t u32Primask; __asm volatile ("mrs %0, primask\n\tcpsid i" : "=r" (u32Primask) :: "memory")
+	#define _G_TRACE_EXIT()		__asm volatile ("msr primask, %0" :: "r" (u32Primask) : "memory")
+#endif
+
+/* Trace event ring, the oldest events are overwritten */
+static struct {
+	uint32_t (*fp_getTick)(void);		/**< Clock of the events */
+	uint32_t ticksPerSecond;			/**< Frequency of fp_getTick */
+	uint16_t head;						/**< Index of the next event, not masked */
+	uint8_t wrapped;					/**< Ring has been filled at least once */
+	uint8_t paused;						/**< No recording while the events are printed */
+	struct {
+		const _GMEMX char *name;		/**< Event name, NULL at the end of a span */
+		uint32_t tick;					/**< Clock tick of the event */
+		uint8_t type;					/**< enum gshell_tracetype */
+		uint8_t ctx;					/**< Context ID */
+	} events[G_TRACE_SIZE];
+} sTrace;
+#endif
+
+#ifdef G_ENABLE_WATCH
+/* Command run by 'watch' / 'repeat', resolved and split into arguments once */
+static struct {
+	const gshell_cmd_t *command;		/**< Cached (sub)command, NULL while nothing is watched */
+	gshell_session_t *session;			/**< Session the command was entered on, gets the output */
+	uint32_t interval;					/**< Milliseconds between two runs */
+	uint32_t lastRun;					/**< Timestamp of the last run */
+	uint16_t remaining;					/**< Runs left, 0 for endless */
+	uint16_t argsLen;					/**< Amount of bytes used in args */
+	int16_t cmdID;						/**< ID of the cached command */
+	uint8_t argc;						/**< Amount of cached arguments */
+	uint8_t clear;						/**< Redraw from the top of the screen instead of scrolling */
+	char *argv[G_MAX_ARGS];				/**< Arguments, pointing into work */
+	uint8_t argl[G_MAX_ARGS];			/**< Length of each argument */
+	char args[G_RX_BUFSIZE];			/**< Arguments as entered */
+	char work[G_RX_BUFSIZE];			/**< Copy of args for each run, the command may modify it */
+} sWatch;
+#endif
+
+#ifdef G_ENABLE_RESULTQUEUE
+#if ((G_RESULTQUEUE_SIZE & (G_RESULTQUEUE_SIZE - 1)) != 0) || (G_RESULTQUEUE_SIZE > 128)
+	#error "G_RESULTQUEUE_SIZE has to be a power of two, 128 at most"
+#endif
+
+/* Completion queue, written after each command and read by gshell_popResult */
+static struct {
+	uint8_t head;						/**< Next index to write, not masked */
+	uint8_t tail;						/**< Next index to read, not masked */
+	uint16_t overruns;					/**< Records dropped as the queue was full */
+	gshell_resultrec_t rec[G_RESULTQUEUE_SIZE];	/**< Completion records */
+} sResults;
+#endif
+
+#ifdef G_ENABLE_TIMESTAMP64
+#define _G_TS64_SECDIGITS	5		// Seconds right-aligned to this width, like dmesg
+#define _G_TS64_FRACDIGITS	6		// Microseconds
+
+/* High-resolution time source of the log prefix, together with the prefix rendered last */
+static struct {
+	uint64_t (*fp_getTicks)(void);		/**< Time source, NULL to print the millisecond tick */
+	uint32_t ticksPerSecond;			/**< Frequency of fp_getTicks */
+	uint32_t seconds;					/**< Seconds rendered into prefix */
+	uint64_t lastTicks;					/**< Ticks of the previous log message, for the delta mode */
+	uint8_t mode;						/**< enum gshell_tsmode */
+	uint8_t fracPos;					/**< Position of the microseconds within prefix, 0 if prefix has to be rendered */
+	char prefix[24];					/**< "[+sssss.uuuuuu] " */
+} sTime;
+#endif
+
+/* Internal commands, the optional fields of gshell_cmd_t stay zero */
+#define _G_CMDINIT(n, fp, d)	{ .cmdName = G_XARR(n), .handler = (fp), .desc = G_XARR(d) }
+
+/* Internal 'help' command, to list all other commands
+ * It is also the head/first element of the command list */
+static uint8_t gshell_cmd_help(uint8_t argc, char *argv[]);
+#ifdef G_ENABLE_SUBCOMMANDS
+static void _gshell_helpSubCmds(const gshell_cmd_t *group);
+#endif
+#ifdef G_ENABLE_ARGSCHEMA
+static void _gshell_printUsage(const gshell_cmd_t *command);
+#endif
+static gshell_cmd_t cmd_help = _G_CMDINIT("help", gshell_cmd_help, _G_HLPDESC);
+
+#ifdef G_ENABLE_TRACE
+/* Internal 'trace' command, prints the trace events */
+static uint8_t gshell_cmd_trace(uint8_t argc, char *argv[]);
+static gshell_cmd_t cmd_trace = _G_CMDINIT("trace", gshell_cmd_trace, _G_TRACEDESC);
+#endif
+
+#ifdef G_ENABLE_LOGSITES
+/* Internal 'logsite' command, lists and switches log call sites */
+static uint8_t gshell_cmd_logsite(uint8_t argc, char *argv[]);
+static gshell_cmd_t cmd_logsite = _G_CMDINIT("logsite", gshell_cmd_logsite, _G_LOGSITEDESC);
+
+/* Bounds of the call-site section, set by the linker. Weak, as the section
+ * doesn't exist in a program without any log call */
+extern gshell_logsite_t __start_gshell_logsites[] __attribute__((weak));
+extern gshell_logsite_t __stop_gshell_logsites[] __attribute__((weak));
+#endif
+
+#ifdef G_ENABLE_WATCH
+/* Internal 'watch' and 'repeat' commands, run a command periodically / N times */
+static uint8_t gshell_cmd_watch(uint8_t argc, char *argv[]);
+static uint8_t gshell_cmd_repeat(uint8_t argc, char *argv[]);
+static gshell_cmd_t cmd_watch = _G_CMDINIT("watch", gshell_cmd_watch, _G_WATCHDESC);
+static gshell_cmd_t cmd_repeat = _G_CMDINIT("repeat", gshell_cmd_repeat, _G_REPEATDESC);
+#endif
+
+#ifdef G_ENABLE_LOGHISTORY
+/* Internal 'dmesg' command, prints the log history */
+static uint8_t gshell_cmd_dmesg(uint8_t argc, char *argv[]);
+static gshell_cmd_t cmd_dmesg = _G_CMDINIT("dmesg", gshell_cmd_dmesg, _G_DMESGDESC);
+#endif
+
+/* Logging Texts with additonal formatting, stored in the program flash */
+/* Digit tables of the fast number output, two decimal digits per entry */
+static const _GMEMX char dec_pairs[200] _PRGMX =
+	"0001020304050607080910111213141516171819"
+	"2021222324252627282930313233343536373839"
+	"4041424344454647484950515253545556575859"
+	"6061626364656667686970717273747576777879"
+	"8081828384858687888990919293949596979899";
+static const _GMEMX char hex_digits[16] _PRGMX = "0123456789ABCDEF";
+
+static const _GMEMX char * const _GMEMX console_levels[6] =
+{
+	G_XARR("[      ] "),																/**< GLOG_NORMAL */
+	G_XARR("["G_TEXTBOLD" INFO "G_TEXTNORMAL"] "),										/**< GLOG_INFO */
+	G_XARR("["G_TEXTBOLD G_COLORGREEN"  OK  "G_COLORRESET G_TEXTNORMAL"] "),			/**< GLOG_OK */
+	G_XARR("["G_TEXTBOLD G_COLORYELLOW" WARN "G_COLORRESET G_TEXTNORMAL"] "),			/**< GLOG_WARN */
+	G_XARR("["G_TEXTBOLD G_COLORRED"ERROR!"G_COLORRESET G_TEXTNORMAL"] "),				/**< GLOG_ERROR */
+	G_XARR("["G_TEXTBOLD G_TEXTBLINK G_COLORRED"PANIC!"G_COLORRESET G_TEXTNORMAL"] ")	/**< GLOG_FATAL */
+};
+
+#if defined(G_ENABLE_TERMPROFILES) || defined(G_ENABLE_LOGSINKS)
+/* Logging Texts without any formatting, for the compact terminal profiles and buffered sinks */
+static const _GMEMX char * const _GMEMX console_levels_plain[6] =
+{
+	G_XARR("[      ] "),	/**< GLOG_NORMAL */
+	G_XARR("[ INFO ] "),	/**< GLOG_INFO */
+	G_XARR("[  OK  ] "),	/**< GLOG_OK */
+	G_XARR("[ WARN ] "),	/**< GLOG_WARN */
+	G_XARR("[ERROR!] "),	/**< GLOG_ERROR */
+	G_XARR("[PANIC!] ")		/**< GLOG_FATAL */
+};
+#endif
+
+#if defined(G_ENABLE_LOGFORMAT) || defined(G_ENABLE_LOGSITES)
+/* Level names of the structured log records and the call-site list */
+static const _GMEMX char * const _GMEMX log_level_names[6] =
+{
+	G_XARR("NORMAL"),	/**< GLOG_NORMAL */
+	G_XARR("INFO"),		/**< GLOG_INFO */
+	G_XARR("OK"),		/**< GLOG_OK */
+	G_XARR("WARN"),		/**< GLOG_WARN */
+	G_XARR("ERROR"),	/**< GLOG_ERROR */
+	G_XARR("FATAL")		/**< GLOG_FATAL */
+};
+#endif
+
+#ifdef G_ENABLE_TERMPROFILES
+/* Device Attributes response parser states (ESC [ ? 6 2 ; ... c) */
+enum {
+	DA_IDLE = 0,	/**< No query pending */
+	DA_WAIT,		/**< Query sent, waiting for ESC */
+	DA_ESC,			/**< ESC received */
+	DA_CSI,			/**< ESC [ received */
+	DA_PARAM		/**< ESC [ ? received, reading parameters */
+};
+
+#define _G_DA_TIMEOUT	500		// Milliseconds the terminal has to answer the Device Attributes query
+#endif
+
+/* Prints the promt text on the current line, in the format of the terminal profile */
+static void _gshell_putPromtText(void)
+{
+#ifdef G_ENABLE_TERMPROFILES
+	if (_G_SES.termProfile != GSHELL_TERM_ANSI)
+	{
+		gshell_putString(_G_PROMT_PLAIN);
+		return;
+	}
+#endif
+	gshell_putString(_G_PROMT);
+}
+
+/* Prints the promt on a new line */
+static void _gshell_putPromt(void)
+{
+#ifdef G_ENABLE_DEFERPROMPT
+	_G_SES.promtDeferred = 0;
+#endif
+#ifdef G_ENABLE_TXQUEUES
+	_G_SES.txPromt = 0;
+#endif
+	gshell_putString(G_CRLF);
+	_gshell_putPromtText();
+}
+
+/* Erases the current line (promt and user input) and returns to the line start */
+static void _gshell_clearLine(void)
+{
+#ifdef G_ENABLE_DEFERPROMPT
+	if (_G_SES.promtDeferred)
+	{
+		// Nothing to erase, the cursor is still at the end of the last log message
+		_G_SES.promtDeferred = 0;
+		gshell_putString(G_CRLF);
+		return;
+	}
+#endif
+#ifdef G_ENABLE_TERMPROFILES
+	// Plain terminals can't erase, the carriage return has to do
+	if (_G_SES.termProfile != GSHELL_TERM_PLAIN)
+#endif
+	{
+		gshell_putString(G_CLEARLINE);
+	}
+	gshell_putChar(C_CARRET);
+}
+
+/* Restores the promt and user input after text has been printed above them */
+static void _gshell_restorePromt(void)
+{
+#ifdef G_ENABLE_DEFERPROMPT
+	// Redrawn once the burst is over, by gshell_poll or the next input
+	_G_SES.promtDeferred = 1;
+	_G_SES.lastLog = (sInternals.fp_msTimeStamp != NULL) ? sInternals.fp_msTimeStamp() : 0;
+#elif defined(G_ENABLE_TXQUEUES)
+	// The line ends within the queue of the text printed above. The promt is redrawn
+	// once all queues are empty, it would cut into the queued output otherwise
+	gshell_putString(G_CRLF);
+	_G_SES.txPromt = 1;
+#else
+	_gshell_putPromt();
+	gshell_putStringRAM(_G_SES.rx_buf);
+#endif
+}
+
+#ifdef G_ENABLE_DEFERPROMPT
+/* Milliseconds until the deferred promt of the selected session is due, GSHELL_NODEADLINE if none */
+static uint32_t _gshell_promtDue(void)
+{
+	uint32_t u32Quiet;
+
+	if (!_G_SES.promtDeferred)
+	{
+		return GSHELL_NODEADLINE;
+	}
+	if ((G_DEFERPROMPT_MS == 0) || (sInternals.fp_msTimeStamp == NULL))
+	{
+		return 0;
+	}
+	u32Quiet = sInternals.fp_msTimeStamp() - _G_SES.lastLog;
+	return (u32Quiet >= G_DEFERPROMPT_MS) ? 0 : (G_DEFERPROMPT_MS - u32Quiet);
+}
+
+/* Redraws the deferred promt and user input of the selected session */
+static void _gshell_redrawPromt(void)
+{
+	if (_G_SES.promtDeferred)
+	{
+		_gshell_putPromt();
+		gshell_putStringRAM(_G_SES.rx_buf);
+	}
+}
+#endif
+
+#ifdef G_ENABLE_TXQUEUES
+/* Sends one queued character, there has to be one. The queue being sent is kept until
+ * its line is complete, so lines of different priority aren't mixed up */
+static void _gshell_txSend(void)
+{
+	uint8_t u8Queue = _G_SES.txCur;
+	char c;
+
+	if (_G_SES.txq[u8Queue].head == _G_SES.txq[u8Queue].tail)
+	{
+		// Current line done (or its queue ran dry), take the highest queue with data
+		for (u8Queue = _G_TXQ_COUNT - 1; u8Queue > 0; u8Queue--)
+		{
+			if (_G_SES.txq[u8Queue].head != _G_SES.txq[u8Queue].tail)
+			{
+				break;
+			}
+		}
+	}
+	c = _G_SES.txq[u8Queue].buf[_G_SES.txq[u8Queue].tail++ & (G_TXQUEUE_SIZE - 1)];
+	_G_SES.txCur = (c == C_NEWLINE) ? _G_TXQ_CRIT : u8Queue;
+	_G_SES.fp_putChar(c);
+}
+
+/* Redraws the promt and input erased by a log message, at output priority. Waits
+ * for the queues to run empty unless bNow is set */
+static void _gshell_txRedraw(uint8_t bNow)
+{
+	uint8_t u8Prev = sThread.txPrio;
+
+	if (_G_SES.txPromt && (bNow || (gshell_txPending() == 0)))
+	{
+		_G_SES.txPromt = 0;
+		sThread.txPrio = _G_TXQ_OUT;
+		_gshell_putPromtText();
+		gshell_putStringRAM(_G_SES.rx_buf);
+		sThread.txPrio = u8Prev;
+	}
+}
+
+/* Queues a character with the priority of the running output, makes room first if full */
+static void _gshell_txPut(char c)
+{
+	uint8_t u8Queue = sThread.txPrio;
+
+	while ((uint16_t)(_G_SES.txq[u8Queue].head - _G_SES.txq[u8Queue].tail) >= G_TXQUEUE_SIZE)
+	{
+		_gshell_txSend();
+	}
+	if ((_G_SES.txq[u8Queue].head == _G_SES.txq[u8Queue].tail) && (sInternals.fp_wakeup != NULL))
+	{
+		// Queue was empty, the main loop may be asleep
+		sInternals.fp_wakeup();
+	}
+	_G_SES.txq[u8Queue].buf[_G_SES.txq[u8Queue].head++ & (G_TXQUEUE_SIZE - 1)] = c;
+}
+#endif
+
+#ifdef G_ENABLE_TERMPROFILES
+/* Filters the outgoing escape sequences according to the terminal profile
+ * Returns non-zero if the character has been consumed by the filter */
+static uint8_t _gshell_filterEscape(char c)
+{
+	uint8_t u8_cnt;
+
+	if (_G_SES.outEscLen == 0)
+	{
+		if (c != 0x1B)
+		{
+			return 0;
+		}
+		_G_SES.outEscBuf[_G_SES.outEscLen++] = c;
+		return 1;
+	}
+
+	// Intermediate / parameter characters, keep collecting (ESC [ and 0x20 to 0x3F)
+	if (((_G_SES.outEscLen == 1) && (c == '[')) || ((_G_SES.outEscLen > 1) && (c >= 0x20) && (c <= 0x3F)))
+	{
+		if (_G_SES.outEscLen < ESCSEQ_BUFLEN)
+		{
+			_G_SES.outEscBuf[_G_SES.outEscLen++] = c;
+			return 1;
+		}
+		// Sequence too long to be held back, stop filtering it
+	}
+	else if (_G_SES.termProfile == GSHELL_TERM_PLAIN)
+	{
+		// Final character (or the character after a lone ESC) - drop it all
+		_G_SES.outEscLen = 0;
+		return 1;
+	}
+	else if (c == 'm')
+	{
+		// Minimal profile: drop text formatting (SGR), pass everything else
+		_G_SES.outEscLen = 0;
+		return 1;
+	}
+
+	// Release the sequence held back so far, the current character follows after
+	for (u8_cnt = 0; u8_cnt < _G_SES.outEscLen; u8_cnt++)
+	{
+		_G_OUT(_G_SES.outEscBuf[u8_cnt]);
+	}
+	_G_SES.outEscLen = 0;
+	return 0;
+}
+#endif
+
+#ifdef G_ENABLE_LOGHISTORY
+/* CRC-8 (polynom 0x07), continues the CRC passed over */
+static uint8_t _gshell_crc8(uint8_t u8Crc, const uint8_t *pu8Data, uint16_t u16Len)
+{
+	uint8_t u8Bit;
+
+	while (u16Len--)
+	{
+		u8Crc ^= *pu8Data++;
+		for (u8Bit = 0; u8Bit < 8; u8Bit++)
+		{
+			u8Crc = (u8Crc & 0x80) ? (uint8_t)((u8Crc << 1) ^ 0x07) : (uint8_t)(u8Crc << 1);
+		}
+	}
+	return u8Crc;
+}
+
+static uint8_t _gshell_histHdrCrc(const _g_histhdr_t *psHdr)
+{
+	return _gshell_crc8(0, (const uint8_t *)psHdr, (uint16_t)((const uint8_t *)&psHdr->crc - (const uint8_t *)psHdr));
+}
+
+/* Writes the state into the inactive header and switches over to it once it's sealed */
+static void _gshell_histPublish(const _g_histhdr_t *psState)
+{
+	_g_histhdr_t *psHdr = &sHistory.hdr[sHistory.active ^ 1];
+
+	*psHdr = *psState;
+	psHdr->magic = _G_HIST_MAGIC;
+	psHdr->sequence = sHistory.hdr[sHistory.active].sequence + 1;
+	psHdr->crc = _gshell_histHdrCrc(psHdr);
+	sHistory.active ^= 1;
+}
+
+/* Copies bytes out of the ring buffer (or a copy of it), wrapping around at the end */
+static void _gshell_histRead(const uint8_t *pu8Ring, uint16_t u16Pos, uint8_t *pu8Dest, uint16_t u16Len)
+{
+	while (u16Len--)
+	{
+		*pu8Dest++ = pu8Ring[u16Pos];
+		if (++u16Pos >= G_LOGHISTORY_SIZE)	u16Pos = 0;
+	}
+}
+
+/* Copies bytes into the ring buffer, wrapping around at the end. Returns the new position */
+static uint16_t _gshell_histWrite(uint16_t u16Pos, const uint8_t *pu8Src, uint16_t u16Len)
+{
+	while (u16Len--)
+	{
+		sHistory.buf[u16Pos] = *pu8Src++;
+		if (++u16Pos >= G_LOGHISTORY_SIZE)	u16Pos = 0;
+	}
+	return u16Pos;
+}
+
+/* Reads the header of the record at u16Pos and checks its CRC.
+ * Returns the size of the whole record, 0 if it's corrupted */
+static uint16_t _gshell_histRecord(uint16_t u16Pos, uint8_t *pu8Header, uint16_t u16MaxLen)
+{
+	uint8_t u8Crc;
+	uint8_t u8_cnt;
+
+	_gshell_histRead(sHistory.buf, u16Pos, pu8Header, _G_HIST_RECHDR);
+	if ((uint16_t)(_G_HIST_RECHDR + pu8Header[0]) > u16MaxLen)
+	{
+		return 0;
+	}
+	u8Crc = _gshell_crc8(0, pu8Header, _G_HIST_RECHDR - 1);
+	u16Pos = (u16Pos + _G_HIST_RECHDR) % G_LOGHISTORY_SIZE;
+	for (u8_cnt = 0; u8_cnt < pu8Header[0]; u8_cnt++)
+	{
+		// Byte by byte, the text may wrap around the end of the ring
+		u8Crc = _gshell_crc8(u8Crc, &sHistory.buf[u16Pos], 1);
+		if (++u16Pos >= G_LOGHISTORY_SIZE)	u16Pos = 0;
+	}
+
+	return (u8Crc == pu8Header[_G_HIST_RECHDR - 1]) ? (uint16_t)(_G_HIST_RECHDR + pu8Header[0]) : 0;
+}
+
+static uint8_t _gshell_histHdrValid(const _g_histhdr_t *psHdr)
+{
+	return (psHdr->magic == _G_HIST_MAGIC) && (psHdr->tail < G_LOGHISTORY_SIZE) &&
+		   (psHdr->used <= G_LOGHISTORY_SIZE) && (psHdr->crc == _gshell_histHdrCrc(psHdr));
+}
+
+/* Checks the history after a reset. Keeps every valid record from the oldest on,
+ * and drops everything starting at the first corrupted one */
+static void _gshell_histValidate(void)
+{
+	uint8_t u8Header[_G_HIST_RECHDR];
+	_g_histhdr_t sState;
+	uint16_t u16Pos;
+	uint16_t u16Used = 0;
+	uint16_t u16Count = 0;
+	uint16_t u16RecLen;
+	uint8_t bValid0 = _gshell_histHdrValid(&sHistory.hdr[0]);
+	uint8_t bValid1 = _gshell_histHdrValid(&sHistory.hdr[1]);
+
+	if (!bValid0 && !bValid1)
+	{
+		sHistory.active = 0;
+		gshell_logHistoryClear();
+		return;
+	}
+	sHistory.active = (bValid1 && (!bValid0 || ((int32_t)(sHistory.hdr[1].sequence - sHistory.hdr[0].sequence) > 0))) ? 1 : 0;
+	sState = sHistory.hdr[sHistory.active];
+
+	u16Pos = sState.tail;
+	while ((u16Count < sState.count) && (u16Used < sState.used))
+	{
+		u16RecLen = _gshell_histRecord(u16Pos, u8Header, sState.used - u16Used);
+		if (u16RecLen == 0)
+		{
+			break;
+		}
+		u16Used += u16RecLen;
+		u16Pos = (u16Pos + u16RecLen) % G_LOGHISTORY_SIZE;
+		u16Count++;
+	}
+	sState.used = u16Used;
+	sState.count = u16Count;
+	_gshell_histPublish(&sState);
+}
+
+/* Appends a record, dropping the oldest ones until it fits */
+static void _gshell_histAppend(enum glog_level loglvl, uint32_t timestamp, const char *text, uint16_t u16Len)
+{
+	uint8_t u8Header[_G_HIST_RECHDR];
+	uint8_t u8OldHeader[_G_HIST_RECHDR];
+	_g_histhdr_t sState = sHistory.hdr[sHistory.active];
+	uint16_t u16Pos;
+
+	// Long messages are cut: they have to fit in the vsprintf buffer again when
+	// printed, and a record may take half of the history at most
+	if (u16Len > (G_RX_BUFSIZE - 1))						u16Len = G_RX_BUFSIZE - 1;
+	if (u16Len > 255)										u16Len = 255;
+	if (u16Len > (G_LOGHISTORY_SIZE / 2) - _G_HIST_RECHDR)	u16Len = (G_LOGHISTORY_SIZE / 2) - _G_HIST_RECHDR;
+
+	u8Header[0] = (uint8_t)u16Len;
+	u8Header[1] = (uint8_t)loglvl;
+	u8Header[2] = (uint8_t)timestamp;
+	u8Header[3] = (uint8_t)(timestamp >> 8);
+	u8Header[4] = (uint8_t)(timestamp >> 16);
+	u8Header[5] = (uint8_t)(timestamp >> 24);
+	u8Header[6] = _gshell_crc8(_gshell_crc8(0, u8Header, _G_HIST_RECHDR - 1), (const uint8_t *)text, u16Len);
+
+	// The published header only ever changes in one sealed step: the dropped
+	// records are published before their space is overwritten, the new record
+	// once it has been written completely. A reset in between keeps the last
+	// published header and all of its records
+	if ((G_LOGHISTORY_SIZE - sState.used) < (_G_HIST_RECHDR + u16Len))
+	{
+		while ((sState.count > 0) && ((G_LOGHISTORY_SIZE - sState.used) < (_G_HIST_RECHDR + u16Len)))
+		{
+			_gshell_histRead(sHistory.buf, sState.tail, u8OldHeader, 1);
+			sState.tail = (sState.tail + _G_HIST_RECHDR + u8OldHeader[0]) % G_LOGHISTORY_SIZE;
+			sState.used -= _G_HIST_RECHDR + u8OldHeader[0];
+			sState.count--;
+		}
+		_gshell_histPublish(&sState);
+	}
+
+	u16Pos = (sState.tail + sState.used) % G_LOGHISTORY_SIZE;
+	u16Pos = _gshell_histWrite(u16Pos, u8Header, _G_HIST_RECHDR);
+	_gshell_histWrite(u16Pos, (const uint8_t *)text, u16Len);
+
+	sState.used += _G_HIST_RECHDR + u16Len;
+	sState.count++;
+	_gshell_histPublish(&sState);
+}
+#endif
+
+#ifdef G_ENABLE_LOGFORMAT
+/* Output of the record encoder: the terminal or a buffer (also just measuring, if the buffer is NULL) */
+typedef struct {
+	uint8_t *buf;			/**< Output buffer */
+	uint16_t size;			/**< Size of the output buffer */
+	uint16_t len;			/**< Length of the encoded data, may exceed size */
+	uint8_t toTerminal;		/**< Send to the terminal instead of the buffer */
+} _gshell_enc_t;
+
+static void _gshell_encPut(_gshell_enc_t *enc, uint8_t u8Byte)
+{
+	if (enc->toTerminal)
+	{
+		// Raw, the escape filter of compact terminal profiles would eat CBOR bytes
+		_G_OUT((char)u8Byte);
+	}
+	else if (enc->len < enc->size)
+	{
+		enc->buf[enc->len] = u8Byte;
+	}
+	enc->len++;
+}
+
+/* Copies a string as it is, up to u16Len characters or the NULL-terminator */
+static void _gshell_encRaw(_gshell_enc_t *enc, const _GMEMX char *str, uint16_t u16Len)
+{
+	while (u16Len-- && *str)
+	{
+		_gshell_encPut(enc, (uint8_t)*str++);
+	}
+}
+
+/* Decimal number without leading zeros */
+static void _gshell_encUint(_gshell_enc_t *enc, uint32_t u32Val)
+{
+	char cDigits[10];
+	uint8_t u8Cnt = 0;
+
+	do
+	{
+		cDigits[u8Cnt++] = '0' + (u32Val % 10);
+		u32Val /= 10;
+	} while (u32Val);
+
+	while (u8Cnt)
+	{
+		_gshell_encPut(enc, (uint8_t)cDigits[--u8Cnt]);
+	}
+}
+
+/* JSON string with quotes, escaping quotes, backslashes and control characters */
+static void _gshell_encJsonStr(_gshell_enc_t *enc, const _GMEMX char *str, uint16_t u16Len)
+{
+	static const char hexDigits[] = "0123456789abcdef";
+	uint8_t c;
+
+	_gshell_encPut(enc, '"');
+	while (u16Len-- && (c = (uint8_t)*str++))
+	{
+		if ((c == '"') || (c == '\\'))
+		{
+			_gshell_encPut(enc, '\\');
+			_gshell_encPut(enc, c);
+		}
+		else if (c < 0x20)
+		{
+			_gshell_encRaw(enc, G_XSTR("\\u00"), 4);
+			_gshell_encPut(enc, hexDigits[c >> 4]);
+			_gshell_encPut(enc, hexDigits[c & 0x0F]);
+		}
+		else
+		{
+			_gshell_encPut(enc, c);
+		}
+	}
+	_gshell_encPut(enc, '"');
+}
+
+/* CBOR head: major type and argument in the shortest form */
+static void _gshell_cborHead(_gshell_enc_t *enc, uint8_t u8Major, uint32_t u32Val)
+{
+	u8Major <<= 5;
+	if (u32Val < 24)
+	{
+		_gshell_encPut(enc, u8Major | (uint8_t)u32Val);
+	}
+	else if (u32Val <= 0xFF)
+	{
+		_gshell_encPut(enc, u8Major | 24);
+		_gshell_encPut(enc, (uint8_t)u32Val);
+	}
+	else if (u32Val <= 0xFFFF)
+	{
+		_gshell_encPut(enc, u8Major | 25);
+		_gshell_encPut(enc, (uint8_t)(u32Val >> 8));
+		_gshell_encPut(enc, (uint8_t)u32Val);
+	}
+	else
+	{
+		_gshell_encPut(enc, u8Major | 26);
+		_gshell_encPut(enc, (uint8_t)(u32Val >> 24));
+		_gshell_encPut(enc, (uint8_t)(u32Val >> 16));
+		_gshell_encPut(enc, (uint8_t)(u32Val >> 8));
+		_gshell_encPut(enc, (uint8_t)u32Val);
+	}
+}
+
+/* CBOR text string (major type 3) */
+static void _gshell_cborText(_gshell_enc_t *enc, const _GMEMX char *str, uint16_t u16Len)
+{
+	_gshell_cborHead(enc, 3, u16Len);
+	_gshell_encRaw(enc, str, u16Len);
+}
+
+/* Encodes a record as JSON line or CBOR map, see enum gshell_logformat for the fields */
+static void _gshell_logEncodeTo(_gshell_enc_t *enc, uint8_t u8Format, const gshell_logrec_t *record)
+{
+	const _GMEMX char *pcLevel = log_level_names[record->level];
+	uint8_t bTimestamp = (sInternals.fp_msTimeStamp != NULL);
+
+	if (u8Format == GSHELL_LOGFMT_JSON)
+	{
+		_gshell_encRaw(enc, G_XSTR("{\"level\":"), 0xFFFF);
+		_gshell_encJsonStr(enc, pcLevel, 0xFFFF);
+		if (bTimestamp)
+		{
+			_gshell_encRaw(enc, G_XSTR(",\"ts\":"), 0xFFFF);
+			_gshell_encUint(enc, record->timestamp);
+		}
+		_gshell_encRaw(enc, G_XSTR(",\"msg\":"), 0xFFFF);
+		_gshell_encJsonStr(enc, record->text, record->length);
+		if (record->file != NULL)
+		{
+			_gshell_encRaw(enc, G_XSTR(",\"file\":"), 0xFFFF);
+			_gshell_encJsonStr(enc, record->file, 0xFFFF);
+			_gshell_encRaw(enc, G_XSTR(",\"line\":"), 0xFFFF);
+			_gshell_encUint(enc, record->line);
+		}
+		_gshell_encRaw(enc, G_XSTR("}\n"), 0xFFFF);
+	}
+	else if (u8Format == GSHELL_LOGFMT_CBOR)
+	{
+		_gshell_cborHead(enc, 5, 2 + bTimestamp + ((record->file != NULL) ? 2 : 0));
+		_gshell_cborText(enc, G_XSTR("level"), 5);
+		_gshell_cborText(enc, pcLevel, _G_STRNLEN(pcLevel, 8));
+		if (bTimestamp)
+		{
+			_gshell_cborText(enc, G_XSTR("ts"), 2);
+			_gshell_cborHead(enc, 0, record->timestamp);
+		}
+		_gshell_cborText(enc, G_XSTR("msg"), 3);
+		_gshell_cborText(enc, record->text, record->length);
+		if (record->file != NULL)
+		{
+			_gshell_cborText(enc, G_XSTR("file"), 4);
+			_gshell_cborText(enc, record->file, _G_STRNLEN(record->file, 0xFFFF));
+			_gshell_cborText(enc, G_XSTR("line"), 4);
+			_gshell_cborHead(enc, 0, record->line);
+		}
+	}
+}
+#endif
+
+#ifdef G_ENABLE_LOGSINKS
+/* Passes the buffered text over to the sink, keeps what hasn't been taken */
+static void _gshell_sinkFlush(gshell_sink_t *sink)
+{
+	uint16_t u16Taken;
+
+	if ((sink->bufFill == 0) || (sink->flush == NULL))	return;
+
+	u16Taken = sink->flush(sink->ctx, sink->buf, sink->bufFill);
+	if (u16Taken >= sink->bufFill)
+	{
+		sink->bufFill = 0;
+	}
+	else
+	{
+		memmove(sink->buf, sink->buf + u16Taken, sink->bufFill - u16Taken);
+		sink->bufFill -= u16Taken;
+	}
+}
+
+/* Appends a flash string to the sink buffer, space has been checked already */
+static void _gshell_sinkPutFlash(gshell_sink_t *sink, const _GMEMX char *str)
+{
+	while (*str)
+	{
+		sink->buf[sink->bufFill++] = *str++;
+	}
+}
+
+/* Stores the record as text line in the sink buffer: "[ WARN ] [000001234] text\r\n" */
+static void _gshell_sinkBuffer(gshell_sink_t *sink, const gshell_logrec_t *record)
+{
+	uint16_t u16Needed = 9 + record->length + 2;	// Level prefix, text and line ending
+	uint32_t u32Ts = record->timestamp;
+	uint8_t u8Digit;
+
+#ifdef G_ENABLE_LOGFORMAT
+	if (sink->format != GSHELL_LOGFMT_TEXT)
+	{
+		// Encoded straight into the free space, once more after a flush if it didn't fit
+		_gshell_enc_t sEnc = {(uint8_t *)sink->buf + sink->bufFill, sink->bufSize - sink->bufFill, 0, 0};
+		_gshell_logEncodeTo(&sEnc, sink->format, record);
+		if ((sEnc.len > sEnc.size) && (sink->flushPolicy != GSINK_FLUSH_MANUAL))
+		{
+			_gshell_sinkFlush(sink);
+			sEnc.buf = (uint8_t *)sink->buf + sink->bufFill;
+			sEnc.size = sink->bufSize - sink->bufFill;
+			sEnc.len = 0;
+			_gshell_logEncodeTo(&sEnc, sink->format, record);
+		}
+		if (sEnc.len > sEnc.size)
+		{
+			sink->dropped++;
+			return;
+		}
+		sink->bufFill += sEnc.len;
+		if (sink->flushPolicy == GSINK_FLUSH_RECORD)
+		{
+			_gshell_sinkFlush(sink);
+		}
+		return;
+	}
+#endif
+
+	if (sInternals.fp_msTimeStamp != NULL)
+	{
+		u16Needed += 12;							// "[000001234] "
+	}
+
+	if ((uint16_t)(sink->bufSize - sink->bufFill) < u16Needed)
+	{
+		if (sink->flushPolicy != GSINK_FLUSH_MANUAL)
+		{
+			_gshell_sinkFlush(sink);
+		}
+		if ((uint16_t)(sink->bufSize - sink->bufFill) < u16Needed)
+		{
+			sink->dropped++;
+			return;
+		}
+	}
+
+	_gshell_sinkPutFlash(sink, console_levels_plain[record->level]);
+	if (sInternals.fp_msTimeStamp != NULL)
+	{
+		// Same format as the terminal output, [%09u] without the vsprintf buffer
+		sink->buf[sink->bufFill] = '[';
+		for (u8Digit = 9; u8Digit > 0; u8Digit--)
+		{
+			sink->buf[sink->bufFill + u8Digit] = '0' + (u32Ts % 10);
+			u32Ts /= 10;
+		}
+		sink->buf[sink->bufFill + 10] = ']';
+		sink->buf[sink->bufFill + 11] = ' ';
+		sink->bufFill += 12;
+	}
+	memcpy(sink->buf + sink->bufFill, record->text, record->length);
+	sink->bufFill += record->length;
+	sink->buf[sink->bufFill++] = '\r';
+	sink->buf[sink->bufFill++] = '\n';
+
+	if (sink->flushPolicy == GSINK_FLUSH_RECORD)
+	{
+		_gshell_sinkFlush(sink);
+	}
+}
+
+/* Hands the record over to every sink whose level matches */
+static void _gshell_sinkDeliver(const gshell_logrec_t *record)
+{
+	gshell_sink_t *sink;
+
+	for (sink = sInternals.sinks; sink != NULL; sink = sink->next)
+	{
+		if (record->level < sink->minLevel)	continue;
+
+		if (sink->write != NULL)
+		{
+			sink->write(sink->ctx, record);
+		}
+		if (sink->buf != NULL)
+		{
+			uint16_t u16Before = sink->bufFill;
+
+			_gshell_sinkBuffer(sink, record);
+			if ((u16Before == 0) && (sink->bufFill != 0) && (sInternals.fp_wakeup != NULL))
+			{
+				sInternals.fp_wakeup();
+			}
+		}
+	}
+}
+#endif
+
+/* Echoes back to the terminal / serial port
+ * Filters out certain special characters
+ * Can be disabled via the define G_ENABLE_ECHO */
+static void _gshell_echo(char c)
+{
+#ifdef G_ENABLE_ECHO
+
+	if (C_NEWLINE == c) // Echoing newline?
+	{
+		// Add carriage return to newline
+		gshell_putChar(C_CARRET);
+		gshell_putChar(C_NEWLINE);
+	}
+	else if ((c == C_BACKSPCE1) || (c == C_BACKSPCE2)) // Echoing backspace?
+	{
+		// remove previous character on screen
+		gshell_putChar(C_BACKSPCE1);
+		gshell_putChar(C_WITESPCE);
+		gshell_putChar(C_BACKSPCE1);
+	}
+	else
+	{
+		gshell_putChar(c);
+	}
+#else
+	// Supress compiler warning
+	(void)(c);
+#endif
+}
+
+/* Find the right gshell_cmd_t command structure, which name
+ * matches the name passed over to this function. Also returns the ID
+ * of said command if found!
+ *
+ * If no command has been found, it returns a null-pointer and pi16CmdID with -1 */
+static const gshell_cmd_t *_gshellFindCmd(const char *name, int16_t *pi16CmdID)
+{
+	const gshell_cmd_t *command;
+	uint16_t u16_cnt;
+	
+	/* First check the linked chain
+	 * The first entry in the chain are always the internal commands, the
+	 * last entry being sInternals.lastChain. With that the chain can be
+	 * quicklychecked.
+	*/
+	for (u16_cnt = 0; u16_cnt < sInternals.chain_len; u16_cnt++)
+	{
+		// First entry always is cmd_help, from there follow the chain
+		if (u16_cnt)
+		{
+			command = command->next;
+		}
+		else
+		{
+			command = &cmd_help;
+		}
+		// Check if 'name' matches the command struct's name
+		if (_G_STRNCMP(name, command->cmdName, G_RX_BUFSIZE) == 0)
+		{
+#ifdef G_ENABLE_SUBCOMMANDS
+			*pi16CmdID = command->id;	// Command-ID, assigned during registration
+#else
+			*pi16CmdID = u16_cnt;		// Command-ID
+#endif
+			return command;		// Pointer to Command Structure
+		}
+	}
+
+#ifdef ENABLE_STATIC_COMMANDS
+	/* Then check the command list, their IDs follow the dynamic commands */
+	for (u16_cnt = 0; u16_cnt < gshell_list_num_commands; u16_cnt++)
+	{
+		command = &gshell_list_commands[u16_cnt];
+		// Similar as before, search the name in the command struct list
+		// and return it's ID and pointer when found
+		if (_G_STRNCMP(name, command->cmdName, G_RX_BUFSIZE) == 0)
+		{
+			*pi16CmdID = sInternals.cmd_count + u16_cnt;
+			return command;
+		}
+	}
+#endif 
+
+	/* None of the commands matched? Return a NULL-pointer and
+	 * the invalid command ID '-1'! */
+	*pi16CmdID = -1;
+	return NULL;
+}
+
+#ifdef G_ENABLE_SUBCOMMANDS
+/* Find a subcommand within the group's own chain, returns a null-pointer if not found.
+ * Only the group's subcommands are compared, so resolving a command path costs
+ * the size of each level, not the total amount of commands. */
+static const gshell_cmd_t *_gshellFindSubCmd(const gshell_cmd_t *group, const char *name)
+{
+	const gshell_cmd_t *command;
+
+	for (command = group->sub; command != NULL; command = command->next)
+	{
+		if (_G_STRNCMP(name, command->cmdName, G_RX_BUFSIZE) == 0)
+		{
+			return command;
+		}
+	}
+	return NULL;
+}
+#endif
+
+#ifndef G_ENABLE_SIMDSCAN
+/* Checks if a character contains any character inside the string.
+ * If yes, it returns that, otherwise it returns zero */
+static char _gshell_CharCmpStr(const char cInput, const char *strCheck)
+{
+	while(*strCheck != '\0')
+	{
+		if (cInput != *strCheck)
+		{
+			strCheck++;
+		}
+		else
+		{
+			return *strCheck;
+		}
+	}
+	return 0;
+}
+
+/* strtok replacement to support additional, special arguments
+ *
+ * In order to support string splitting with " or ' characters, a
+ * extended strtok function has been coded. It behaves similarly as the
+ * original function from string.h, but takes an additional string parameter.
+ *
+ * Otherwise arguments and return pointers are the same and it should
+ * behave the same too. The length of the returned token is stored in pu8Len.
+ */
+static char *_gshell_strtok(char *strInput, const char *delim, const char *special, uint8_t *pu8Len)
+{
+	static char *strProcess = NULL;	// Process string pointer
+	char *strStart = NULL;			// Start pointer of a string to split
+	static uint8_t bSpecialMode = 0;// Special Mode, enabled if a special character has been found
+
+	// New string passed over?
+	if (strInput != NULL)
+	{
+		strProcess = strInput;
+		bSpecialMode = 0;
+	}
+
+	// Process-String-Pointer empty?
+	if ((strProcess == NULL) || (*strProcess == '\0'))
+	{
+		return NULL;
+	}
+
+	// Work loop where the string is splitted
+	do
+	{
+		// Set the starting pointer to a valid character (non-delim or special)
+		if (strStart == NULL)
+		{
+			// Check if a normal split operation is detected
+			if ((bSpecialMode == 0) && _gshell_CharCmpStr(*strProcess, delim))
+			{
+				*strProcess = '\0';
+			}
+			// Check if a special split operation is detected
+			else if (_gshell_CharCmpStr(*strProcess, special))
+			{
+				*strProcess = '\0';
+
+				if (bSpecialMode)
+				{
+					bSpecialMode = 0;
+				}
+				else
+				{
+					bSpecialMode = 1;
+				}
+			}
+			else
+			{
+				// None of the other two? Character to set the start pointer on found!
+				strStart = strProcess;
+			}
+		}
+		else
+		{
+			// Check if a normal split operation is detected
+			if ((bSpecialMode == 0) && _gshell_CharCmpStr(*strProcess, delim))
+			{
+				*strProcess = '\0';
+				*pu8Len = (uint8_t)(strProcess - strStart);
+				strProcess++;
+
+				return strStart;
+			}
+			// Check if a special split operation is detected
+			else if (_gshell_CharCmpStr(*strProcess, special))
+			{
+				*strProcess = '\0';
+				*pu8Len = (uint8_t)(strProcess - strStart);
+				strProcess++;
+
+				if (bSpecialMode)
+				{
+					bSpecialMode = 0;
+				}
+				else
+				{
+					bSpecialMode = 1;
+				}
+				return strStart;
+			}
+		}
+	}
+	while(*++strProcess != '\0');
+	// Finish if the work-string-pointer reaches the end
+	// and return the last start pointer
+	if (strStart != NULL)
+	{
+		*pu8Len = (uint8_t)(strProcess - strStart);
+	}
+	return strStart;
+}
+#endif
+
+#ifdef G_ENABLE_SIMDSCAN
+/* Bulk input scanning, _G_SCAN_WIDTH bytes at a time. Each kernel classifies a block
+ * into a bit mask with _G_SCAN_STEP bits per byte, the lowest bits for the first byte */
+#if defined(__AVX2__)
+	#define _G_SCAN_WIDTH	32
+	#define _G_SCAN_STEP	1
+	typedef uint32_t _g_scanmask_t;
+#elif defined(__SSE2__)
+	#define _G_SCAN_WIDTH	16
+	#define _G_SCAN_STEP	1
+	typedef uint32_t _g_scanmask_t;
+#elif defined(__ARM_NEON)
+	#define _G_SCAN_WIDTH	16
+	#define _G_SCAN_STEP	4		// NEON has no movemask, the narrowing shift leaves a nibble per byte
+	typedef uint64_t _g_scanmask_t;
+#else
+	#define _G_SCAN_WIDTH	32		// Plain C for microcontrollers, one byte after another
+	#define _G_SCAN_STEP	1
+	typedef uint32_t _g_scanmask_t;
+#endif
+
+/* Printable input is taken in runs by gshell_processShellBuffer. Not with the
+ * (unfinished) input escape sequences, which would need every character */
+#ifndef G_ENABLE_INESCAPES
+	#define _G_SCAN_BULK
+#endif
+
+/* Index of the first byte set in a mask, and the mask without it */
+#define _G_SCAN_FIRST(m)	((uint16_t)(__builtin_ctzll(m) / _G_SCAN_STEP))
+#define _G_SCAN_DROP(m)		((m) & ~((((_g_scanmask_t)1 << _G_SCAN_STEP) - 1) << (__builtin_ctzll(m) & ~(_G_SCAN_STEP - 1))))
+
+/* Mask of the control characters (below space and DEL) within a block */
+static inline _g_scanmask_t _gshell_scanCtrl(const char *block)
+{
+#if defined(__AVX2__)
+	__m256i v = _mm256_loadu_si256((const __m256i *)block);
+	__m256i ctrl = _mm256_or_si256(_mm256_cmpeq_epi8(_mm256_min_epu8(v, _mm256_set1_epi8(0x1F)), v),
+								   _mm256_cmpeq_epi8(v, _mm256_set1_epi8(0x7F)));
+	return (uint32_t)_mm256_movemask_epi8(ctrl);
+#elif defined(__SSE2__)
+	__m128i v = _mm_loadu_si128((const __m128i *)block);
+	__m128i ctrl = _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(v, _mm_set1_epi8(0x1F)), v),
+								_mm_cmpeq_epi8(v, _mm_set1_epi8(0x7F)));
+	return (uint32_t)_mm_movemask_epi8(ctrl);
+#elif defined(__ARM_NEON)
+	uint8x16_t v = vld1q_u8((const uint8_t *)block);
+	uint8x16_t ctrl = vorrq_u8(vcleq_u8(v, vdupq_n_u8(0x1F)), vceqq_u8(v, vdupq_n_u8(0x7F)));
+	return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(ctrl), 4)), 0);
+#else
+	_g_scanmask_t mask = 0;
+	uint8_t u8_cnt;
+
+	for (u8_cnt = 0; u8_cnt < _G_SCAN_WIDTH; u8_cnt++)
+	{
+		if (((uint8_t)block[u8_cnt] < 0x20) || (block[u8_cnt] == 0x7F))
+		{
+			mask |= (_g_scanmask_t)1 << u8_cnt;
+		}
+	}
+	return mask;
+#endif
+}
+
+/* Masks of the argument delimiters and of the quotation marks within a block */
+static inline _g_scanmask_t _gshell_scanSplit(const char *block, _g_scanmask_t *pQuotes)
+{
+#if defined(__AVX2__)
+	__m256i v = _mm256_loadu_si256((const __m256i *)block);
+	*pQuotes = (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')),
+															  _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\''))));
+	return (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(C_WITESPCE)),
+														  _mm256_cmpeq_epi8(v, _mm256_set1_epi8(_G_ENT_PROCESS))));
+#elif defined(__SSE2__)
+	__m128i v = _mm_loadu_si128((const __m128i *)block);
+	*pQuotes = (uint32_t)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')),
+														_mm_cmpeq_epi8(v, _mm_set1_epi8('\''))));
+	return (uint32_t)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(C_WITESPCE)),
+													_mm_cmpeq_epi8(v, _mm_set1_epi8(_G_ENT_PROCESS))));
+#elif defined(__ARM_NEON)
+	uint8x16_t v = vld1q_u8((const uint8_t *)block);
+	uint8x16_t quotes = vorrq_u8(vceqq_u8(v, vdupq_n_u8('"')), vceqq_u8(v, vdupq_n_u8('\'')));
+	uint8x16_t delims = vorrq_u8(vceqq_u8(v, vdupq_n_u8(C_WITESPCE)), vceqq_u8(v, vdupq_n_u8(_G_ENT_PROCESS)));
+	*pQuotes = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(quotes), 4)), 0);
+	return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(delims), 4)), 0);
+#else
+	_g_scanmask_t delims = 0;
+	uint8_t u8_cnt;
+
+	*pQuotes = 0;
+	for (u8_cnt = 0; u8_cnt < _G_SCAN_WIDTH; u8_cnt++)
+	{
+		if ((block[u8_cnt] == C_WITESPCE) || (block[u8_cnt] == _G_ENT_PROCESS))
+		{
+			delims |= (_g_scanmask_t)1 << u8_cnt;
+		}
+		else if ((block[u8_cnt] == '"') || (block[u8_cnt] == '\''))
+		{
+			*pQuotes |= (_g_scanmask_t)1 << u8_cnt;
+		}
+	}
+	return delims;
+#endif
+}
+
+/* Length of the run of printable characters at the start of data */
+static uint16_t _gshell_scanPlain(const char *data, uint16_t length)
+{
+	char cTail[_G_SCAN_WIDTH];
+	_g_scanmask_t mask;
+	uint16_t u16Pos;
+
+	for (u16Pos = 0; u16Pos + _G_SCAN_WIDTH <= length; u16Pos += _G_SCAN_WIDTH)
+	{
+		mask = _gshell_scanCtrl(data + u16Pos);
+		if (mask != 0)
+		{
+			return u16Pos + _G_SCAN_FIRST(mask);
+		}
+	}
+	if (u16Pos < length)
+	{
+		// The last block is scanned from a copy, padded with control characters
+		memset(cTail, 0, _G_SCAN_WIDTH);
+		memcpy(cTail, data + u16Pos, length - u16Pos);
+		return u16Pos + _G_SCAN_FIRST(_gshell_scanCtrl(cTail));
+	}
+	return length;
+}
+
+/* Splits the input line into arguments, just like _gshell_strtok does (or strtok,
+ * without G_ENABLE_SPECIALCMDSTR), but by the masks of whole blocks.
+ * Returns the amount of arguments */
+static uint8_t _gshell_scanArgs(char *line, uint16_t length, char *argv[], uint8_t argl[])
+{
+	char cTail[_G_SCAN_WIDTH];
+	const char *pcBlock;
+	_g_scanmask_t delims, quotes, mask;
+	uint16_t u16Base, u16Pos;
+	uint16_t u16Next = 0;		// First character after the last split
+	int16_t i16Start = -1;		// Start of the current argument, -1 if none
+	uint8_t bQuoted = 0;
+	uint8_t bQuote;
+	uint8_t argc = 0;
+
+	for (u16Base = 0; u16Base < length; u16Base += _G_SCAN_WIDTH)
+	{
+		pcBlock = line + u16Base;
+		if (length - u16Base < _G_SCAN_WIDTH)
+		{
+			memset(cTail, 0, _G_SCAN_WIDTH);
+			memcpy(cTail, pcBlock, length - u16Base);
+			pcBlock = cTail;
+		}
+		delims = _gshell_scanSplit(pcBlock, &quotes);
+#ifdef G_ENABLE_SPECIALCMDSTR
+		mask = delims | quotes;
+#else
+		mask = delims;
+#endif
+
+		for (; mask != 0; mask = _G_SCAN_DROP(mask))
+		{
+			u16Pos = u16Base + _G_SCAN_FIRST(mask);
+			bQuote = (line[u16Pos] == '"') || (line[u16Pos] == '\'');
+			if (bQuoted && !bQuote)
+			{
+				// Delimiters are part of a quoted argument
+				continue;
+			}
+			if ((i16Start < 0) && (u16Pos > u16Next))
+			{
+				i16Start = (int16_t)u16Next;
+			}
+			line[u16Pos] = C_NULLCHAR;
+			if (i16Start >= 0)
+			{
+				argv[argc] = line + i16Start;
+				argl[argc] = (uint8_t)(u16Pos - i16Start);
+				i16Start = -1;
+				if (++argc >= G_MAX_ARGS)
+				{
+					return argc;
+				}
+			}
+			if (bQuote)
+			{
+				// Quotation marks toggle between quoted and normal splitting
+				bQuoted = !bQuoted;
+			}
+			u16Next = u16Pos + 1;
+		}
+	}
+
+	// Last argument ends with the line
+	if ((i16Start < 0) && (length > u16Next))
+	{
+		i16Start = (int16_t)u16Next;
+	}
+	if (i16Start >= 0)
+	{
+		argv[argc] = line + i16Start;
+		argl[argc] = (uint8_t)(length - i16Start);
+		argc++;
+	}
+	return argc;
+}
+#endif
+
+#ifdef G_ENABLE_ARGSCHEMA
+/* Converts a decimal number, returns non-zero if the string isn't one or overflows */
+static uint8_t _gshell_parseInt(const char *str, int32_t *pi32Value)
+{
+	uint32_t u32Value = 0;
+	uint8_t bNegative = 0;
+
+	if ((*str == '-') || (*str == '+'))
+	{
+		bNegative = (*str++ == '-');
+	}
+	if (*str == '\0')
+	{
+		return 1;
+	}
+	for (; *str != '\0'; str++)
+	{
+		if ((*str < '0') || (*str > '9') || (u32Value > (UINT32_C(0x80000000) / 10)))
+		{
+			return 1;
+		}
+		u32Value = u32Value * 10 + (uint32_t)(*str - '0');
+	}
+	// Positive values up to 0x7FFFFFFF, negative ones up to 0x80000000
+	if (u32Value > (UINT32_C(0x7FFFFFFF) + bNegative))
+	{
+		return 1;
+	}
+	*pi32Value = bNegative ? (int32_t)(0 - u32Value) : (int32_t)u32Value;
+	return 0;
+}
+
+/* Converts a hexadecimal number (with or without 0x), returns non-zero if invalid */
+static uint8_t _gshell_parseHex(const char *str, uint32_t *pu32Value)
+{
+	uint32_t u32Value = 0;
+	uint8_t u8Digits = 0;
+	char c;
+
+	if ((str[0] == '0') && ((str[1] == 'x') || (str[1] == 'X')))
+	{
+		str += 2;
+	}
+	for (; *str != '\0'; str++)
+	{
+		c = *str | 0x20;	// Lower case letters, digits stay the same
+		if ((c >= '0') && (c <= '9'))
+		{
+			c -= '0';
+		}
+		else if ((c >= 'a') && (c <= 'f'))
+		{
+			c -= 'a' - 10;
+		}
+		else
+		{
+			return 1;
+		}
+		if (++u8Digits > 8)
+		{
+			return 1;
+		}
+		u32Value = (u32Value << 4) | (uint8_t)c;
+	}
+	*pu32Value = u32Value;
+	return (u8Digits == 0);
+}
+
+/* Converts a decimal floating point number, with optional exponent.
+ * Only the first nine significant digits are taken into account, which is
+ * plenty for a float. Returns non-zero if invalid */
+static uint8_t _gshell_parseFloat(const char *str, float *pfValue)
+{
+	uint32_t u32Mantissa = 0;
+	int16_t i16Exponent = 0;
+	int32_t i32ExpPart = 0;
+	uint8_t u8Digits = 0;
+	uint8_t bNegative = 0;
+	uint8_t bFraction = 0;
+	uint8_t bAnyDigit = 0;
+	float fValue;
+
+	if ((*str == '-') || (*str == '+'))
+	{
+		bNegative = (*str++ == '-');
+	}
+	for (; *str != '\0'; str++)
+	{
+		if ((*str >= '0') && (*str <= '9'))
+		{
+			bAnyDigit = 1;
+			if (u8Digits < 9)
+			{
+				u32Mantissa = u32Mantissa * 10 + (uint32_t)(*str - '0');
+				if (u32Mantissa)	u8Digits++;
+				if (bFraction)		i16Exponent--;
+			}
+			else if (!bFraction)
+			{
+				i16Exponent++;	// Digits beyond the precision, only the magnitude counts
+			}
+		}
+		else if ((*str == '.') && !bFraction)
+		{
+			bFraction = 1;
+		}
+		else if (((*str == 'e') || (*str == 'E')) && bAnyDigit)
+		{
+			if (_gshell_parseInt(str + 1, &i32ExpPart) || (i32ExpPart > 64) || (i32ExpPart < -64))
+			{
+				return 1;
+			}
+			i16Exponent += (int16_t)i32ExpPart;
+			break;
+		}
+		else
+		{
+			return 1;
+		}
+	}
+	if (!bAnyDigit)
+	{
+		return 1;
+	}
+
+	fValue = (float)u32Mantissa;
+	for (; i16Exponent > 0; i16Exponent--)	fValue *= 10.0f;
+	for (; i16Exponent < 0; i16Exponent++)	fValue /= 10.0f;
+	*pfValue = bNegative ? -fValue : fValue;
+	return 0;
+}
+
+/* Finds the string within the '|' seperated keyword list (in flash memory),
+ * returns the keyword's index or -1 if not found */
+static int8_t _gshell_parseEnum(const char *str, const _GMEMX char *keywords)
+{
+	const char *strCmp = str;
+	uint8_t bMatch = 1;
+	int8_t i8Index = 0;
+	char c;
+
+	do
+	{
+		c = *keywords++;
+		if ((c == '|') || (c == '\0'))
+		{
+			// End of a keyword - did all the characters match?
+			if (bMatch && (*strCmp == '\0'))
+			{
+				return i8Index;
+			}
+			strCmp = str;
+			bMatch = 1;
+			i8Index++;
+		}
+		else if (bMatch && (*strCmp == c))
+		{
+			strCmp++;
+		}
+		else
+		{
+			// Mismatch, skip the remaining characters of this keyword
+			bMatch = 0;
+		}
+	}
+	while (c != '\0');
+
+	return -1;
+}
+
+/* Validates and converts the arguments according to the command's schema
+ * Prints the error and usage and returns non-zero if they don't match */
+static uint8_t _gshell_parseArgs(const gshell_cmd_t *command, uint8_t argc, char *argv[])
+{
+	const _GMEMX gshell_arg_t *arg;
+	uint8_t u8Pos = 0;		// Next positional schema entry
+	uint8_t u8Arg;
+	uint8_t u8Idx;
+	uint8_t bInvalid;
+	int8_t i8Keyword;
+	// Schema entries beyond G_MAX_ARGS can't hold a value, static commands aren't checked on registration
+	uint8_t u8Count = (command->argsCount < G_MAX_ARGS) ? command->argsCount : G_MAX_ARGS;
+
+	memset(sThread.argValues, 0, sizeof(sThread.argValues));
+	sThread.argGivenMask = 0;
+
+	for (u8Arg = 1; u8Arg < argc; u8Arg++)
+	{
+		// Flags are matched by name, wherever they are
+		for (u8Idx = 0; u8Idx < u8Count; u8Idx++)
+		{
+			arg = &command->args[u8Idx];
+			if ((arg->type == GARG_FLAG) && (_G_STRNCMP(argv[u8Arg], arg->name, G_RX_BUFSIZE) == 0))
+			{
+				break;
+			}
+		}
+
+		if (u8Idx >= u8Count)
+		{
+			// No flag, so it's the next positional argument
+			for (u8Idx = u8Pos; (u8Idx < u8Count) && (command->args[u8Idx].type == GARG_FLAG); u8Idx++);
+			if (u8Idx >= u8Count)
+			{
+				gshell_putString(_G_ARGMANY G_CRLF);
+				_gshell_printUsage(command);
+				return 1;
+			}
+			u8Pos = u8Idx + 1;
+			arg = &command->args[u8Idx];
+		}
+
+		bInvalid = 0;
+		switch (arg->type)
+		{
+			case GARG_INT:
+				bInvalid = _gshell_parseInt(argv[u8Arg], &sThread.argValues[u8Idx].i);
+				if (!bInvalid && (arg->min || arg->max))
+				{
+					bInvalid = (sThread.argValues[u8Idx].i < arg->min) || (sThread.argValues[u8Idx].i > arg->max);
+				}
+				break;
+			case GARG_HEX:
+				bInvalid = _gshell_parseHex(argv[u8Arg], &sThread.argValues[u8Idx].u);
+				if (!bInvalid && (arg->min || arg->max))
+				{
+					bInvalid = (sThread.argValues[u8Idx].u < (uint32_t)arg->min) || (sThread.argValues[u8Idx].u > (uint32_t)arg->max);
+				}
+				break;
+			case GARG_FLOAT:
+				bInvalid = _gshell_parseFloat(argv[u8Arg], &sThread.argValues[u8Idx].f);
+				break;
+			case GARG_ENUM:
+				i8Keyword = _gshell_parseEnum(argv[u8Arg], arg->keywords);
+				bInvalid = (i8Keyword < 0);
+				sThread.argValues[u8Idx].e = (uint8_t)i8Keyword;
+				break;
+			case GARG_FLAG:
+				sThread.argValues[u8Idx].e = 1;
+				break;
+			default:
+				sThread.argValues[u8Idx].s = argv[u8Arg];
+				break;
+		}
+
+		if (bInvalid)
+		{
+			gshell_putString(_G_ARGINV);
+			gshell_putStringRAM(argv[u8Arg]);
+			gshell_putString(G_CRLF);
+			_gshell_printUsage(command);
+			return 1;
+		}
+		sThread.argGivenMask |= (uint32_t)1 << u8Idx;
+	}
+
+	// Every mandatory positional argument has to be there
+	for (u8Idx = 0; u8Idx < u8Count; u8Idx++)
+	{
+		arg = &command->args[u8Idx];
+		if ((arg->type != GARG_FLAG) && !arg->optional && !(sThread.argGivenMask & ((uint32_t)1 << u8Idx)))
+		{
+			gshell_putString(_G_ARGMISS);
+			gshell_putString_flash(arg->name);
+			gshell_putString(G_CRLF);
+			_gshell_printUsage(command);
+			return 1;
+		}
+	}
+	return 0;
+}
+#endif
+
+/* Finds the command named by argv[0], followed by its subcommands named by the next
+ * arguments. Returns NULL if there is no such command, otherwise fills in its ID and
+ * the amount of group names in front of it */
+static const gshell_cmd_t *_gshell_resolveCmd(uint8_t argc, char *argv[], int16_t *pi16CmdID, uint8_t *pu8ArgOfs)
+{
+	const gshell_cmd_t *command = _gshellFindCmd(argv[0], pi16CmdID);
+
+	*pu8ArgOfs = 0;
+#ifdef G_ENABLE_SUBCOMMANDS
+	// Resolve command groups level by level, as long as the next argument
+	// names a subcommand. The handler gets its own name as argv[0]
+	while ((command != NULL) && (command->sub != NULL) && ((*pu8ArgOfs + 1) < argc))
+	{
+		const gshell_cmd_t *subcommand = _gshellFindSubCmd(command, argv[*pu8ArgOfs + 1]);
+		if (subcommand == NULL)
+		{
+			break;
+		}
+		command = subcommand;
+		*pi16CmdID = subcommand->id;
+		(*pu8ArgOfs)++;
+	}
+#else
+	// Supress compiler warning
+	(void)(argc);
+#endif
+	return command;
+}
+
+/* Calls the handler of a (sub)command, argv[0] being its own name */
+static uint8_t _gshell_callCmd(const gshell_cmd_t *command, uint8_t argc, char *argv[], const uint8_t argl[])
+{
+#ifdef G_ENABLE_RESULTQUEUE
+	sThread.resultPosted = 0;
+	sThread.resultValue = 0;
+#endif
+#ifdef G_ENABLE_CMDCONTEXT
+	if (command->handlerCtx != NULL)
+	{
+		// Context handler gets the user pointer and the argument lengths as well
+		return command->handlerCtx(command->ctx, argc, argv, argl);
+	}
+#else
+	// Argument lengths are only passed on to context handlers
+	(void)(argl);
+#endif
+	if (command->handler != NULL)
+	{
+		return command->handler(argc, argv);
+	}
+#ifdef G_ENABLE_SUBCOMMANDS
+	if (command->sub != NULL)
+	{
+		// Group without own handler, list what it has to offer
+		_gshell_helpSubCmds(command);
+	}
+#endif
+	return 0;
+}
+
+#ifdef G_ENABLE_RESULTQUEUE
+/* Queues the completion of a command, if it returned or posted a value. Called
+ * on the input thread only, the queue has a single producer */
+static void _gshell_resultQueue(int16_t i16CmdID, uint8_t u8Status, uint32_t u32Value, uint8_t u8Flags)
+{
+	uint8_t head = sResults.head;
+	gshell_resultrec_t *psRec;
+
+	if ((u8Status == 0) && !(u8Flags & GSHELL_RESF_VALUE))
+	{
+		return;
+	}
+	if ((uint8_t)(head - __atomic_load_n(&sResults.tail, __ATOMIC_ACQUIRE)) >= G_RESULTQUEUE_SIZE)
+	{
+		sResults.overruns++;
+		return;
+	}
+
+	psRec = &sResults.rec[head & (G_RESULTQUEUE_SIZE - 1)];
+	psRec->value = u32Value;
+	psRec->timestamp = (sInternals.fp_msTimeStamp != NULL) ? sInternals.fp_msTimeStamp() : 0;
+	psRec->cmdID = i16CmdID;
+	psRec->status = u8Status;
+	psRec->flags = u8Flags;
+	__atomic_store_n(&sResults.head, (uint8_t)(head + 1), __ATOMIC_RELEASE);
+}
+
+/* Queues the completion of the command just run on this thread */
+static void _gshell_resultPush(int16_t i16CmdID, uint8_t u8Status, uint8_t u8Flags)
+{
+	_gshell_resultQueue(i16CmdID, u8Status, sThread.resultValue, u8Flags | (sThread.resultPosted ? GSHELL_RESF_VALUE : 0));
+}
+#endif
+
+/* Processes the complete string, inputted by the user
+ * Splits the string by spaces and searches for a matching command,
+ * before calling it and passing over the arguments in a standard-c-style fashion.
+ * If the command returns a value, it too is processed and returned back
+ * for the user to handle the command's return value.
+ *
+ * Returns GSHELL_CMDRET and fills in psResult if the command returned a value,
+ * otherwise the enum 'gshell_return' status. */
+static enum gshell_return _gshell_process(gshell_result_t *psResult)
+{
+	enum gshell_return eGshellPrc = GSHELL_OK;	// Function Status uppon exit
+	uint8_t argc = 0;			// Classic C-Style argc to fill in
+	char *argv[G_MAX_ARGS];		// Classic C-Style argv to fill in
+	uint8_t argl[G_MAX_ARGS];	// Length of each argument, as found by the tokenizer
+	uint8_t u8CmdRet = 0;		// Return Value of the command
+	int16_t i16CmdID = 0;		// ID of the command
+	uint8_t u8ArgOfs = 0;		// Amount of group names in front of the resolved (sub)command
+
+	// No newline, no command to process!
+	if (_G_SES.rx_buf[_G_SES.rx_index - 1] != _G_ENT_PROCESS)
+	{
+		return GSHELL_OK;
+	}
+
+	// Split by spaces into seperate strings, store the pointers in argv (command + arguments)
+	// and increase argc
+#ifdef G_ENABLE_SIMDSCAN
+	argc = _gshell_scanArgs(_G_SES.rx_buf, _G_SES.rx_index, argv, argl);
+#elif defined(G_ENABLE_SPECIALCMDSTR)
+	// Pay attention to special characters like " or ' and split accordingly
+	uint8_t u8TokLen = 0;
+	char *pch = _gshell_strtok(_G_SES.rx_buf, _G_STR_PROCESS, _G_STR_COMPSLIT, &u8TokLen);
+	while (pch != NULL)
+	{
+		if (argc < G_MAX_ARGS)
+		{
+			argl[argc] = u8TokLen;
+			argv[argc++] = pch;
+			pch = _gshell_strtok(NULL, _G_STR_PROCESS, _G_STR_COMPSLIT, &u8TokLen);
+		}
+		else
+		{
+			break;
+		}
+	}
+#else
+	char *pch = strtok(_G_SES.rx_buf, _G_STR_PROCESS);
+    while (pch != NULL)
+	{
+		if (argc < G_MAX_ARGS)
+		{
+			argl[argc] = (uint8_t)strlen(pch);
+			argv[argc++] = pch;
+			pch = strtok(NULL, _G_STR_PROCESS);
+		}
+		else
+		{
+			break;
+		}
+	}
+#endif
+
+	// Just making sure we have actually found *any* argument
+	if (argc >= 1)
+	{
+		// Actual text has been received! Time to find the fitting command to it, else
+		// print the error
+		const gshell_cmd_t *command = _gshell_resolveCmd(argc, argv, &i16CmdID, &u8ArgOfs);
+		if (!command)
+		{
+			// command not found, return error
+			gshell_putString(_G_UNKCMD);
+			gshell_putStringRAM(argv[0]);
+			gshell_putString(_G_HLPCMD);
+			eGshellPrc = GSHELL_CMDINV;
+		}
+		else
+		{
+			// Command found, calling the function pointer with the command line arguments
+#ifdef G_ENABLE_ARGSCHEMA
+			if ((command->args != NULL) && _gshell_parseArgs(command, argc - u8ArgOfs, &argv[u8ArgOfs]))
+			{
+				// Arguments don't match the schema, the handler isn't called
+				eGshellPrc = GSHELL_ARGINV;
+			}
+			else
+#endif
+#ifdef G_ENABLE_WORKERS
+			if (command->blocking && (sInternals.fp_dispatch != NULL) &&
+				sInternals.fp_dispatch(command, i16CmdID, argc - u8ArgOfs, &argv[u8ArgOfs]))
+			{
+				// Runs on a worker thread, the input goes on meanwhile
+				eGshellPrc = GSHELL_CMDQUEUED;
+			}
+			else
+#endif
+			{
+				u8CmdRet = _gshell_callCmd(command, argc - u8ArgOfs, &argv[u8ArgOfs], &argl[u8ArgOfs]);
+#ifdef G_ENABLE_RESULTQUEUE
+				_gshell_resultPush(i16CmdID, u8CmdRet, 0);
+#endif
+			}
+		}
+	}
+	else
+	{
+		// User probably just spammed the enter key
+		gshell_putString(_G_HLPCMD);
+		eGshellPrc = GSHELL_RUBBISH;
+	}
+
+	/* Resetting the input buffer */
+	memset(_G_SES.rx_buf, 0, G_RX_BUFSIZE);
+	_G_SES.rx_index = 0;
+
+	// If the shell promt is enabled, reprint it (showing the user that we're ready
+	// for new commands)
+	if (_G_SES.promtEnabled)
+	{
+		_gshell_putPromt();
+	}
+
+	// If the called command returned a value, report it together with the command's ID
+	if (u8CmdRet)
+	{
+		psResult->cmdID = i16CmdID;
+		psResult->value = u8CmdRet;
+		return GSHELL_CMDRET;
+	}
+	else
+	{
+		return eGshellPrc;
+	}
+}
+
+/* Terminal turned on, prompt turned off, empty input buffer */
+static void _gshell_sessionReset(gshell_session_t *session, void (*put_char)(char))
+{
+#ifdef G_ENABLE_WATCH
+	if (sWatch.session == session)
+	{
+		// Whatever ran there before doesn't belong to the new terminal
+		sWatch.command = NULL;
+		sWatch.session = NULL;
+	}
+#endif
+	memset(session, 0, sizeof(gshell_session_t));
+	session->fp_putChar = put_char;
+	session->isActive = 1;
+#ifdef G_ENABLE_TXQUEUES
+	session->txCur = _G_TXQ_CRIT;		// No line started, the highest queue goes first
+#endif
+}
+
+int8_t gshell_init(void (*put_char)(char), uint32_t (*get_msTimeStamp)(void))
+{
+	// Storing function pointers in the internal variable structure
+	sInternals.fp_msTimeStamp = get_msTimeStamp;
+
+	// Setting up the default terminal: turned on, prompt turned off, empty input buffer
+	_gshell_sessionReset(&sInternals.mainSession, put_char);
+#ifdef G_ENABLE_SESSIONS
+	sThread.session = &sInternals.mainSession;
+#endif
+	
+	// Register the default help command. The static command list (at most 255
+	// commands) always fits within the 16-bit command IDs
+	gshell_register_cmd(&cmd_help);
+
+#ifdef G_ENABLE_LOGHISTORY
+	// Keep what survived the reset, then offer it via 'dmesg'
+	_gshell_histValidate();
+	gshell_register_cmd(&cmd_dmesg);
+#endif
+#ifdef G_ENABLE_TRACE
+	// Trace with the milliseconds tick, unless a faster clock has been set already
+	if (sTrace.fp_getTick == NULL)
+	{
+		gshell_traceClock(get_msTimeStamp, 1000);
+	}
+	gshell_register_cmd(&cmd_trace);
+#endif
+#ifdef G_ENABLE_LOGSITES
+	gshell_register_cmd(&cmd_logsite);
+#endif
+#ifdef G_ENABLE_WATCH
+	sWatch.command = NULL;
+	gshell_register_cmd(&cmd_watch);
+	gshell_register_cmd(&cmd_repeat);
+#endif
+
+
+	// New lines for good measure
+	gshell_putString(G_CRLF G_CRLF);
+
+	return 0;
+}
+
+int16_t gshell_register_cmd(gshell_cmd_t *cmd)
+{
+	// Check if max. amount of commands already have been reached
+	uint16_t u16CheckCmdCnt = sInternals.cmd_count;
+#ifdef ENABLE_STATIC_COMMANDS
+	u16CheckCmdCnt += gshell_list_num_commands;
+#endif
+	if (u16CheckCmdCnt >= _G_MAXCMD)
+	{
+		return -1;
+	}
+#ifdef G_ENABLE_ARGSCHEMA
+	if (cmd->argsCount > G_MAX_ARGS)
+	{
+		// More schema entries than argument values
+		return -1;
+	}
+#endif
+
+	// Check if the lastChain variable as been assigned -> set it in as first entry!
+	if (sInternals.lastChain == NULL)
+	{
+		sInternals.lastChain = cmd;
+		sInternals.chain_len++;
+	}
+	else
+	{
+		// If not, rebuild and extend the command chain, and increase the chain length counter
+		sInternals.lastChain->next = cmd;
+		sInternals.lastChain = cmd;
+		sInternals.chain_len++;
+	}
+
+	// Help function needs to rebuild the "spaces" length for nice formatting
+	sInternals.helpCmdDescLength = 0;
+	sInternals.helpCmdNameLength = 0;
+
+	// The ID is the amount of commands registered before this one
+#ifdef G_ENABLE_SUBCOMMANDS
+	cmd->id = sInternals.cmd_count;
+#endif
+	return sInternals.cmd_count++;
+}
+
+#ifdef G_ENABLE_SUBCOMMANDS
+int16_t gshell_register_subcmd(gshell_cmd_t *group, gshell_cmd_t *cmd)
+{
+	gshell_cmd_t *last;
+	uint16_t u16CheckCmdCnt = sInternals.cmd_count;
+#ifdef ENABLE_STATIC_COMMANDS
+	u16CheckCmdCnt += gshell_list_num_commands;
+#endif
+	if ((group == NULL) || (u16CheckCmdCnt >= _G_MAXCMD))
+	{
+		return -1;
+	}
+#ifdef G_ENABLE_ARGSCHEMA
+	if (cmd->argsCount > G_MAX_ARGS)
+	{
+		return -1;
+	}
+#endif
+
+	// Append the command at the end of the group's own chain
+	cmd->next = NULL;
+	if (group->sub == NULL)
+	{
+		group->sub = cmd;
+	}
+	else
+	{
+		for (last = group->sub; last->next != NULL; last = last->next);
+		last->next = cmd;
+	}
+
+	cmd->id = sInternals.cmd_count;
+	return sInternals.cmd_count++;
+}
+#endif
+
+// Returns the command ID from the string, returns -1 if it hasn't been found
+int16_t gshell_getCmdIDbyName(const char* cmd_name)
+{
+	int16_t cmdID = 0;
+	_gshellFindCmd(cmd_name, &cmdID);
+	return cmdID;
+}
+
+// Returns the command ID from the command structure pointer, returns -1 if it hasn't been found
+int16_t gshell_getCmdIDbyStruct(gshell_cmd_t *cmd)
+{
+	uint16_t u16_cnt;
+	const gshell_cmd_t *command;
+
+#ifdef G_ENABLE_SUBCOMMANDS
+	// Every registered command carries its ID, only the help command has ID zero
+	if ((cmd == &cmd_help) || (cmd->id > 0))
+	{
+		return cmd->id;
+	}
+	// Supress compiler warnings
+	(void)(command);
+	(void)(u16_cnt);
+#else
+
+	// Similar as _gshellFindCmd, but comparing the pointer addresses instead of the
+	// command's name
+	for (u16_cnt = 0; u16_cnt < sInternals.chain_len; u16_cnt++)
+	{
+		/* First entry always is cmd_help, from there follow the chain */
+		if (u16_cnt)
+		{
+			command = command->next;
+		}
+		else
+		{
+			command = &cmd_help;
+		}
+
+		if (command == cmd)	// Just compare the pointer addresses against eachother
+		{
+			return (int16_t)u16_cnt;
+		}
+	}
+#endif
+
+#ifdef ENABLE_STATIC_COMMANDS
+	/* Then check the command list */
+	for (u16_cnt = 0; u16_cnt < gshell_list_num_commands; u16_cnt++)
+	{
+		if (&gshell_list_commands[u16_cnt] == cmd)	// Just compare the pointer addresses against eachother
+		{
+			return (int16_t)(sInternals.cmd_count + u16_cnt);
+		}
+	}
+#endif
+
+	// If no ID has been returned by now, return -1
+	return -1;
+}
+
+#ifdef G_ENABLE_ARGSCHEMA
+const gshell_argval_t *gshell_args(void)
+{
+	return sThread.argValues;
+}
+
+uint8_t gshell_argGiven(uint8_t index)
+{
+	return (index < G_MAX_ARGS) && (sThread.argGivenMask & ((uint32_t)1 << index));
+}
+#endif
+
+#ifdef G_ENABLE_LOGHISTORY
+void gshell_logHistoryClear(void)
+{
+	_g_histhdr_t sState = {0};
+
+#ifdef G_ENABLE_WORKERS
+	_gshell_lock(1);
+#endif
+	_gshell_histPublish(&sState);
+#ifdef G_ENABLE_WORKERS
+	_gshell_lock(0);
+#endif
+}
+
+uint16_t gshell_logHistoryCount(void)
+{
+	return sHistory.hdr[sHistory.active].count;
+}
+#endif
+
+#ifdef G_ENABLE_RXRING
+/* Calls the watermark callback if the fill level went from below to at/above the watermark */
+static void _gshell_rxWatermark(uint16_t u16Before, uint16_t u16After)
+{
+	if ((sRxRing.fp_watermark != NULL) && (u16Before < sRxRing.watermark) && (u16After >= sRxRing.watermark))
+	{
+		sRxRing.fp_watermark(u16After);
+	}
+	if ((u16Before == 0) && (u16After != 0) && (sInternals.fp_wakeup != NULL))
+	{
+		// Ring was empty, the main loop may be asleep
+		sInternals.fp_wakeup();
+	}
+}
+
+uint8_t gshell_rxPush(char c)
+{
+	_g_rxidx_t head = sRxRing.head;
+	_g_rxidx_t fill = (_g_rxidx_t)(head - __atomic_load_n(&sRxRing.tail, __ATOMIC_ACQUIRE));
+
+	if (fill >= G_RXRING_SIZE)
+	{
+		sRxRing.overruns++;
+		return 0;
+	}
+
+	// Store first, then publish the character by moving the head
+	sRxRing.buf[head & (G_RXRING_SIZE - 1)] = c;
+	__atomic_store_n(&sRxRing.head, (_g_rxidx_t)(head + 1), __ATOMIC_RELEASE);
+
+	_gshell_rxWatermark(fill, fill + 1);
+	return 1;
+}
+
+uint16_t gshell_rxPushBlock(const char *data, uint16_t length)
+{
+	_g_rxidx_t head = sRxRing.head;
+	_g_rxidx_t fill = (_g_rxidx_t)(head - __atomic_load_n(&sRxRing.tail, __ATOMIC_ACQUIRE));
+	uint16_t u16Free = G_RXRING_SIZE - fill;
+	uint16_t u16_cnt;
+
+	if (length > u16Free)
+	{
+		sRxRing.overruns += length - u16Free;
+		length = u16Free;
+	}
+
+	for (u16_cnt = 0; u16_cnt < length; u16_cnt++)
+	{
+		sRxRing.buf[(_g_rxidx_t)(head + u16_cnt) & (G_RXRING_SIZE - 1)] = data[u16_cnt];
+	}
+	__atomic_store_n(&sRxRing.head, (_g_rxidx_t)(head + length), __ATOMIC_RELEASE);
+
+	_gshell_rxWatermark(fill, fill + length);
+	return length;
+}
+
+uint16_t gshell_rxOverruns(void)
+{
+	return sRxRing.overruns;
+}
+
+void gshell_rxSetWatermark(uint16_t level, void (*callback)(uint16_t fill))
+{
+	sRxRing.fp_watermark = NULL;
+	sRxRing.watermark = level;
+	sRxRing.fp_watermark = callback;
+}
+#endif
+
+#ifdef G_ENABLE_WATCH
+/* Runs the watched command if it is due, returns 1 if it returned a value */
+static uint8_t _gshell_watchRun(gshell_result_t *psResult)
+{
+	uint32_t u32Now = (sInternals.fp_msTimeStamp != NULL) ? sInternals.fp_msTimeStamp() : 0;
+	uint8_t u8CmdRet = 0;
+	uint8_t bClear;
+#ifdef G_ENABLE_SESSIONS
+	gshell_session_t *psPrevious = sThread.session;
+#endif
+
+	if ((u32Now - sWatch.lastRun) < sWatch.interval)
+	{
+		return 0;
+	}
+	sWatch.lastRun = u32Now;
+
+	// The output goes to the terminal 'watch' was entered on
+#ifdef G_ENABLE_SESSIONS
+	sThread.session = sWatch.session;
+#endif
+	bClear = sWatch.clear;
+#ifdef G_ENABLE_TERMPROFILES
+	if (_G_SES.termProfile == GSHELL_TERM_PLAIN)
+	{
+		bClear = 0;
+	}
+#endif
+	if (bClear)
+	{
+		// Overwrite the previous output in place
+		gshell_putString(G_CURSORHOME);
+	}
+	else if (_G_SES.promtEnabled)
+	{
+		_gshell_clearLine();
+	}
+
+	// Fresh copy of the arguments, the handler may have modified them last time
+	memcpy(sWatch.work, sWatch.args, sWatch.argsLen);
+#ifdef G_ENABLE_ARGSCHEMA
+	// Valid since 'watch' checked them, the values just have to be converted again
+	if (sWatch.command->args != NULL)
+	{
+		_gshell_parseArgs(sWatch.command, sWatch.argc, sWatch.argv);
+	}
+#endif
+	u8CmdRet = _gshell_callCmd(sWatch.command, sWatch.argc, sWatch.argv, sWatch.argl);
+#ifdef G_ENABLE_RESULTQUEUE
+	_gshell_resultPush(sWatch.cmdID, u8CmdRet, GSHELL_RESF_SCHEDULED);
+#endif
+
+	if (bClear)
+	{
+		// Remove what is left of the previous, longer output
+		gshell_putString(G_CLEARDOWN);
+	}
+	if (_G_SES.promtEnabled)
+	{
+		_gshell_putPromt();
+	}
+	if ((sWatch.remaining != 0) && (--sWatch.remaining == 0))
+	{
+		sWatch.command = NULL;
+	}
+#ifdef G_ENABLE_SESSIONS
+	sThread.session = psPrevious;
+#endif
+
+	if (u8CmdRet)
+	{
+		psResult->cmdID = sWatch.cmdID;
+		psResult->value = u8CmdRet;
+		return 1;
+	}
+	return 0;
+}
+#endif
+
+#ifdef G_ENABLE_WATCH
+/* Milliseconds until the watched command of the selected session is due, GSHELL_NODEADLINE if none */
+static uint32_t _gshell_watchDue(void)
+{
+	uint32_t u32Elapsed;
+
+	if ((sWatch.command == NULL) || (sWatch.session != &_G_SES))
+	{
+		return GSHELL_NODEADLINE;
+	}
+	// Without a interval (or a timestamp) the command runs on every gshell_poll
+	if ((sWatch.interval == 0) || (sInternals.fp_msTimeStamp == NULL))
+	{
+		return 0;
+	}
+	u32Elapsed = sInternals.fp_msTimeStamp() - sWatch.lastRun;
+	return (u32Elapsed >= sWatch.interval) ? 0 : (sWatch.interval - u32Elapsed);
+}
+#endif
+
+enum gshell_return gshell_poll(gshell_result_t *result)
+{
+	enum gshell_return eRet = GSHELL_OK;
+#ifdef G_ENABLE_RXRING
+	_g_rxidx_t head = __atomic_load_n(&sRxRing.head, __ATOMIC_ACQUIRE);
+	_g_rxidx_t tail = sRxRing.tail;
+
+	// Stop after a executed command, so the caller can act on its result before the next one
+	while ((tail != head) && (eRet != GSHELL_CMDRET))
+	{
+		char c = sRxRing.buf[tail & (G_RXRING_SIZE - 1)];
+
+		// Free the slot right away, the producer may refill it while the command runs
+		tail++;
+		__atomic_store_n(&sRxRing.tail, tail, __ATOMIC_RELEASE);
+		eRet = gshell_processShellEx(c, result);
+	}
+#endif
+#ifdef G_ENABLE_WATCH
+	// Only for the session it was entered on, its result belongs to that terminal
+	if ((eRet != GSHELL_CMDRET) && (sWatch.command != NULL) && (sWatch.session == &_G_SES) && _gshell_watchRun(result))
+	{
+		eRet = GSHELL_CMDRET;
+	}
+#endif
+#ifdef G_ENABLE_DEFERPROMPT
+	if ((_G_SES.promtEnabled) && (_gshell_promtDue() == 0))
+	{
+		_gshell_redrawPromt();
+	}
+#endif
+#if !defined(G_ENABLE_RXRING) && !defined(G_ENABLE_WATCH)
+	// Supress compiler warning
+	(void)(result);
+#endif
+	return eRet;
+}
+
+uint8_t gshell_hasPendingWork(void)
+{
+	uint8_t u8Work = 0;
+#ifdef G_ENABLE_LOGSINKS
+	gshell_sink_t *sink;
+#endif
+
+#ifdef G_ENABLE_RXRING
+	if (__atomic_load_n(&sRxRing.head, __ATOMIC_ACQUIRE) != sRxRing.tail)
+	{
+		u8Work |= GSHELL_WORK_RX;
+	}
+#endif
+#ifdef G_ENABLE_TXQUEUES
+	if (gshell_txPending() != 0)
+	{
+		u8Work |= GSHELL_WORK_TX;
+	}
+#endif
+#ifdef G_ENABLE_LOGSINKS
+	for (sink = sInternals.sinks; sink != NULL; sink = sink->next)
+	{
+		if (sink->bufFill != 0)
+		{
+			u8Work |= GSHELL_WORK_SINKS;
+			break;
+		}
+	}
+#endif
+#ifdef G_ENABLE_WATCH
+	if ((sWatch.command != NULL) && (_gshell_watchDue() == 0))
+	{
+		u8Work |= GSHELL_WORK_TIMER;
+	}
+#endif
+#ifdef G_ENABLE_DEFERPROMPT
+	if (_G_SES.promtEnabled && (_gshell_promtDue() == 0))
+	{
+		u8Work |= GSHELL_WORK_PROMPT;
+	}
+#endif
+	return u8Work;
+}
+
+uint32_t gshell_nextDeadline(void)
+{
+	uint32_t u32Deadline = GSHELL_NODEADLINE;
+
+#ifdef G_ENABLE_WATCH
+	u32Deadline = _gshell_watchDue();
+#endif
+#ifdef G_ENABLE_DEFERPROMPT
+	if (_G_SES.promtEnabled && (_gshell_promtDue() < u32Deadline))
+	{
+		u32Deadline = _gshell_promtDue();
+	}
+#endif
+	return u32Deadline;
+}
+
+void gshell_setWakeup(void (*wakeup)(void))
+{
+	sInternals.fp_wakeup = wakeup;
+}
+
+#ifdef G_ENABLE_RESULTQUEUE
+void gshell_setResult(uint32_t value)
+{
+	sThread.resultValue = value;
+	sThread.resultPosted = 1;
+}
+
+uint8_t gshell_popResult(gshell_resultrec_t *record)
+{
+	uint8_t tail = sResults.tail;
+
+	if (tail == __atomic_load_n(&sResults.head, __ATOMIC_ACQUIRE))
+	{
+		return 0;
+	}
+	*record = sResults.rec[tail & (G_RESULTQUEUE_SIZE - 1)];
+	__atomic_store_n(&sResults.tail, (uint8_t)(tail + 1), __ATOMIC_RELEASE);
+	return 1;
+}
+
+uint16_t gshell_resultOverruns(void)
+{
+	return sResults.overruns;
+}
+
+#ifdef G_ENABLE_WORKERS
+uint8_t gshell_resultPosted(uint32_t *value)
+{
+	*value = sThread.resultValue;
+	return sThread.resultPosted;
+}
+
+void gshell_resultReport(int16_t cmdID, uint8_t status, uint32_t value, uint8_t posted)
+{
+	_gshell_resultQueue(cmdID, status, value, posted ? GSHELL_RESF_VALUE : 0);
+}
+#endif
+#endif
+
+#ifdef G_ENABLE_TRACE
+void gshell_traceClock(uint32_t (*get_tick)(void), uint32_t ticksPerSecond)
+{
+	sTrace.fp_getTick = get_tick;
+	sTrace.ticksPerSecond = ticksPerSecond;
+}
+
+void gshell_traceEvent(enum gshell_tracetype type, const _GMEMX char *name, uint8_t ctx)
+{
+	uint32_t u32Tick;
+	uint16_t u16Idx;
+
+	if (sTrace.paused)	return;
+
+	u32Tick = (sTrace.fp_getTick != NULL) ? sTrace.fp_getTick() : 0;
+
+	// Claiming the slot atomically, events may also be recorded within interrupts
+#ifdef _G_TRACE_ENTER
+	{
+		_G_TRACE_ENTER();
+		u16Idx = sTrace.head++ & (G_TRACE_SIZE - 1);
+		_G_TRACE_EXIT();
+	}
+#else
+	u16Idx = __atomic_fetch_add(&sTrace.head, 1, __ATOMIC_RELAXED) & (G_TRACE_SIZE - 1);
+#endif
+	if (u16Idx == (G_TRACE_SIZE - 1))
+	{
+		sTrace.wrapped = 1;
+	}
+
+	sTrace.events[u16Idx].name = name;
+	sTrace.events[u16Idx].tick = u32Tick;
+	sTrace.events[u16Idx].type = (uint8_t)type;
+	sTrace.events[u16Idx].ctx = ctx;
+}
+#endif
+
+void gshell_setActive(uint8_t activeStatus)
+{
+	// Set active means all activities are enabled...
+	if (activeStatus)
+	{
+		_G_SES.isActive = 1;
+	}
+	else
+	{
+		//... or halted if disabled! No printing of any functions, input is ignored
+		_G_SES.isActive = 0;
+	}
+}
+
+void gshell_setPromt(uint8_t promtStatus)
+{
+	if (promtStatus)
+	{
+		// Enabling the prompt? Check if it has already been enabled...
+		if (_G_SES.promtEnabled == 0)
+		{
+			// .. if no, print the prompt and enable it internally
+			_G_SES.promtEnabled = 1;
+			_gshell_putPromt();
+		}
+	}
+	else
+	{
+		// If the promt was enabled before, erase it from the terminal screen
+		if (_G_SES.promtEnabled)
+		{
+			_gshell_clearLine();
+		}
+		_G_SES.promtEnabled = 0;
+	}
+}
+
+#ifdef G_ENABLE_SESSIONS
+void gshell_sessionInit(gshell_session_t *session, void (*put_char)(char))
+{
+	_gshell_sessionReset(session, put_char);
+}
+
+void gshell_sessionClose(gshell_session_t *session)
+{
+#ifdef G_ENABLE_WATCH
+	if (sWatch.session == session)
+	{
+		sWatch.command = NULL;
+		sWatch.session = NULL;
+	}
+#endif
+	if (sThread.session == session)
+	{
+		sThread.session = &sInternals.mainSession;
+	}
+}
+
+gshell_session_t *gshell_sessionSelect(gshell_session_t *session)
+{
+	gshell_session_t *psPrevious = sThread.session;
+
+	sThread.session = (session != NULL) ? session : &sInternals.mainSession;
+	return psPrevious;
+}
+
+gshell_session_t *gshell_sessionGet(void)
+{
+	return sThread.session;
+}
+#endif
+
+#ifdef G_ENABLE_WORKERS
+void gshell_setDispatcher(uint8_t (*dispatch)(const gshell_cmd_t *cmd, int16_t cmdID, uint8_t argc, char *argv[]))
+{
+	sInternals.fp_dispatch = dispatch;
+}
+
+uint8_t gshell_runCmd(const gshell_cmd_t *cmd, uint8_t argc, char *argv[])
+{
+	uint8_t argl[G_MAX_ARGS];
+	uint8_t u8_cnt;
+
+	for (u8_cnt = 0; (u8_cnt < argc) && (u8_cnt < G_MAX_ARGS); u8_cnt++)
+	{
+		argl[u8_cnt] = (uint8_t)strlen(argv[u8_cnt]);
+	}
+#ifdef G_ENABLE_ARGSCHEMA
+	// Checked already by the input thread, this fills in the values of gshell_args for this thread
+	if ((cmd->args != NULL) && _gshell_parseArgs(cmd, argc, argv))
+	{
+		return 0;
+	}
+#endif
+	return _gshell_callCmd(cmd, argc, argv, argl);
+}
+
+void gshell_setLock(void (*lock)(uint8_t acquire))
+{
+	sInternals.fp_lock = lock;
+}
+
+/* Takes / releases the lock of the shared log state, if one has been set */
+static void _gshell_lock(uint8_t bAcquire)
+{
+	if (sInternals.fp_lock != NULL)
+	{
+		sInternals.fp_lock(bAcquire);
+	}
+}
+#endif
+
+#ifdef G_ENABLE_TERMPROFILES
+void gshell_setTermProfile(enum gshell_termprofile profile)
+{
+	_G_SES.termProfile = (uint8_t)profile;
+	// Cancel a running detection, the user has chosen
+	_G_SES.daState = DA_IDLE;
+}
+
+enum gshell_termprofile gshell_getTermProfile(void)
+{
+	return (enum gshell_termprofile)_G_SES.termProfile;
+}
+
+void gshell_detectTermProfile(void)
+{
+	// Plain text until the terminal proves otherwise
+	_G_SES.termProfile = GSHELL_TERM_ANSI;
+	gshell_putString(_G_DAQUERY);
+	_G_SES.termProfile = GSHELL_TERM_PLAIN;
+	_G_SES.daSince = (sInternals.fp_msTimeStamp != NULL) ? sInternals.fp_msTimeStamp() : 0;
+	_G_SES.daState = DA_WAIT;
+}
+#endif
+
+/*** WIP WIP WIP - Do not enable G_ENABLE_INESCAPES - WIP WIP WIP ***/
+/**
+ * @brief Enables incoming Escape-Sequence Processing
+ */
+//#define G_ENABLE_INESCAPES
+
+uint16_t gshell_processShell(char c)
+{
+	gshell_result_t sResult;
+	enum gshell_return eRet = gshell_processShellEx(c, &sResult);
+
+	// Packed legacy format: Command return value on the upper half of the word,
+	// and the command's ID (lower 7 bits only) on the lower half.
+	if (eRet == GSHELL_CMDRET)
+	{
+		return ((uint16_t)sResult.value << 8) | (GSHELL_CMDRET | (sResult.cmdID & GSHELL_CMDRET_MASK));
+	}
+	return eRet;
+}
+
+enum gshell_return gshell_processShellEx(char c, gshell_result_t *result)
+{
+#ifdef G_ENABLE_INESCAPES
+	static uint8_t u8EscapeSequenceCnt = 0;
+	static char cEscapeSequenceBuf[ESCSEQ_BUFLEN];
+	int32_t i32EscapeSequenceValue= 0;
+#endif
+
+	// Main function to process each incoming character!
+	// CR/LF or \0 is ignored
+	if ((c == _G_ENT_IGNORE) || (c == '\0'))
+	{
+		return GSHELL_OK;
+	}
+
+#ifdef G_ENABLE_TERMPROFILES
+	/* Device Attributes response to gshell_detectTermProfile, ESC [ ? Ps ; ... c
+	 * The answer arrives right after the query, without a answer in time the terminal doesn't understand it */
+	if ((_G_SES.daState != DA_IDLE) && (sInternals.fp_msTimeStamp != NULL) &&
+		((sInternals.fp_msTimeStamp() - _G_SES.daSince) >= _G_DA_TIMEOUT))
+	{
+		_G_SES.daState = DA_IDLE;
+	}
+	if (_G_SES.daState != DA_IDLE)
+	{
+		if ((c == 0x1B) && (_G_SES.daState == DA_WAIT))
+		{
+			_G_SES.daState = DA_ESC;
+			return GSHELL_ESCSEQ;
+		}
+		else if ((c == '[') && (_G_SES.daState == DA_ESC))
+		{
+			_G_SES.daState = DA_CSI;
+			return GSHELL_ESCSEQ;
+		}
+		else if ((c == '?') && (_G_SES.daState == DA_CSI))
+		{
+			_G_SES.daState = DA_PARAM;
+			return GSHELL_ESCSEQ;
+		}
+		else if ((_G_SES.daState == DA_PARAM) && (((c >= '0') && (c <= '9')) || (c == ';')))
+		{
+			return GSHELL_ESCSEQ;
+		}
+		else if ((_G_SES.daState == DA_PARAM) && (c == 'c'))
+		{
+			// The terminal answered, so it understands ANSI escape sequences
+			_G_SES.daState = DA_IDLE;
+			_G_SES.termProfile = GSHELL_TERM_ANSI;
+			return GSHELL_ESCSEQ;
+		}
+		// Anything else is user input, the terminal didn't answer: stop waiting and process it
+		_G_SES.daState = DA_IDLE;
+	}
+#endif
+
+	if ((_G_SES.isActive == 0) || (_G_SES.promtEnabled == 0))
+	{
+		// If the shell isn't even set active, avoid any further processing!
+		return GSHELL_INACTIVE;
+	}
+
+#ifdef G_ENABLE_DEFERPROMPT
+	// The input is echoed right behind the promt
+	_gshell_redrawPromt();
+#endif
+#ifdef G_ENABLE_TXQUEUES
+	_gshell_txRedraw(1);
+#endif
+
+#ifdef G_ENABLE_WATCH
+	// Any key stops 'watch' / 'repeat' running on this terminal, and is dropped
+	if ((sWatch.command != NULL) && (sWatch.session == &_G_SES))
+	{
+		sWatch.command = NULL;
+		return GSHELL_OK;
+	}
+#endif
+
+#ifdef G_ENABLE_INESCAPES
+	/* ANSI Escape Sequence check & processing */
+	if ((u8EscapeSequenceCnt) || (c == 0x1B))
+	{
+		if (u8EscapeSequenceCnt)
+		{
+			if ((u8EscapeSequenceCnt == 1) && (c == '['))
+			{
+				u8EscapeSequenceCnt = 2;
+			}
+			else
+			{
+				// Letter, number or something else received?
+				if (((c >=0x41) && (c <= 0x5A)) || ((c >= 0x61) && (c <= 0x7A)))
+				{
+					// Letter received! Finish sequence handling
+					// and process it.
+
+				}
+				else if ((c >= 0x30) && (c <= 0x39))
+				{
+					// Number received!
+
+				}
+				else
+				{
+					// Something else received!
+				}
+			}
+		}
+		else
+		{
+			u8EscapeSequenceCnt = 1;
+		}
+
+		return GSHELL_OK;
+	}
+#endif
+
+	/* Backspace handling */
+	if ((c == C_BACKSPCE1) || (c == C_BACKSPCE2))
+	{
+		// Interpreting backspace, removing the character from the input buffer
+		// and removing it also from the user's screen!
+
+		if (_G_SES.rx_index > 0)
+		{
+			_G_SES.rx_buf[--_G_SES.rx_index] = C_NULLCHAR;
+			_gshell_echo(c);
+		}
+		return GSHELL_OK;
+	}
+	else if (_G_SES.rx_index >= G_RX_BUFSIZE)
+	{
+		// Input buffer full? Stop processing and inform the user!
+		return GSHELL_BUFFULL;
+	}
+
+	// Echo the (valid) character back to the terminal/user
+#ifdef G_CR_INSTEADOF_LF
+	// Some terminals send a CR instead of LF, handle things here-
+	if (c == _G_ENT_PROCESS)
+	{
+		_gshell_echo(_G_ENT_IGNORE);
+	}
+	else
+	{
+		_gshell_echo(c);
+	}
+#else
+	_gshell_echo(c);
+#endif
+
+	// Storing the received character, increading index
+	_G_SES.rx_buf[_G_SES.rx_index++] = c;
+
+	// Call the main processing function, return it's return-value
+	return _gshell_process(result);
+}
+
+#ifdef _G_SCAN_BULK
+/* Printable characters are just stored and echoed, unless something else waits for input */
+static uint8_t _gshell_scanReady(void)
+{
+	if ((_G_SES.isActive == 0) || (_G_SES.promtEnabled == 0))
+	{
+		return 0;
+	}
+#ifdef G_ENABLE_TERMPROFILES
+	if (_G_SES.daState != DA_IDLE)
+	{
+		return 0;
+	}
+#endif
+#ifdef G_ENABLE_WATCH
+	if ((sWatch.command != NULL) && (sWatch.session == &_G_SES))
+	{
+		return 0;
+	}
+#endif
+	return 1;
+}
+
+/* Same as gshell_processShellEx for a run of printable characters */
+static void _gshell_scanInput(const char *data, uint16_t length)
+{
+#ifdef G_ENABLE_DEFERPROMPT
+	_gshell_redrawPromt();
+#endif
+#ifdef G_ENABLE_TXQUEUES
+	_gshell_txRedraw(1);
+#endif
+	memcpy(_G_SES.rx_buf + _G_SES.rx_index, data, length);
+	_G_SES.rx_index += length;
+#ifdef G_ENABLE_ECHO
+	while (length--)
+	{
+		gshell_putChar(*data++);
+	}
+#endif
+}
+#endif
+
+enum gshell_return gshell_processShellBuffer(const char *data, uint16_t length, uint16_t *consumed, gshell_result_t *result)
+{
+	enum gshell_return eRet = GSHELL_OK;
+	uint16_t u16Pos = 0;
+#ifdef _G_SCAN_BULK
+	uint16_t u16Run;
+#endif
+
+	// Stop after a executed command, so the caller can act on its result before the next one
+	while ((u16Pos < length) && (eRet != GSHELL_CMDRET))
+	{
+#ifdef _G_SCAN_BULK
+		// Printable runs go into the input buffer at once, control characters
+		// (enter, backspace, escape sequences) one by one below
+		if (_gshell_scanReady())
+		{
+			u16Run = _gshell_scanPlain(data + u16Pos, length - u16Pos);
+			if (u16Run > G_RX_BUFSIZE - _G_SES.rx_index)
+			{
+				u16Run = G_RX_BUFSIZE - _G_SES.rx_index;
+			}
+			if (u16Run > 0)
+			{
+				_gshell_scanInput(data + u16Pos, u16Run);
+				u16Pos += u16Run;
+				eRet = GSHELL_OK;
+				continue;
+			}
+		}
+#endif
+		eRet = gshell_processShellEx(data[u16Pos++], result);
+	}
+
+	if (consumed != NULL)
+	{
+		*consumed = u16Pos;
+	}
+	return eRet;
+}
+
+void gshell_putChar(char c)
+{
+	// If shell is not inactive, print character
+	if (_G_SES.isActive == 0)	return;
+#ifdef G_ENABLE_TERMPROFILES
+	// Compact profiles hold back escape sequences and drop the unsupported ones
+	if ((_G_SES.termProfile != GSHELL_TERM_ANSI) && _gshell_filterEscape(c))	return;
+#endif
+	_G_OUT(c);
+}
+
+void gshell_putStringRAM(const char *str)
+{
+	// If shell is not inactive, print string
+	if (_G_SES.isActive == 0)	return;
+	while (*str)
+	{
+		gshell_putChar(*str++);
+	}
+}
+
+void gshell_putString_flash(const _GMEMX char *progmem_s)
+{
+	char character;
+
+	// If shell is not inactive, print string from program memory
+	if (_G_SES.isActive == 0)	return;
+
+	while ( (character = *progmem_s++) )
+	{
+		gshell_putChar(character);
+	}
+}
+
+void gshell_printf_flash(const _GMEMX char *progmem_s, ...)
+{
+	va_list args;
+	// If shell is not inactive, return directly back
+	if (_G_SES.isActive == 0)	return;
+	
+	// Printf with the main string stored in the program memory! First get the argument list
+	va_start(args, progmem_s);
+#ifdef AVR
+	// Copy the program-memory string into the SRAM memory, store it in the
+	// additional vsprintf buffer for further processing
+	// Handle printf-processing via vsprintf
+	strncpy_PF(sThread.tempBuf, (__uint24)progmem_s, G_RX_BUFSIZE);
+	vsprintf(sThread.vsprintf_buf, sThread.tempBuf, args);
+#else
+	// Handle printf-processing via vsprintf
+	vsprintf(sThread.vsprintf_buf, progmem_s, args);
+#endif
+	va_end(args);
+	
+	// Print the result of vsprintf back to the user
+	gshell_putStringRAM(sThread.vsprintf_buf);
+}
+
+#ifdef G_ENABLE_TXQUEUES
+uint16_t gshell_txDrain(uint16_t maxChars)
+{
+	uint16_t u16Sent = 0;
+
+	while ((gshell_txPending() > 0) && ((maxChars == 0) || (u16Sent < maxChars)))
+	{
+		_gshell_txSend();
+		u16Sent++;
+		_gshell_txRedraw(0);
+	}
+	return u16Sent;
+}
+
+uint16_t gshell_txPending(void)
+{
+	uint16_t u16Pending = 0;
+	uint8_t u8Queue;
+
+	for (u8Queue = 0; u8Queue < _G_TXQ_COUNT; u8Queue++)
+	{
+		u16Pending += (uint16_t)(_G_SES.txq[u8Queue].head - _G_SES.txq[u8Queue].tail);
+	}
+	return u16Pending;
+}
+#endif
+
+/* Writes the decimal digits of u32Val, zero padded to u8MinDigits (10 at most)
+ * Returns the amount of characters written, pcBuf isn't terminated */
+static uint8_t _gshell_fmtU32(char *pcBuf, uint32_t u32Val, uint8_t u8MinDigits)
+{
+	char cDigits[10];
+	uint8_t u8Pos = sizeof(cDigits);
+	uint8_t u8Pair;
+
+	// Two digits per division, straight from the table
+	while (u32Val >= 100)
+	{
+		u8Pair = (uint8_t)(u32Val % 100) * 2;
+		u32Val /= 100;
+		cDigits[--u8Pos] = dec_pairs[u8Pair + 1];
+		cDigits[--u8Pos] = dec_pairs[u8Pair];
+	}
+	if (u32Val >= 10)
+	{
+		u8Pair = (uint8_t)u32Val * 2;
+		cDigits[--u8Pos] = dec_pairs[u8Pair + 1];
+		cDigits[--u8Pos] = dec_pairs[u8Pair];
+	}
+	else
+	{
+		cDigits[--u8Pos] = '0' + (char)u32Val;
+	}
+	while ((u8Pos > 0) && ((uint8_t)(sizeof(cDigits) - u8Pos) < u8MinDigits))
+	{
+		cDigits[--u8Pos] = '0';
+	}
+
+	memcpy(pcBuf, &cDigits[u8Pos], sizeof(cDigits) - u8Pos);
+	return (uint8_t)(sizeof(cDigits) - u8Pos);
+}
+
+/* Writes u8Width hex digits of u32Val, pcBuf isn't terminated */
+static void _gshell_fmtHex(char *pcBuf, uint32_t u32Val, uint8_t u8Width)
+{
+	while (u8Width)
+	{
+		pcBuf[--u8Width] = hex_digits[u32Val & 0x0F];
+		u32Val >>= 4;
+	}
+}
+
+/* Prints the timestamp of a log message, "[%09u] " */
+static void _gshell_putTimestamp(uint32_t u32Timestamp)
+{
+	char cBuf[14];
+	uint8_t u8Len = 1;
+
+	cBuf[0] = '[';
+	u8Len += _gshell_fmtU32(&cBuf[1], u32Timestamp, 9);
+	cBuf[u8Len++] = ']';
+	cBuf[u8Len++] = ' ';
+	cBuf[u8Len] = C_NULLCHAR;
+	gshell_putStringRAM(cBuf);
+}
+
+#ifdef G_ENABLE_TIMESTAMP64
+/* Prints the high-resolution timestamp of a log message, "[sssss.uuuuuu] ".
+ * The seconds are only rendered again once they changed */
+static void _gshell_putTimestamp64(void)
+{
+	char cBuf[sizeof(sTime.prefix)];
+	char cSec[10];
+	uint64_t u64Now, u64Ticks;
+	uint32_t u32Sec, u32Micro;
+	uint8_t u8Pos = 0;
+	uint8_t u8Len;
+
+#ifdef G_ENABLE_WORKERS
+	_gshell_lock(1);
+#endif
+	u64Now = sTime.fp_getTicks();
+	u64Ticks = (sTime.mode == GSHELL_TS_DELTA) ? (u64Now - sTime.lastTicks) : u64Now;
+	sTime.lastTicks = u64Now;
+	u32Sec = (uint32_t)(u64Ticks / sTime.ticksPerSecond);
+	// The remainder is below ticksPerSecond, so the product fits into 64 bits
+	u32Micro = (uint32_t)((u64Ticks % sTime.ticksPerSecond) * 1000000u / sTime.ticksPerSecond);
+
+	if ((sTime.fracPos == 0) || (u32Sec != sTime.seconds))
+	{
+		sTime.prefix[u8Pos++] = '[';
+		if (sTime.mode == GSHELL_TS_DELTA)
+		{
+			sTime.prefix[u8Pos++] = '+';
+		}
+		u8Len = _gshell_fmtU32(cSec, u32Sec, 0);
+		while (u8Pos + u8Len < _G_TS64_SECDIGITS + 1 + (sTime.mode == GSHELL_TS_DELTA))
+		{
+			sTime.prefix[u8Pos++] = ' ';
+		}
+		memcpy(&sTime.prefix[u8Pos], cSec, u8Len);
+		u8Pos += u8Len;
+		sTime.prefix[u8Pos++] = '.';
+		sTime.fracPos = u8Pos;
+		u8Pos += _G_TS64_FRACDIGITS;
+		sTime.prefix[u8Pos++] = ']';
+		sTime.prefix[u8Pos++] = ' ';
+		sTime.prefix[u8Pos] = C_NULLCHAR;
+		sTime.seconds = u32Sec;
+	}
+	_gshell_fmtU32(&sTime.prefix[sTime.fracPos], u32Micro, _G_TS64_FRACDIGITS);
+	memcpy(cBuf, sTime.prefix, sizeof(cBuf));
+#ifdef G_ENABLE_WORKERS
+	_gshell_lock(0);
+#endif
+	gshell_putStringRAM(cBuf);
+}
+
+void gshell_setTimeSource(uint64_t (*get_ticks)(void), uint32_t ticksPerSecond)
+{
+	sTime.fp_getTicks = NULL;
+	sTime.ticksPerSecond = (ticksPerSecond != 0) ? ticksPerSecond : 1;
+	sTime.lastTicks = 0;
+	sTime.fracPos = 0;
+	sTime.fp_getTicks = get_ticks;
+}
+
+void gshell_setTimestampMode(enum gshell_tsmode mode)
+{
+	sTime.mode = (uint8_t)mode;
+	sTime.fracPos = 0;
+}
+#endif
+
+void gshell_putU32(uint32_t value)
+{
+	char cBuf[11];
+
+	cBuf[_gshell_fmtU32(cBuf, value, 0)] = C_NULLCHAR;
+	gshell_putStringRAM(cBuf);
+}
+
+void gshell_putI32(int32_t value)
+{
+	char cBuf[12];
+	uint32_t u32Magnitude = (uint32_t)value;
+	uint8_t u8Len = 0;
+
+	if (value < 0)
+	{
+		cBuf[u8Len++] = '-';
+		u32Magnitude = 0u - u32Magnitude;
+	}
+	u8Len += _gshell_fmtU32(&cBuf[u8Len], u32Magnitude, 0);
+	cBuf[u8Len] = C_NULLCHAR;
+	gshell_putStringRAM(cBuf);
+}
+
+void gshell_putHex(uint32_t value, uint8_t width)
+{
+	char cBuf[9];
+
+	if ((width == 0) || (width > 8))
+	{
+		// As many digits as required, at least one
+		for (width = 1; (width < 8) && (value >> (width * 4)); width++);
+	}
+	_gshell_fmtHex(cBuf, value, width);
+	cBuf[width] = C_NULLCHAR;
+	gshell_putStringRAM(cBuf);
+}
+
+void gshell_hexdump(const void *data, uint16_t length, uint32_t base)
+{
+	const uint8_t *pu8Data = (const uint8_t *)data;
+	char cLine[_G_HEXDUMP_LINELEN];
+	uint8_t u8_cnt;
+	uint8_t u8Count;
+
+	if (_G_SES.isActive == 0)	return;
+
+	// "AAAAAAAA: XX XX .. XX  ascii", one complete line at a time. Counting the
+	// remaining bytes down, a position counted up would wrap close to 64 KiB
+	while (length > 0)
+	{
+		u8Count = (length < _G_HEXDUMP_BYTES) ? (uint8_t)length : _G_HEXDUMP_BYTES;
+		memset(cLine, ' ', sizeof(cLine));
+		_gshell_fmtHex(cLine, base, 8);
+		cLine[8] = ':';
+		for (u8_cnt = 0; u8_cnt < u8Count; u8_cnt++)
+		{
+			uint8_t u8Byte = pu8Data[u8_cnt];
+
+			cLine[10 + u8_cnt * 3] = hex_digits[u8Byte >> 4];
+			cLine[11 + u8_cnt * 3] = hex_digits[u8Byte & 0x0F];
+			cLine[11 + _G_HEXDUMP_BYTES * 3 + u8_cnt] = ((u8Byte >= 0x20) && (u8Byte < 0x7F)) ? (char)u8Byte : '.';
+		}
+		u8_cnt = 11 + _G_HEXDUMP_BYTES * 3 + u8Count;
+		cLine[u8_cnt++] = C_CARRET;
+		cLine[u8_cnt++] = C_NEWLINE;
+		cLine[u8_cnt] = C_NULLCHAR;
+		gshell_putStringRAM(cLine);
+
+		pu8Data += u8Count;
+		base += u8Count;
+		length -= u8Count;
+	}
+}
+
+void gshell_putStringAsync(const char *str)
+{
+	if (_G_SES.isActive == 0)	return;
+
+	// Same as logging: erase the promt and input, print, then restore both
+	if (_G_SES.promtEnabled)
+	{
+		_gshell_clearLine();
+	}
+	gshell_putStringRAM(str);
+	if (_G_SES.promtEnabled)
+	{
+		_gshell_restorePromt();
+	}
+}
+
+/* Logging core of gshell_log_flash and gshell_logSrc_flash, file is NULL without a source location */
+static void _gshell_vlogPrint(enum glog_level loglvl, const _GMEMX char *file, uint16_t line, const _GMEMX char *logText, va_list args)
+{
+	uint32_t timestamp = 0;
+	int iLength;
+	uint8_t bConsole = _G_SES.isActive;
+	uint8_t bText = 1;
+#if defined(G_ENABLE_LOGSINKS) || defined(G_ENABLE_LOGFORMAT)
+	gshell_logrec_t sRecord;
+#endif
+
+#ifdef G_ENABLE_LOGSINKS
+	// The terminal has its own level filter, just like the sinks
+	if (loglvl < sInternals.consoleLevel)	bConsole = 0;
+#endif
+#ifdef G_ENABLE_LOGFORMAT
+	// Structured records are encoded as a whole once the message has been formatted
+	bText = (_G_SES.logFormat == GSHELL_LOGFMT_TEXT);
+#endif
+
+	// If a timestamp function pointer has been given, call it to get the ms-Tick
+	if (sInternals.fp_msTimeStamp != NULL)
+	{
+		timestamp = sInternals.fp_msTimeStamp();
+	}
+
+	if (bConsole && bText)
+	{
+		// If the promt is enabled, it is likely also printed out -> erase it (and anything typed by the user)
+		if (_G_SES.promtEnabled)
+		{
+			_gshell_clearLine();
+		}
+
+		// Print the logging level
+#ifdef G_ENABLE_TERMPROFILES
+		if (_G_SES.termProfile != GSHELL_TERM_ANSI)
+		{
+			gshell_putString_flash(console_levels_plain[loglvl]);
+		}
+		else
+#endif
+		gshell_putString_flash(console_levels[loglvl]);
+
+		// Print the msTick / Timestamp
+#ifdef G_ENABLE_TIMESTAMP64
+		if (sTime.fp_getTicks != NULL)
+		{
+			_gshell_putTimestamp64();
+		}
+		else
+#endif
+		if (sInternals.fp_msTimeStamp != NULL)
+		{
+			_gshell_putTimestamp(timestamp);
+		}
+
+		// Print the source location
+		if (file != NULL)
+		{
+			gshell_putChar('[');
+			gshell_putString_flash(file);
+			gshell_putChar(':');
+			gshell_putU32(line);
+			gshell_putString("] ");
+		}
+	}
+#ifndef _G_LOG_ALWAYS
+	else if (bConsole == 0)
+	{
+		// Shell not set active and nobody else interested? Abort further processing!
+		return;
+	}
+#endif
+
+	// Similar "printf / vsprintf" processing as in gshell_printf_flash
+#ifdef AVR
+	strncpy_PF(sThread.tempBuf, (__uint24)logText, G_RX_BUFSIZE);
+	iLength = vsprintf(sThread.vsprintf_buf, sThread.tempBuf, args);
+#else
+	iLength = vsprintf(sThread.vsprintf_buf, logText, args);
+#endif
+
+#if defined(G_ENABLE_LOGSINKS) || defined(G_ENABLE_LOGFORMAT)
+	sRecord.level = loglvl;
+	sRecord.timestamp = timestamp;
+	sRecord.text = sThread.vsprintf_buf;
+	sRecord.length = (iLength > 0) ? (uint16_t)iLength : 0;
+	sRecord.file = file;
+	sRecord.line = line;
+#else
+	// Supress compiler warning
+	(void)(line);
+#endif
+#ifdef G_ENABLE_WORKERS
+	_gshell_lock(1);
+#endif
+#ifdef G_ENABLE_LOGSINKS
+	// Hand the formatted record over, even if the terminal itself is inactive
+	if (sInternals.sinks != NULL)
+	{
+		_gshell_sinkDeliver(&sRecord);
+	}
+#endif
+#ifdef G_ENABLE_LOGHISTORY
+	_gshell_histAppend(loglvl, timestamp, sThread.vsprintf_buf, (iLength > 0) ? (uint16_t)iLength : 0);
+#endif
+#ifdef G_ENABLE_WORKERS
+	_gshell_lock(0);
+#endif
+#ifdef _G_LOG_ALWAYS
+	if (bConsole == 0)	return;
+#else
+	// Supress compiler warning
+	(void)(iLength);
+#endif
+
+#ifdef G_ENABLE_LOGFORMAT
+	if (!bText)
+	{
+		// One record per line / CBOR item, only JSON lines share the terminal with the prompt
+		_gshell_enc_t sEnc = {NULL, 0, 0, 1};
+		uint8_t bPromt = _G_SES.promtEnabled && (_G_SES.logFormat == GSHELL_LOGFMT_JSON);
+
+		if (bPromt)
+		{
+			_gshell_clearLine();
+		}
+		_gshell_logEncodeTo(&sEnc, _G_SES.logFormat, &sRecord);
+		if (bPromt)
+		{
+			_gshell_putPromt();
+			gshell_putStringRAM(_G_SES.rx_buf);
+		}
+		return;
+	}
+#endif
+
+	// Print the result from vsprintf
+	gshell_putStringRAM(sThread.vsprintf_buf);
+
+	if (_G_SES.promtEnabled)
+	{
+		// If the promt was enabled before, reprint not only
+		// the prompt itself, but also what the user has typed in!
+		// Thus, restoring any command / typing flow of the user despite random logging
+		_gshell_restorePromt();
+	}
+	else
+	{
+		gshell_putString(G_CRLF);
+	}
+}
+
+/* Prints the log message into the output queue of its level */
+static void _gshell_vlog(enum glog_level loglvl, const _GMEMX char *file, uint16_t line, const _GMEMX char *logText, va_list args)
+{
+#ifdef G_ENABLE_TXQUEUES
+	uint8_t u8Prev = sThread.txPrio;
+
+	sThread.txPrio = (loglvl >= GLOG_ERROR) ? _G_TXQ_CRIT : _G_TXQ_LOG;
+	_gshell_vlogPrint(loglvl, file, line, logText, args);
+	sThread.txPrio = u8Prev;
+
+	// The system might not live long enough for the next gshell_txDrain
+	if (loglvl == GLOG_FATAL)
+	{
+		while (_G_SES.txq[_G_TXQ_CRIT].head != _G_SES.txq[_G_TXQ_CRIT].tail)
+		{
+			_gshell_txSend();
+		}
+	}
+#else
+	_gshell_vlogPrint(loglvl, file, line, logText, args);
+#endif
+}
+
+void gshell_log_flash(enum glog_level loglvl, const _GMEMX char *logText, ...)
+{
+	va_list args;
+
+	va_start(args, logText);
+	_gshell_vlog(loglvl, NULL, 0, logText, args);
+	va_end(args);
+}
+
+#ifdef G_ENABLE_LOGSITES
+/* Checks if the call site is in the given file (end of its path, whole names only) and line */
+static uint8_t _gshell_logsiteMatch(const gshell_logsite_t *site, const char *file, uint16_t u16FileLen, uint16_t line)
+{
+	uint16_t u16SiteLen;
+
+	if ((line != 0) && (site->line != line))
+	{
+		return 0;
+	}
+	if ((u16FileLen == 1) && (file[0] == '*'))
+	{
+		return 1;
+	}
+
+	u16SiteLen = (uint16_t)_G_STRNLEN(site->file, 0xFFFF);
+	if (u16FileLen > u16SiteLen)
+	{
+		return 0;
+	}
+	// "art.c" mustn't match "uart.c"
+	if ((u16FileLen < u16SiteLen) && (site->file[u16SiteLen - u16FileLen - 1] != '/') &&
+		(site->file[u16SiteLen - u16FileLen - 1] != '\\'))
+	{
+		return 0;
+	}
+	return (_G_STRNCMP(file, site->file + (u16SiteLen - u16FileLen), u16FileLen) == 0);
+}
+
+uint16_t gshell_logsiteSet(const char *file, uint16_t line, uint8_t enable)
+{
+	gshell_logsite_t *site;
+	uint16_t u16FileLen = (uint16_t)strlen(file);
+	uint16_t u16Count = 0;
+
+	for (site = __start_gshell_logsites; site < __stop_gshell_logsites; site++)
+	{
+		if (_gshell_logsiteMatch(site, file, u16FileLen, line))
+		{
+			site->enabled = (enable != 0);
+			u16Count++;
+		}
+	}
+	return u16Count;
+}
+#endif
+
+#ifdef G_ENABLE_LOGFORMAT
+void gshell_logSrc_flash(enum glog_level loglvl, const _GMEMX char *file, uint16_t line, const _GMEMX char *logText, ...)
+{
+	va_list args;
+
+	va_start(args, logText);
+	_gshell_vlog(loglvl, file, line, logText, args);
+	va_end(args);
+}
+
+void gshell_setLogFormat(enum gshell_logformat format)
+{
+	_G_SES.logFormat = (uint8_t)format;
+}
+
+enum gshell_logformat gshell_getLogFormat(void)
+{
+	return (enum gshell_logformat)_G_SES.logFormat;
+}
+
+uint16_t gshell_logEncode(enum gshell_logformat format, const gshell_logrec_t *record, uint8_t *buf, uint16_t size)
+{
+	_gshell_enc_t sEnc = {buf, size, 0, 0};
+
+	_gshell_logEncodeTo(&sEnc, format, record);
+	return sEnc.len;
+}
+#endif
+
+#ifdef G_ENABLE_LOGSINKS
+int8_t gshell_addSink(gshell_sink_t *sink)
+{
+	gshell_sink_t *psEntry;
+	int8_t i8Ret = 0;
+
+#ifdef G_ENABLE_WORKERS
+	_gshell_lock(1);
+#endif
+	for (psEntry = sInternals.sinks; psEntry != NULL; psEntry = psEntry->next)
+	{
+		if (psEntry == sink)	i8Ret = -1;
+	}
+
+	if (i8Ret == 0)
+	{
+		sink->bufFill = 0;
+		sink->dropped = 0;
+		sink->next = sInternals.sinks;
+		sInternals.sinks = sink;
+	}
+#ifdef G_ENABLE_WORKERS
+	_gshell_lock(0);
+#endif
+	return i8Ret;
+}
+
+void gshell_removeSink(gshell_sink_t *sink)
+{
+	gshell_sink_t **ppsEntry;
+
+#ifdef G_ENABLE_WORKERS
+	_gshell_lock(1);
+#endif
+	for (ppsEntry = &sInternals.sinks; *ppsEntry != NULL; ppsEntry = &(*ppsEntry)->next)
+	{
+		if (*ppsEntry == sink)
+		{
+			*ppsEntry = sink->next;
+			sink->next = NULL;
+			break;
+		}
+	}
+#ifdef G_ENABLE_WORKERS
+	_gshell_lock(0);
+#endif
+}
+
+void gshell_flushSinks(void)
+{
+	gshell_sink_t *sink;
+
+#ifdef G_ENABLE_WORKERS
+	_gshell_lock(1);
+#endif
+	for (sink = sInternals.sinks; sink != NULL; sink = sink->next)
+	{
+		_gshell_sinkFlush(sink);
+	}
+#ifdef G_ENABLE_WORKERS
+	_gshell_lock(0);
+#endif
+}
+
+void gshell_setLogLevel(enum glog_level minLevel)
+{
+	sInternals.consoleLevel = (uint8_t)minLevel;
+}
+#endif
+
+/*****************************************************************************/
+/*****************   DEFAULT COMMANDS INCLUDED WITH GSHELL *******************/
+/*****************************************************************************/
+/* Prints a single line of the help command: name and description */
+static void _gshell_helpPrintCmd(const gshell_cmd_t *command, uint8_t longestCommand, uint8_t longestDescription)
+{
+	// Some boundary checks in order to print long descriptions nicely:
+	if (2+longestDescription+longestCommand >= G_RX_BUFSIZE)
+	{
+		gshell_putString("\r"G_TEXTBOLD);
+		gshell_putString_flash(command->cmdName);
+		gshell_putString(G_TEXTNORMAL":"G_CRLF"     ");
+		gshell_putString_flash(command->desc);
+		gshell_putString(G_CRLF);
+	}
+#ifdef G_ENABLE_TERMPROFILES
+	else if (_G_SES.termProfile != GSHELL_TERM_ANSI)
+	{
+		// Compact profiles: name, padding up to the description column, description.
+		// No bold text and no carriage-return trick, which saves bytes on the wire
+		uint8_t u8NameLen = _G_STRNLEN(command->cmdName, G_RX_BUFSIZE);
+		gshell_putString_flash(command->cmdName);
+		gshell_putChar(':');
+		for (uint8_t j = u8NameLen + 1; j < (longestCommand+2); j++)
+		{
+			gshell_putChar(' ');
+		}
+		gshell_putString_flash(command->desc);
+		gshell_putString(G_CRLF);
+	}
+#endif
+	else
+	{
+		// Command name + description not too large?
+		// Print the spaces, then the description, then use
+		// CR to return back to the start to print the command name
+		// Go to the next line (LF) and repeat as long a there are commands
+		for (uint8_t j = 0; j < (longestCommand+2); j++)
+		{
+			gshell_putChar(' ');
+		}
+		gshell_putString_flash(command->desc);
+		gshell_putString("\r"G_TEXTBOLD);
+		gshell_putString_flash(command->cmdName);
+		gshell_putString(G_TEXTNORMAL":"G_CRLF);
+	}
+}
+
+#ifdef G_ENABLE_SUBCOMMANDS
+/* Lists the subcommands of a command group, formatted like the help command */
+static void _gshell_helpSubCmds(const gshell_cmd_t *group)
+{
+	const gshell_cmd_t *command;
+	uint8_t longestCommand = 0;
+	uint8_t longestDescription = 0;
+	uint8_t tempLen;
+
+	// Groups are small and listed rarely, no need to cache the lengths
+	for (command = group->sub; command != NULL; command = command->next)
+	{
+		tempLen = _G_STRNLEN(command->cmdName, G_RX_BUFSIZE);
+		if (tempLen > longestCommand)	longestCommand = tempLen;
+
+		tempLen = _G_STRNLEN(command->desc, G_RX_BUFSIZE);
+		if (tempLen > longestDescription)	longestDescription = tempLen;
+	}
+	for (command = group->sub; command != NULL; command = command->next)
+	{
+		_gshell_helpPrintCmd(command, longestCommand, longestDescription);
+	}
+}
+#endif
+
+#ifdef G_ENABLE_ARGSCHEMA
+/* Prints the usage of a command, generated from its argument schema */
+static void _gshell_printUsage(const gshell_cmd_t *command)
+{
+	const _GMEMX gshell_arg_t *arg;
+	uint8_t u8Idx;
+
+	gshell_putString(_G_USAGE);
+	gshell_putString_flash(command->cmdName);
+	for (u8Idx = 0; u8Idx < command->argsCount; u8Idx++)
+	{
+		arg = &command->args[u8Idx];
+		gshell_putString(" ");
+		gshell_putChar((arg->optional || (arg->type == GARG_FLAG)) ? '[' : '<');
+		switch (arg->type)
+		{
+			case GARG_INT:
+				gshell_putString_flash(arg->name);
+				if (arg->min || arg->max)
+				{
+					gshell_printf_flash(G_XSTR(":%ld..%ld"), (long)arg->min, (long)arg->max);
+				}
+				break;
+			case GARG_HEX:
+				gshell_putString_flash(arg->name);
+				gshell_putString(":hex");
+				break;
+			case GARG_FLOAT:
+				gshell_putString_flash(arg->name);
+				gshell_putString(":float");
+				break;
+			case GARG_ENUM:
+				gshell_putString_flash(arg->keywords);
+				break;
+			default:
+				gshell_putString_flash(arg->name);
+				break;
+		}
+		gshell_putChar((arg->optional || (arg->type == GARG_FLAG)) ? ']' : '>');
+	}
+	gshell_putString(G_CRLF);
+}
+#endif
+
+static uint8_t gshell_cmd_help(uint8_t argc, char *argv[])
+{
+	const gshell_cmd_t *command;
+
+	uint8_t longestCommand = sInternals.helpCmdNameLength;
+	uint8_t longestDescription = sInternals.helpCmdDescLength;
+	uint8_t tempLen = 0;
+	uint16_t u16_cnt;
+
+#if defined(G_ENABLE_SUBCOMMANDS) || defined(G_ENABLE_ARGSCHEMA)
+	// 'help <cmd>' describes a single command, 'help <group> [<subgroup> ...]'
+	// lists the subcommands of that group
+	if (argc > 1)
+	{
+		int16_t i16CmdID;
+		command = _gshellFindCmd(argv[1], &i16CmdID);
+#ifdef G_ENABLE_SUBCOMMANDS
+		for (u16_cnt = 2; (command != NULL) && (u16_cnt < argc); u16_cnt++)
+		{
+			command = _gshellFindSubCmd(command, argv[u16_cnt]);
+		}
+#endif
+
+		if (command == NULL)
+		{
+			gshell_putString(_G_UNKCMD);
+			gshell_putStringRAM(argv[argc - 1]);
+			gshell_putString(G_CRLF);
+		}
+#ifdef G_ENABLE_SUBCOMMANDS
+		else if (command->sub != NULL)
+		{
+			_gshell_helpSubCmds(command);
+		}
+#endif
+		else
+		{
+			_gshell_helpPrintCmd(command, _G_STRNLEN(command->cmdName, G_RX_BUFSIZE), _G_STRNLEN(command->desc, G_RX_BUFSIZE));
+#ifdef G_ENABLE_ARGSCHEMA
+			if (command->args != NULL)
+			{
+				_gshell_printUsage(command);
+			}
+#endif
+		}
+		return 0;
+	}
+#else
+	// Supress 'unused parameter' warning:
+	(void)(argc);
+	(void)(argv);
+#endif
+
+	// If we haven't found the longest command and description yet, find it
+	if ((longestCommand == 0) || (longestDescription == 0))
+	{
+		// Loop through every dynamic command!
+		for (u16_cnt = 0; u16_cnt < sInternals.chain_len; u16_cnt++)
+		{
+			if (u16_cnt)
+			{
+				command = command->next;
+			}
+			else
+			{
+				command = &cmd_help;
+			}
+
+			// Get the length of the command name and description!
+			//
+			tempLen = _G_STRNLEN(command->cmdName, G_RX_BUFSIZE);
+			if (tempLen > longestCommand)	longestCommand = tempLen;
+
+			tempLen = _G_STRNLEN(command->desc, G_RX_BUFSIZE);
+			if (tempLen > longestDescription)	longestDescription = tempLen;
+
+		}
+#ifdef ENABLE_STATIC_COMMANDS
+		for (u16_cnt = 0; u16_cnt < gshell_list_num_commands; u16_cnt++)
+		{
+			command = &gshell_list_commands[u16_cnt];
+			tempLen = _G_STRNLEN(command->cmdName, G_RX_BUFSIZE);
+			if (tempLen > longestCommand)	longestCommand = tempLen;
+
+			tempLen = _G_STRNLEN(command->desc, G_RX_BUFSIZE);
+			if (tempLen > longestDescription)	longestDescription = tempLen;
+		}
+#endif
+		sInternals.helpCmdDescLength = longestDescription;
+		sInternals.helpCmdNameLength = longestCommand;
+	}
+
+	// Print the command, followed by some spacing, and finally the description
+	// The amount of "spaces" between the command name and description is
+	// based on the longest command name.
+	for (u16_cnt = 0; u16_cnt < sInternals.chain_len; u16_cnt++)
+	{
+		// If u16_cnt is zero, start with the help command, otherwise with the dynamic command chain
+		if (u16_cnt)
+		{
+			command = command->next;
+		}
+		else
+		{
+			command = &cmd_help;
+		}
+		_gshell_helpPrintCmd(command, longestCommand, longestDescription);
+	}
+#ifdef ENABLE_STATIC_COMMANDS
+	// Same as with the dynamic commands above!
+	for (u16_cnt = 0; u16_cnt < gshell_list_num_commands; u16_cnt++)
+	{
+		_gshell_helpPrintCmd(&gshell_list_commands[u16_cnt], longestCommand, longestDescription);
+	}
+#endif
+	return 0;
+}
+
+#ifdef G_ENABLE_TRACE
+/* Prints a unsigned number without the vsprintf buffer, 64 bit wide */
+static void _gshell_tracePutU64(uint64_t u64Val)
+{
+	char cDigits[20];
+	uint8_t u8Cnt = 0;
+
+	do
+	{
+		cDigits[u8Cnt++] = '0' + (char)(u64Val % 10);
+		u64Val /= 10;
+	} while (u64Val);
+
+	while (u8Cnt)
+	{
+		gshell_putChar(cDigits[--u8Cnt]);
+	}
+}
+
+static uint8_t gshell_cmd_trace(uint8_t argc, char *argv[])
+{
+	uint32_t u32TicksPerSecond = (sTrace.ticksPerSecond != 0) ? sTrace.ticksPerSecond : 1000;
+	uint32_t u32First;
+	uint16_t u16Count;
+	uint16_t u16Idx;
+	uint16_t u16_cnt;
+
+	if (argc < 2)
+	{
+		gshell_printf_flash(G_XSTR("%u of %u trace events recorded%s" G_CRLF),
+							sTrace.wrapped ? G_TRACE_SIZE : (sTrace.head & (G_TRACE_SIZE - 1)), G_TRACE_SIZE,
+							sTrace.wrapped ? ", oldest ones overwritten" : "");
+		return 0;
+	}
+	if (strcmp(argv[1], "clear") == 0)
+	{
+		sTrace.head = 0;
+		sTrace.wrapped = 0;
+		return 0;
+	}
+	if (strcmp(argv[1], "dump") != 0)
+	{
+		gshell_putString(_G_USAGE "trace [dump|clear]" G_CRLF);
+		return 0;
+	}
+
+	// Oldest event first, the ring doesn't change while it is printed
+	sTrace.paused = 1;
+	u16Count = sTrace.wrapped ? G_TRACE_SIZE : (sTrace.head & (G_TRACE_SIZE - 1));
+	u16Idx = sTrace.wrapped ? (sTrace.head & (G_TRACE_SIZE - 1)) : 0;
+	u32First = sTrace.events[u16Idx].tick;
+
+	// Chrome trace-event format, timestamps in microseconds since the oldest event
+	gshell_putString("{\"traceEvents\":[" G_CRLF);
+	for (u16_cnt = 0; u16_cnt < u16Count; u16_cnt++)
+	{
+		gshell_putString("{\"ph\":\"");
+		gshell_putChar((char)sTrace.events[u16Idx].type);
+		gshell_putString("\",\"ts\":");
+		_gshell_tracePutU64((uint64_t)(sTrace.events[u16Idx].tick - u32First) * 1000000u / u32TicksPerSecond);
+		if (sTrace.events[u16Idx].name != NULL)
+		{
+			gshell_putString(",\"name\":\"");
+			gshell_putString_flash(sTrace.events[u16Idx].name);
+			gshell_putChar('"');
+		}
+		if (sTrace.events[u16Idx].type == GTRACE_INSTANT)
+		{
+			gshell_putString(",\"s\":\"t\"");
+		}
+		gshell_printf_flash(G_XSTR(",\"pid\":1,\"tid\":%u}%s" G_CRLF), sTrace.events[u16Idx].ctx,
+							(u16_cnt + 1 < u16Count) ? "," : "");
+		u16Idx = (u16Idx + 1) & (G_TRACE_SIZE - 1);
+	}
+	gshell_putString("]}" G_CRLF);
+	sTrace.paused = 0;
+
+	return 0;
+}
+#endif
+
+#ifdef G_ENABLE_LOGSITES
+static uint8_t gshell_cmd_logsite(uint8_t argc, char *argv[])
+{
+	gshell_logsite_t *site;
+	const char *pcFile = "*";
+	char *pcLine;
+	uint16_t u16Line = 0;
+	uint16_t u16Count = 0;
+
+	if ((argc < 2) || (argc > 3) || ((strcmp(argv[1], "list") != 0) && (argc < 3)))
+	{
+		gshell_putString(_G_USAGE "logsite list|enable|disable [<file>[:line]]" G_CRLF);
+		return 0;
+	}
+	if (argc == 3)
+	{
+		// "uart.c:42" selects a single line of the file
+		pcFile = argv[2];
+		pcLine = strrchr(argv[2], ':');
+		if (pcLine != NULL)
+		{
+			*pcLine++ = C_NULLCHAR;
+			for (; (*pcLine >= '0') && (*pcLine <= '9'); pcLine++)
+			{
+				u16Line = u16Line * 10 + (uint16_t)(*pcLine - '0');
+			}
+		}
+	}
+
+	if (strcmp(argv[1], "enable") == 0)
+	{
+		u16Count = gshell_logsiteSet(pcFile, u16Line, 1);
+	}
+	else if (strcmp(argv[1], "disable") == 0)
+	{
+		u16Count = gshell_logsiteSet(pcFile, u16Line, 0);
+	}
+	else if (strcmp(argv[1], "list") == 0)
+	{
+		for (site = __start_gshell_logsites; site < __stop_gshell_logsites; site++)
+		{
+			if (!_gshell_logsiteMatch(site, pcFile, (uint16_t)strlen(pcFile), u16Line))
+			{
+				continue;
+			}
+			if (site->enabled)
+			{
+				gshell_putString("[x] ");
+			}
+			else
+			{
+				gshell_putString("[ ] ");
+			}
+			gshell_putString_flash(site->file);
+			gshell_putChar(':');
+			gshell_putU32(site->line);
+			gshell_putChar(' ');
+			gshell_putString_flash(log_level_names[(site->level <= GLOG_FATAL) ? site->level : GLOG_NORMAL]);
+			gshell_putString(" \"");
+			gshell_putString_flash(site->format);
+			gshell_putString("\"" G_CRLF);
+			u16Count++;
+		}
+		gshell_putU32(u16Count);
+		gshell_putString(" call sites" G_CRLF);
+		return 0;
+	}
+	else
+	{
+		gshell_putString(_G_USAGE "logsite list|enable|disable [<file>[:line]]" G_CRLF);
+		return 0;
+	}
+
+	gshell_putU32(u16Count);
+	gshell_putString(" call sites switched" G_CRLF);
+	return 0;
+}
+#endif
+
+#ifdef G_ENABLE_WATCH
+/* Parses a decimal number, returns 0 if the string isn't one */
+static uint8_t _gshell_watchNum(const char *str, uint32_t *pu32Value)
+{
+	*pu32Value = 0;
+	if (*str == C_NULLCHAR)
+	{
+		return 0;
+	}
+	for (; *str != C_NULLCHAR; str++)
+	{
+		if ((*str < '0') || (*str > '9'))
+		{
+			return 0;
+		}
+		*pu32Value = *pu32Value * 10 + (uint32_t)(*str - '0');
+	}
+	return 1;
+}
+
+/* Resolves and caches the command of 'watch' / 'repeat', argv[0] being its name */
+static void _gshell_watchStart(uint8_t argc, char *argv[], uint32_t u32Interval, uint16_t u16Count, uint8_t bClear)
+{
+	const gshell_cmd_t *command;
+	int16_t i16CmdID = 0;
+	uint8_t u8ArgOfs = 0;
+	uint16_t u16Pos = 0;
+	uint16_t u16Len;
+	uint8_t u8_cnt;
+
+	if ((u32Interval != 0) && (sInternals.fp_msTimeStamp == NULL))
+	{
+		gshell_putString("No millisecond timestamp to schedule with" G_CRLF);
+		return;
+	}
+	command = _gshell_resolveCmd(argc, argv, &i16CmdID, &u8ArgOfs);
+	if (command == NULL)
+	{
+		gshell_putString(_G_UNKCMD);
+		gshell_putStringRAM(argv[0]);
+		gshell_putString(G_CRLF);
+		return;
+	}
+	if ((command == &cmd_watch) || (command == &cmd_repeat))
+	{
+		gshell_putString("Can't watch 'watch' or 'repeat'" G_CRLF);
+		return;
+	}
+	argc -= u8ArgOfs;
+	argv += u8ArgOfs;
+#ifdef G_ENABLE_ARGSCHEMA
+	// Checked once, a mistake is reported right away instead of on every run
+	if ((command->args != NULL) && _gshell_parseArgs(command, argc, argv))
+	{
+		return;
+	}
+#endif
+
+	// The arguments point into the input buffer, which is reused right away.
+	// All of them came out of it, so they fit into a buffer of the same size
+	for (u8_cnt = 0; u8_cnt < argc; u8_cnt++)
+	{
+		u16Len = (uint16_t)strlen(argv[u8_cnt]);
+		memcpy(sWatch.args + u16Pos, argv[u8_cnt], u16Len + 1);
+		sWatch.argv[u8_cnt] = sWatch.work + u16Pos;
+		sWatch.argl[u8_cnt] = (uint8_t)u16Len;
+		u16Pos += u16Len + 1;
+	}
+	sWatch.argsLen = u16Pos;
+	sWatch.argc = argc;
+	sWatch.cmdID = i16CmdID;
+	sWatch.session = &_G_SES;
+	sWatch.interval = u32Interval;
+	sWatch.remaining = u16Count;
+#ifdef G_ENABLE_TERMPROFILES
+	if (_G_SES.termProfile == GSHELL_TERM_PLAIN)
+	{
+		bClear = 0;
+	}
+#endif
+	sWatch.clear = bClear;
+	// First run on the next gshell_poll
+	sWatch.lastRun = ((u32Interval != 0) ? sInternals.fp_msTimeStamp() : 0) - u32Interval;
+	sWatch.command = command;
+
+	if (bClear)
+	{
+		gshell_putString(G_CURSORHOME G_CLEARSCREEN);
+	}
+}
+
+static uint8_t gshell_cmd_watch(uint8_t argc, char *argv[])
+{
+	uint32_t u32Interval = 1000;
+	uint8_t bClear = 0;
+	uint8_t u8Arg;
+
+	for (u8Arg = 1; (u8Arg < argc) && (argv[u8Arg][0] == '-'); u8Arg++)
+	{
+		if ((strcmp(argv[u8Arg], "-n") == 0) && (u8Arg + 1 < argc) && _gshell_watchNum(argv[u8Arg + 1], &u32Interval))
+		{
+			u8Arg++;
+		}
+		else if (strcmp(argv[u8Arg], "-c") == 0)
+		{
+			bClear = 1;
+		}
+		else
+		{
+			break;
+		}
+	}
+	if ((u8Arg >= argc) || (argv[u8Arg][0] == '-') || (u32Interval == 0))
+	{
+		gshell_putString(_G_USAGE "watch [-n <ms>] [-c] <cmd ...>" G_CRLF);
+		return 0;
+	}
+
+	_gshell_watchStart(argc - u8Arg, &argv[u8Arg], u32Interval, 0, bClear);
+	return 0;
+}
+
+static uint8_t gshell_cmd_repeat(uint8_t argc, char *argv[])
+{
+	uint32_t u32Count = 0;
+	uint32_t u32Interval = 0;
+	uint8_t u8Arg = 2;
+
+	if ((argc > 1) && _gshell_watchNum(argv[1], &u32Count) && (u8Arg + 1 < argc) &&
+		(strcmp(argv[u8Arg], "-n") == 0))
+	{
+		u8Arg += _gshell_watchNum(argv[u8Arg + 1], &u32Interval) ? 2 : 0;
+	}
+	if ((u8Arg >= argc) || (argv[u8Arg][0] == '-') || (u32Count == 0) || (u32Count > UINT16_MAX))
+	{
+		gshell_putString(_G_USAGE "repeat <N> [-n <ms>] <cmd ...>" G_CRLF);
+		return 0;
+	}
+
+	// Without a interval, the command runs on every gshell_poll
+	_gshell_watchStart(argc - u8Arg, &argv[u8Arg], u32Interval, (uint16_t)u32Count, 0);
+	return 0;
+}
+#endif
+
+#ifdef G_ENABLE_LOGHISTORY
+static uint8_t gshell_cmd_dmesg(uint8_t argc, char *argv[])
+{
+	uint8_t u8Header[_G_HIST_RECHDR];
+	uint8_t u8MinLevel = GLOG_NORMAL;
+	uint32_t u32Since = 0;
+	uint32_t u32Timestamp;
+	uint8_t bClear = 0;
+	_g_histhdr_t sState;
+	const uint8_t *pu8Ring;
+	uint16_t u16Pos;
+	uint16_t u16_cnt;
+	uint8_t u8Arg;
+	const char *pcNum;
+#ifdef G_ENABLE_WORKERS
+	uint8_t u8Ring[G_LOGHISTORY_SIZE];
+#endif
+
+	// dmesg [-l <level>] [-s <since ms>] [-c]
+	for (u8Arg = 1; u8Arg < argc; u8Arg++)
+	{
+		if ((strcmp(argv[u8Arg], "-l") == 0) && (u8Arg + 1 < argc) &&
+			(argv[u8Arg + 1][0] >= '0') && (argv[u8Arg + 1][0] <= '0' + GLOG_FATAL) && (argv[u8Arg + 1][1] == C_NULLCHAR))
+		{
+			u8MinLevel = (uint8_t)(argv[++u8Arg][0] - '0');
+		}
+		else if ((strcmp(argv[u8Arg], "-s") == 0) && (u8Arg + 1 < argc))
+		{
+			for (pcNum = argv[++u8Arg]; (*pcNum >= '0') && (*pcNum <= '9'); pcNum++)
+			{
+				u32Since = u32Since * 10 + (uint32_t)(*pcNum - '0');
+			}
+		}
+		else if (strcmp(argv[u8Arg], "-c") == 0)
+		{
+			bClear = 1;
+		}
+		else
+		{
+			gshell_putString(_G_USAGE "dmesg [-l <0..5>] [-s <since ms>] [-c]" G_CRLF);
+			return 0;
+		}
+	}
+
+#ifdef G_ENABLE_WORKERS
+	// Other threads may log meanwhile, the records are copied out under the lock and printed afterwards
+	_gshell_lock(1);
+	sState = sHistory.hdr[sHistory.active];
+	memcpy(u8Ring, sHistory.buf, G_LOGHISTORY_SIZE);
+	_gshell_lock(0);
+	pu8Ring = u8Ring;
+#else
+	sState = sHistory.hdr[sHistory.active];
+	pu8Ring = sHistory.buf;
+#endif
+
+	u16Pos = sState.tail;
+	for (u16_cnt = 0; u16_cnt < sState.count; u16_cnt++)
+	{
+		_gshell_histRead(pu8Ring, u16Pos, u8Header, _G_HIST_RECHDR);
+		if (u8Header[0] >= G_RX_BUFSIZE)
+		{
+			// Never appended like this, the text wouldn't fit into the buffer
+			break;
+		}
+		u32Timestamp = (uint32_t)u8Header[2] | ((uint32_t)u8Header[3] << 8) |
+					   ((uint32_t)u8Header[4] << 16) | ((uint32_t)u8Header[5] << 24);
+
+		if ((u8Header[1] >= u8MinLevel) && (u8Header[1] <= GLOG_FATAL) && (u32Timestamp >= u32Since))
+		{
+#ifdef G_ENABLE_TERMPROFILES
+			if (_G_SES.termProfile != GSHELL_TERM_ANSI)
+			{
+				gshell_putString_flash(console_levels_plain[u8Header[1]]);
+			}
+			else
+#endif
+			gshell_putString_flash(console_levels[u8Header[1]]);
+			_gshell_putTimestamp(u32Timestamp);
+
+			// The text is copied out of the ring, as it may wrap around
+			_gshell_histRead(pu8Ring, (u16Pos + _G_HIST_RECHDR) % G_LOGHISTORY_SIZE, (uint8_t *)sThread.vsprintf_buf, u8Header[0]);
+			sThread.vsprintf_buf[u8Header[0]] = C_NULLCHAR;
+			gshell_putStringRAM(sThread.vsprintf_buf);
+			gshell_putString(G_CRLF);
+		}
+		u16Pos = (u16Pos + _G_HIST_RECHDR + u8Header[0]) % G_LOGHISTORY_SIZE;
+	}
+
+	if (bClear)
+	{
+		gshell_logHistoryClear();
+	}
+	return 0;
+}
+#endif
@@ -1,463 +1,1604 @@
-/**
- * @mainpage GSHELL - generic shell for embedded systems
- *
- * A small terminal and console logging library with small features added over the years.\n
- * Initialy designed for the Atmel AVR microcontrollers (in particular the larger xmega series),
- * it slowly has been adopted to target other and more generic microcontrollers (STM32L1x,
- * GD32VF103x, SAMD21G18J and ATxmega32A4U) and on the computer. (Created 18.03.2020) \n
- * Written by gfcwfzkm (github.com/gfcwfzkm, gfcwfzkm@protonmail.com)
- * 
- * \version 2.2
- * -Refined documentation, fixed minor bug
- *
- * \version 2.1
- * -Quotation-Marks detection and processing added (see \a G_ENABLE_SPECIALCMDSTR )
- *
- * \version 2.0
- * -Rework of the library, proper documentation
- *
- * \file gshell.h
- * \author gfcwfzkm
- * \date 08.10.2022
- * \copyright GNU Lesser General Public License v2.1
- *
- * \bug No known Bugs
- * \todo
- * - Add quotation-marks-functionality to the string-splitting / arguments parser
- * - Add basic cursor handling to the processShell-function
- */
-/**
- * @file gshell.h
- * @brief Header-File of gshell library
- */
-#ifndef GSHELL_H_
-#define GSHELL_H_
-
-/* --Includes-- */
-#include <stdio.h>
-#include <stdarg.h>
-#include <stdint.h>
-#include <string.h>
-
-
-/****** USER CONFIGURATION STARTS HERE ******/
-/**
- * @brief Enable static shell commands
- */
-//#define ENABLE_STATIC_COMMANDS
-
-/**
- * @brief Enable (/ Disable) echoing of the input back to the output
- */
-#define G_ENABLE_ECHO
-
-/**
- * @brief Use CR instead of LF to detect a new-line/enter keypress
- */
-//#define G_CR_INSTEADOF_LF
-
-/**
- * @brief Receive Buffer, also defines a AVR temporary buffer size (2x on AVR)
- */
-#define G_RX_BUFSIZE	120
-
-/**
- * @brief Amount of max. pointers passed as *argv[]
- */
-#define G_MAX_ARGS		16
-
-/**
- * @brief Enables specialised command string processing
- *
- * Allows ' and " characters to be used in order to not split
- * by spaces.
- */
-#define G_ENABLE_SPECIALCMDSTR
-/****** USER CONFIGURATION ENDS HERE ******/
-
-
-/* If on a 8-bit AVR Microcontroller, store text data in flash memory */
-#if defined(AVR) && !defined(__GNUG__)	// AVR + C Compiler (GCC)
-	#include <avr/pgmspace.h>
-	#define _GMEMX	__memx
-	#define _PRGMX
-#elif defined(AVR) && defined(__GNUG__)	// AVR + C++ Compiler (G++ workaround)
-	#include <avr/pgmspace.h>
-	#define _GMEMX
-	#define _PRGMX PROGMEM
-#else	// Non-AVR Platform
-	#define _GMEMX
-	#define _PRGMX
-#endif
-
-#ifndef G_XSTR
-	/**
-	 * @brief Store string (text array) in program memory and return a pointer from it
-	 */
-	#define G_XSTR(s)	(__extension__({static _GMEMX const char __fc[] _PRGMX = (s); &__fc[0];}))
-#endif
-
-#ifndef G_XARR
-	/**
-	 * @brief Store a Array in program memory
-	 */
-	#define G_XARR(X)		( ( const _GMEMX char[] _PRGMX ) { X } )
-#endif
-
-/* ANSI ESCAPE SEQUENCES TEXT FORMATTING */
-#define G_ESCAPE		"\x1b["
-#define G_TEXTNORMAL	G_ESCAPE"0m"
-#define G_TEXTBOLD		G_ESCAPE"1m"
-#define G_TEXTUNDERLINE	G_ESCAPE"4m"
-#define G_TEXTBLINK		G_ESCAPE"5m"
-#define G_TEXTNEGATIVE	G_ESCAPE"7m"
-#define G_CLEARLINE		G_ESCAPE"2K"
-/* ANSI ESCAPE SEQUENCES TEXT COLOR */
-#define G_COLORRESET	G_ESCAPE"39m"
-#define G_COLORRED		G_ESCAPE"31m"
-#define G_COLORGREEN	G_ESCAPE"32m"
-#define G_COLORYELLOW	G_ESCAPE"33m"
-#define G_COLORBLUE		G_ESCAPE"34m"
-#define G_COLORMAGENTA	G_ESCAPE"35m"
-#define G_COLORCYAN		G_ESCAPE"36m"
-#define G_COLORWHITE	G_ESCAPE"37m"
-#define G_COLORCUSTOM(r,g,b) \
-		G_ESCAPE"38m;2;"r";"g";"b
-
-
-/* General Terminal Sequences */
-#define G_CRLF			"\r\n"
-#define C_NEWLINE		'\n'
-#define C_CARRET		'\r'
-#define C_BACKSPCE1		'\b'
-#define C_BACKSPCE2		0x7F
-#define C_WITESPCE		' '
-#define C_NULLCHAR		'\0'
-
-/**
- * @brief Shell command structure
- * 
- * Structure containing the command's name, a pointer to the function as well as a basic description.
- */
-typedef struct gshell_cmd {
-	const _GMEMX char *cmdName;						/**< String - command name (case sensitive) */
-	uint8_t (*handler)(uint8_t argc, char *argv[]);	/**< function pointer to the command's funciton */
-	const _GMEMX char *desc;						/**< String - basic, short description of the command */
-	struct gshell_cmd *next;						/**< Don't assign this yourself! Used in dynamic command list */
-} gshell_cmd_t;
-
-/**
- * @brief logging level
- * 
- * Basic logging levels, highlighted by different colours and formats
- */
-enum glog_level{
-	GLOG_NORMAL	= 0,	/**< No Text, normal color */
-	GLOG_INFO	= 1,	/**< 'INFO' Text, normal color */
-	GLOG_OK		= 2,	/**< 'OK' Text, green color */
-	GLOG_WARN	= 3,	/**< 'WARN' text, yellow color */
-	GLOG_ERROR	= 4,	/**< 'ERROR' text, red color */
-	GLOG_FATAL	= 5		/**< 'FATAL' text, red and blink */
-};
-
-
-#define GSHELL_CMDRET_MASK      0x7F
-#define GSHELL_CMDRET_VAL(x)    (uint8_t)(x >> 8)
-/**
- * @brief gshell-return status
- *
- * Information about buffer status or cmd function returns
- */
-enum gshell_return{
-	GSHELL_OK		= 0,	/**< Everything okay, nothing to report */
-	GSHELL_INACTIVE,		/**< gshell inactive, character inputs ignored */
-	GSHELL_BUFFULL,			/**< text input buffer full! */
-	GSHELL_RUBBISH,			/**< Unrecognised data/command, discarded */
-	GSHELL_CMDINV,			/**< Unrecognised command / command not found */
-	GSHELL_ESCSEQ,			/**< Is processing a ANSI Escape Sequence */
-	GSHELL_CMDRET	= 0x80	/**< Command returned Value, lower 7-bits contain command ID */
-};
-
-/* Static command list. Use as followed in a seperate file (eg. 'commands.c':
- *
- * #include "gshell.h"
- *
- * void cli_cmd_hello(uint8_t argc, char *argv[])
- * {
-	 gshell_putString_f("Hello World!\r\n");
- * }
- *
- * static const gshell_cmd_t shell_command_list[] = {
- *	 {G_XARR("hello"),	cli_cmd_hello,	G_XARR("Say Hello")}
- * // Simply add more commands here
- * };
- * 
- * const gshell_cmd_t *const gshell_list_commands = shell_command_list;
- * const uint8_t gshell_list_num_commands = sizeof(shell_command_list) / sizeof(shell_command_list[0]);
- */
-#ifdef ENABLE_STATIC_COMMANDS
-extern const gshell_cmd_t *const gshell_list_commands;
-extern const uint8_t gshell_list_num_commands;
-#endif 
-
-
-/**
- * @brief Initialise the shell
- * 
- * Initialise the console's internal variables and passes over the function to send
- * a character and to get a millisecond-timestamp for the logging functions.
- * If no millisecond-timestamp is wished, replace it with 'NULL' instead.
- * 
- * @param putchar			Function pointer to print a character
- * @param get_msTimeStamp	Function pointer to get the milliseconds timestamp as uint32_t
- */
-int8_t gshell_init(void (*put_char)(char), uint32_t (*get_msTimeStamp)(void));
-
-/**
- * @brief Register a command
- * 
- * Register a console command yourself by passing over the pointer of your
- * gshell_cmd_t command definition.
- *
- * @param cmd	Pointer to a initialised gshell_cmd_t struct
- * @return		Returns the amount of registered commands. If the value
- *				is negative, the command couldn't be added.
- */
-int8_t gshell_register_cmd(gshell_cmd_t *cmd);
-
-/**
- * @brief Returns the ID of a command
- *
- * Searches the internal command list for the command name passed
- * over to this function and returns the corresponding command ID
- * when it's found, otherwise returns -1
- *
- * @param cmd_name	Name of the command
- * @return			-1 if not found, non-negative ID otherwise
- */
-int8_t gshell_getCmdIDbyName(const char* cmd_name);
-
-/**
- * @brief Returns the ID of a command
- *
- * Searches the internal command list for the matching command
- * structure passed over to this function. Returns the command
- * ID when it's found, otherwise returns -1
- *
- * @param cmd		Pointer to the gshell_cmd_t command
- * @return			-1 if not found, non-negative ID otherwise
- */
-int8_t gshell_getCmdIDbyStruct(gshell_cmd_t *cmd);
-
-/**
- * @brief Set Shell Active
- *
- * Enables or disables the whole terminal and logging functionality
- * Enabled by default when initialising gshell (\a gshell_init )
- *
- * @param activeStatus	0 to disable, non-zero to enable the terminal
- */
-void gshell_setActive(uint8_t activeStatus);
-
-/**
- * @brief Enable or disable the promt
- *
- * Enables or disables the console promt and text input
- *
- * @param promtStatus	0 to disable, non-zero to enable the promt
- */
-void gshell_setPromt(uint8_t promtStatus);
-
-/**
- * @brief Character-received Callback Function
- *
- * Call this function with every character received by your system/peripheral or
- * driver to let gshell process the user data input
- *
- * @param c		8-bit Character received via UART/Terminal/etc...
- * @return		Lower 8-bit contain the enum gshell_return, upper 8-bit the
- *				return value of the executed command
- */
-uint16_t gshell_processShell(char c);
-
-/**
- * @brief Prints a single character
- *
- * Prints a single character, passes the character directly
- * to the driver function passed over during initialisation.
- * If the terminal isn't set 'active', nothing will be printed.
- *
- * @param c		8-bit Character to send
- */
-void gshell_putChar(char c);
-
-/**
- * @brief Sends a (S)RAM string
- *
- * Sends a string stored in volatile RAM/Memory.
- * If the terminal isn't set 'active', nothing will be printed.
- *
- * @param str	Pointer to array of characters, NULL-Character at the end
- */
-void gshell_putStringRAM(const char *str);
-
-/**
- * @brief Sends a flash string
- *
- * Sends a string stored in non-volatile flash memory. Use the macro
- * \a gshell_putString to automatically mark the text within there as
- * progmem. Otherwise use the \a G_XSTR macro.
- * If the terminal isn't set 'active', nothing will be printed.
- *
- * @param progmem_s	Pointer to the program memory holding the flash string
- */
-void gshell_putString_flash(const _GMEMX char *progmem_s);
-
-/**
- * @brief Makro for \a gshell_putString_flash
- * 
- * Stores the text automatically via a macro in flash memory for
- * the \a gshell_putString_flash function.
- * 
- * @param __f 	Text to send, automatically saved in flash
- */
-#define gshell_putString(__f)	gshell_putString_flash(G_XSTR(__f))
-
-/**
- * @brief Printf-functionality from program memory
- *
- * Basic (vs)printf functionality, where the main string is
- * stored in flash memory instead of RAM. Requires the string to be
- * put in the program memory if the macro \a gshell_printf isn't used.
- * If the terminal isn't set 'active', nothing will be printed.
- *
- * @param progmem_s	Pointer to the program memory holding the flash string
- * @param ...		Additional, optional printf-style arguments
- */
-void gshell_printf_flash(const _GMEMX char *progmem_s, ...);
-
-/**
- * @brief Printf-functionality & auto-flash string saving
- * 
- * Similar as \a gshell_printf_f but stores the text automatically
- * in the program memory.
- * 
- * @param __f		printf-formatting text to process
- * @param ...		Additional, optional printf-style arguments
- */
-#define gshell_printf(__f, ...)	gshell_printf_flash(G_XSTR(__f),__VA_ARGS__);
-
-/**
- * @brief Logging functionality
- *
- * Basic logging function that prints out the text together with the logging level
- * and optionally a milliseconds timestamp. Uses vsprintf, so additonal arguments and
- * variables can be printed similar like printf. Expects a const string pointer (to
- * flash memory).
- *
- * @param loglvl	glog_level logging level
- * @param logText	Program-memory-pointer to the logging text & printf-formatting 
- * @param ...		Additional, optional printf-style arguments
- */
-void gshell_log_flash(enum glog_level loglvl, const _GMEMX char *logText, ...);
-
-/**
- * @brief Logging macro
- * 
- * Basically \a gshell_log_flash but with a macro to store the (printf) text
- * in the flash memory & passing the flash memory pointer to the function 
- * \a gshell_log_flash.
- * 
- * @param __l		enum \a glog_level logging level
- * @param logText	Logging text & printf-formatting 
- * @param ...		Additional, optional printf-style arguments
- */
-#define glog(__l,__f,...)		gshell_log_flash(__l,G_XSTR(__f), ##__VA_ARGS__)
-
-/**
- * @brief Logging macro level NORMAL
- * 
- * Basically \a gshell_log_flash but with a macro to store the (printf) text
- * in the flash memory & passing the flash memory pointer to the function 
- * \a gshell_log_flash.
- * 
- * @param logText	Logging text & printf-formatting 
- * @param ...		Additional, optional printf-style arguments
- */
-#define glog_norm(__f,...)		gshell_log_flash(GLOG_NORMAL,G_XSTR(__f), ##__VA_ARGS__)
-
-/**
- * @brief Logging macro level INFO
- * 
- * Basically \a gshell_log_flash but with a macro to store the (printf) text
- * in the flash memory & passing the flash memory pointer to the function 
- * \a gshell_log_flash.
- * 
- * @param logText	Logging text & printf-formatting 
- * @param ...		Additional, optional printf-style arguments
- */
-#define glog_info(__f,...)		gshell_log_flash(GLOG_INFO,G_XSTR(__f), ##__VA_ARGS__)
-
-/**
- * @brief Logging macro level OK
- * 
- * Basically \a gshell_log_flash but with a macro to store the (printf) text
- * in the flash memory & passing the flash memory pointer to the function 
- * \a gshell_log_flash.
- * 
- * @param logText	Logging text & printf-formatting 
- * @param ...		Additional, optional printf-style arguments
- */
-#define glog_ok(__f,...)		gshell_log_flash(GLOG_OK,G_XSTR(__f), ##__VA_ARGS__)
-
-/**
- * @brief Logging macro level WARNING
- * 
- * Basically \a gshell_log_flash but with a macro to store the (printf) text
- * in the flash memory & passing the flash memory pointer to the function 
- * \a gshell_log_flash.
- * 
- * @param logText	Logging text & printf-formatting 
- * @param ...		Additional, optional printf-style arguments
- */
-#define glog_warn(__f,...)		gshell_log_flash(GLOG_WARN,G_XSTR(__f), ##__VA_ARGS__)
-
-/**
- * @brief Logging macro level ERROR
- * 
- * Basically \a gshell_log_flash but with a macro to store the (printf) text
- * in the flash memory & passing the flash memory pointer to the function 
- * \a gshell_log_flash.
- * 
- * @param logText	Logging text & printf-formatting 
- * @param ...		Additional, optional printf-style arguments
- */
-#define glog_error(__f,...)		gshell_log_flash(GLOG_ERROR,G_XSTR(__f), ##__VA_ARGS__)
-
-/**
- * @brief Logging macro level FATAL
- * 
- * Basically \a gshell_log_flash but with a macro to store the (printf) text
- * in the flash memory & passing the flash memory pointer to the function 
- * \a gshell_log_flash.
- * 
- * @param logText	Logging text & printf-formatting 
- * @param ...		Additional, optional printf-style arguments
- */
-#define glog_fatal(__f,...)		gshell_log_flash(GLOG_FATAL,G_XSTR(__f), ##__VA_ARGS__)
-
-/**
- * @brief Logging file/function/line
- *
- * Prints the exact file, function and line via the logging function.
- * The text is automatically stored in flash / program memory.
- * Expects a logging level as argument.
- *
- * @param __l		enum \a glog_level logging level
- */
-#define glog_ffl(__l)			\
-	gshell_log_flash(__l, G_XSTR("In ["__FILE__"], function [%s] line [%d]"), __FUNCTION__, __LINE__)
-
-
-
-#endif // GSHELL_H_
+/**
+ * @mainpage GSHELL - generic shell for embedded systems
+ *
+ * A small terminal and console logging library with small features added over the years.\n
+ * Initialy designed for the Atmel AVR microcontrollers (in particular the larger xmega series),
+ * it slowly has been adopted to target other and more generic microcontrollers (STM32L1x,
+ * GD32VF103x, SAMD21G18J and ATxmega32A4U) and on the computer. (Created 18.03.2020) \n
+ * Written by gfcwfzkm (github.com/gfcwfzkm, gfcwfzkm@protonmail.com)
+ * 
+ * \version 2.3
+ * -Command context handlers and argument lengths (see \a G_ENABLE_CMDCONTEXT ), C++ wrapper gshell.hpp
+ * -Terminal profiles to strip ANSI decoration (see \a G_ENABLE_TERMPROFILES )
+ * -16-bit command IDs with \a gshell_processShellEx , command groups (see \a G_ENABLE_SUBCOMMANDS )
+ * -Typed argument schemas, parsed before the handler is called (see \a G_ENABLE_ARGSCHEMA )
+ * -Log sinks with their own level filter, buffer and flush policy (see \a G_ENABLE_LOGSINKS )
+ * -Reset-surviving log history with the 'dmesg' command (see \a G_ENABLE_LOGHISTORY )
+ * -Multiple terminal sessions (see \a G_ENABLE_SESSIONS ), chunked input with \a gshell_processShellBuffer
+ * -Structured log output as JSON Lines or CBOR (see \a G_ENABLE_LOGFORMAT )
+ * -Trace spans with the 'trace' command, Chrome trace-event export (see \a G_ENABLE_TRACE )
+ * -Interrupt-safe receive ring drained by \a gshell_poll (see \a G_ENABLE_RXRING )
+ * -Blocking commands on worker threads, \a gshell_putStringAsync (see \a G_ENABLE_WORKERS )
+ * -Prioritised output queues, error messages overtake bulk output (see \a G_ENABLE_TXQUEUES )
+ * -Number and hexdump output without vsprintf: \a gshell_putU32 , \a gshell_putHex , \a gshell_hexdump
+ * -Log call-site registry, single log lines switched with 'logsite' (see \a G_ENABLE_LOGSITES )
+ * -'watch' and 'repeat' commands, scheduled by \a gshell_poll (see \a G_ENABLE_WATCH )
+ * -Block-wise (SIMD) scanning of bulk input and command lines (see \a G_ENABLE_SIMDSCAN )
+ * -Tickless main loops: \a gshell_hasPendingWork , \a gshell_nextDeadline , \a gshell_setWakeup
+ * -Command completion queue with 32-bit results and timestamps (see \a G_ENABLE_RESULTQUEUE )
+ * -64-bit microsecond log timestamps, absolute or delta (see \a G_ENABLE_TIMESTAMP64 )
+ * -Log bursts printed as one block, the promt is redrawn afterwards (see \a G_ENABLE_DEFERPROMPT )
+ *
+ * \version 2.2
+ * -Refined documentation, fixed minor bug
+ *
+ * \version 2.1
+ * -Quotation-Marks detection and processing added (see \a G_ENABLE_SPECIALCMDSTR )
+ *
+ * \version 2.0
+ * -Rework of the library, proper documentation
+ *
+ * \file gshell.h
+ * \author gfcwfzkm
+ * \date 08.10.2022
+ * \copyright GNU Lesser General Public License v2.1
+ *
+ * \bug No known Bugs
+ * \todo
+ * - Add quotation-marks-functionality to the string-splitting / arguments parser
+ * - Add basic cursor handling to the processShell-function
+ */
+/**
+ * @file gshell.h
+ * @brief Header-File of gshell library
+ */
+#ifndef GSHELL_H_
+#define GSHELL_H_
+
+/* --Includes-- */
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/****** USER CONFIGURATION STARTS HERE ******/
+/**
+ * @brief Enable static shell commands
+ */
+//#define ENABLE_STATIC_COMMANDS
+
+/**
+ * @brief Enable (/ Disable) echoing of the input back to the output
+ */
+#define G_ENABLE_ECHO
+
+/**
+ * @brief Use CR instead of LF to detect a new-line/enter keypress
+ */
+//#define G_CR_INSTEADOF_LF
+
+/**
+ * @brief Receive Buffer, also defines a AVR temporary buffer size (2x on AVR)
+ */
+#define G_RX_BUFSIZE	120
+
+/**
+ * @brief Amount of max. pointers passed as *argv[]
+ */
+#define G_MAX_ARGS		16
+
+/**
+ * @brief Enables specialised command string processing
+ *
+ * Allows ' and " characters to be used in order to not split
+ * by spaces.
+ */
+#define G_ENABLE_SPECIALCMDSTR
+
+/**
+ * @brief Enables context-carrying command handlers
+ *
+ * Adds \a handlerCtx and \a ctx to \a gshell_cmd_t. The context handler
+ * receives a user pointer and the length of every argument as measured by
+ * the tokenizer. Required by the C++ wrapper in gshell.hpp.
+ */
+//#define G_ENABLE_CMDCONTEXT
+
+/**
+ * @brief Enables terminal capability profiles
+ *
+ * Allows to switch between full ANSI output, minimal output (no text formatting,
+ * only line control) and plain text, see \a gshell_setTermProfile
+ */
+//#define G_ENABLE_TERMPROFILES
+
+/**
+ * @brief Enables command groups with subcommands
+ *
+ * Commands can hold their own list of subcommands, registered with
+ * \a gshell_register_subcmd (for example 'net ifconfig', 'net stats').
+ */
+//#define G_ENABLE_SUBCOMMANDS
+
+/**
+ * @brief Enables typed argument schemas
+ *
+ * Commands can describe their arguments with a \a gshell_arg_t list. The shell
+ * then validates and converts them before calling the handler, see \a gshell_args
+ * A schema holds \a G_MAX_ARGS entries at most, which may not exceed 32.
+ */
+//#define G_ENABLE_ARGSCHEMA
+
+/**
+ * @brief Enables log sinks
+ *
+ * Every log message is formatted once and handed over to all sinks registered with
+ * \a gshell_addSink whose level threshold matches - for example a debug channel,
+ * a second UART or a file (see host/gshell_maplog.h). Each sink can buffer its output
+ * and has its own flush policy, so a slow sink never holds back the others.
+ */
+//#define G_ENABLE_LOGSINKS
+
+/**
+ * @brief Enables structured log output
+ *
+ * Log records can be sent as JSON Lines or CBOR instead of formatted text, see
+ * \a gshell_setLogFormat . Adds \a glog_src to log with source file and line.
+ */
+//#define G_ENABLE_LOGFORMAT
+
+/**
+ * @brief Enables the log history
+ *
+ * Keeps the latest log records in a RAM ring buffer of \a G_LOGHISTORY_SIZE bytes,
+ * placed in a section that isn't cleared on a (warm) reset. After a watchdog reset
+ * the records are validated and kept, and can be printed with the 'dmesg' command.
+ * A reset while a record is written loses that record only.
+ */
+//#define G_ENABLE_LOGHISTORY
+
+/**
+ * @brief Enables multiple terminal sessions
+ *
+ * Every session has its own output function, input buffer, prompt and terminal
+ * profile, all sharing the same commands. Switch between them with
+ * \a gshell_sessionSelect (see host/gshell_server.h for a socket server).
+ */
+//#define G_ENABLE_SESSIONS
+
+/**
+ * @brief Enables the receive ring buffer
+ *
+ * Received characters are stored with \a gshell_rxPush (safe to call within the
+ * receive interrupt) and processed later by \a gshell_poll within the main loop,
+ * so no command is ever run in interrupt context.
+ */
+//#define G_ENABLE_RXRING
+
+/**
+ * @brief Size of the receive ring buffer in bytes, has to be a power of two
+ */
+#define G_RXRING_SIZE	64
+
+/**
+ * @brief Enables worker threads for blocking commands (hosts only)
+ *
+ * Commands with \a blocking set are passed to the dispatcher of \a gshell_setDispatcher
+ * instead of being executed right away, so input and logging go on while they
+ * run (see host/gshell_worker.h for a thread pool). The selected session and the
+ * formatting buffers become thread-local. Requires \a G_ENABLE_SESSIONS and C11.
+ */
+//#define G_ENABLE_WORKERS
+
+/**
+ * @brief Enables the prioritised output queues
+ *
+ * Output is queued instead of being sent right away, split up into error / fatal
+ * log messages, the other log messages and everything else (command output, echo,
+ * prompt). \a gshell_txDrain sends the highest priority first, switching queues at
+ * line ends only - a error message waits for one line of bulk output at most.
+ * Fatal messages are sent right away. The prompt erased by a log message is
+ * redrawn once all queues are empty, or on the next input.
+ */
+//#define G_ENABLE_TXQUEUES
+
+/**
+ * @brief Size of each output queue in bytes, three per session, has to be a power of two
+ */
+#define G_TXQUEUE_SIZE	128
+
+/**
+ * @brief Size of the log history ring buffer in bytes
+ */
+#define G_LOGHISTORY_SIZE	512
+
+/**
+ * @brief Attribute placing the log history in RAM that isn't cleared during startup
+ *
+ * Make sure your linker script keeps the section (avr-gcc and most ARM
+ * startup files know '.noinit').
+ */
+#ifndef G_NOINIT
+	#define G_NOINIT	__attribute__((section(".noinit")))
+#endif
+
+/**
+ * @brief Enables trace spans
+ *
+ * Records begin / end / instant events (see \a gshell_trace_begin ) as small binary
+ * entries into a ring buffer, without any formatting. The built-in 'trace dump'
+ * command prints them as Chrome trace-event JSON, viewable in Perfetto. Recording
+ * masks the interrupts for a few instructions on AVR and Cortex-M.
+ */
+//#define G_ENABLE_TRACE
+
+/**
+ * @brief Amount of trace events kept, has to be a power of two
+ */
+#define G_TRACE_SIZE	64
+
+/**
+ * @brief Enables the log call-site registry
+ *
+ * Every glog macro places a descriptor (file, line, format, enabled flag) into the
+ * 'gshell_logsites' linker section, so single log lines can be switched on and off
+ * at runtime with the built-in 'logsite' command. A disabled line costs one load
+ * and branch. Requires GCC / Clang and a ELF linker.
+ *
+ * The descriptors are initialised data. A linker script has to place the section
+ * within .data (copied from flash by the startup code) and define the symbols
+ * __start_gshell_logsites and __stop_gshell_logsites around it:
+ *
+ * . = ALIGN(4);
+ * __start_gshell_logsites = .;
+ * KEEP(*(gshell_logsites))
+ * __stop_gshell_logsites = .;
+ *
+ * GNU ld does this on its own for scripts without a SECTIONS entry covering it (hosts).
+ */
+//#define G_ENABLE_LOGSITES
+
+/**
+ * @brief Enables the built-in 'watch' and 'repeat' commands
+ *
+ * 'watch [-n <ms>] [-c] <cmd ...>' runs a command every \a ms milliseconds (1000 by
+ * default), 'repeat <N> [-n <ms>] <cmd ...>' runs it N times. The command is resolved
+ * and split into arguments once, the runs are scheduled by \a gshell_poll on the
+ * millisecond timestamp. With -c the screen is redrawn from the top instead of
+ * scrolling. Any key on the terminal stops it, only one command is watched at a time.
+ */
+//#define G_ENABLE_WATCH
+
+/**
+ * @brief Enables the block-wise input scanner
+ *
+ * \a gshell_processShellBuffer takes runs of printable characters at once instead of
+ * one by one, and command lines are split into arguments by masks of whole blocks.
+ * Uses AVX2, SSE2 or NEON if the compiler targets them (16 - 32 bytes per step),
+ * plain C otherwise. Meant for hosts fed with large pasted scripts or captured logs.
+ */
+//#define G_ENABLE_SIMDSCAN
+
+/**
+ * @brief Enables the command completion queue
+ *
+ * Each command that returned a non-zero value or posted one with \a gshell_setResult
+ * leaves a record (command ID, return value, 32-bit value, timestamp) in a queue,
+ * taken out with \a gshell_popResult . Unlike the packed return value of
+ * \a gshell_processShell , no result gets lost if several commands complete
+ * before the application looks. The old return values stay as they are.
+ */
+//#define G_ENABLE_RESULTQUEUE
+
+/**
+ * @brief Amount of records in the completion queue, has to be a power of two (128 at most)
+ */
+#define G_RESULTQUEUE_SIZE	8
+
+/**
+ * @brief Enables the 64-bit high-resolution timestamps of log messages
+ *
+ * Log messages carry "[seconds.microseconds] " from a 64-bit time source set with
+ * \a gshell_setTimeSource (a microsecond timer or cycle counter, any frequency),
+ * either absolute or as delta since the previous message. The seconds part is
+ * only rendered again once it changed.
+ */
+//#define G_ENABLE_TIMESTAMP64
+
+/**
+ * @brief Enables the deferred prompt redraw
+ *
+ * Log messages (and \a gshell_putStringAsync ) no longer redraw the prompt and
+ * the user input after each message. A burst of messages is printed as one block,
+ * the prompt follows once \a gshell_poll finds no message within the last
+ * \a G_DEFERPROMPT_MS milliseconds, or right away when the user types.
+ * Each session is redrawn by its own \a gshell_poll call: the main loop has to
+ * call it per session and wake up by \a gshell_nextDeadline . host/gshell_tty and
+ * host/gshell_server do both.
+ */
+//#define G_ENABLE_DEFERPROMPT
+
+/**
+ * @brief Quiet time in milliseconds before the deferred prompt is redrawn, 0 to redraw on the next gshell_poll
+ */
+#define G_DEFERPROMPT_MS	20
+/****** USER CONFIGURATION ENDS HERE ******/
+
+
+/* If on a 8-bit AVR Microcontroller, store text data in flash memory */
+#if defined(AVR) && !defined(__GNUG__)	// AVR + C Compiler (GCC)
+	#include <avr/pgmspace.h>
+	#define _GMEMX	__memx
+	#define _PRGMX
+#elif defined(AVR) && defined(__GNUG__)	// AVR + C++ Compiler (G++ workaround)
+	#include <avr/pgmspace.h>
+	#define _GMEMX
+	#define _PRGMX PROGMEM
+#else	// Non-AVR Platform
+	#define _GMEMX
+	#define _PRGMX
+#endif
+
+#ifndef G_XSTR
+	/**
+	 * @brief Store string (text array) in program memory and return a pointer from it
+	 */
+	#define G_XSTR(s)	(__extension__({static _GMEMX const char __fc[] _PRGMX = (s); &__fc[0];}))
+#endif
+
+#ifndef G_XARR
+	/**
+	 * @brief Store a Array in program memory
+	 */
+	#define G_XARR(X)		( ( const _GMEMX char[] _PRGMX ) { X } )
+#endif
+
+/* ANSI ESCAPE SEQUENCES TEXT FORMATTING */
+#define G_ESCAPE		"\x1b["
+#define G_TEXTNORMAL	G_ESCAPE"0m"
+#define G_TEXTBOLD		G_ESCAPE"1m"
+#define G_TEXTUNDERLINE	G_ESCAPE"4m"
+#define G_TEXTBLINK		G_ESCAPE"5m"
+#define G_TEXTNEGATIVE	G_ESCAPE"7m"
+#define G_CLEARLINE		G_ESCAPE"2K"
+#define G_CLEARSCREEN	G_ESCAPE"2J"
+#define G_CLEARDOWN		G_ESCAPE"J"
+#define G_CURSORHOME	G_ESCAPE"H"
+/* ANSI ESCAPE SEQUENCES TEXT COLOR */
+#define G_COLORRESET	G_ESCAPE"39m"
+#define G_COLORRED		G_ESCAPE"31m"
+#define G_COLORGREEN	G_ESCAPE"32m"
+#define G_COLORYELLOW	G_ESCAPE"33m"
+#define G_COLORBLUE		G_ESCAPE"34m"
+#define G_COLORMAGENTA	G_ESCAPE"35m"
+#define G_COLORCYAN		G_ESCAPE"36m"
+#define G_COLORWHITE	G_ESCAPE"37m"
+#define G_COLORCUSTOM(r,g,b) \
+		G_ESCAPE"38m;2;"r";"g";"b
+
+
+/* General Terminal Sequences */
+#define G_CRLF			"\r\n"
+#define C_NEWLINE		'\n'
+#define C_CARRET		'\r'
+#define C_BACKSPCE1		'\b'
+#define C_BACKSPCE2		0x7F
+#define C_WITESPCE		' '
+#define C_NULLCHAR		'\0'
+
+#ifdef G_ENABLE_ARGSCHEMA
+/**
+ * @brief Argument types of a argument schema
+ */
+enum garg_type{
+	GARG_INT	= 0,	/**< Signed decimal integer, stored in \a gshell_argval_t .i */
+	GARG_HEX,			/**< Unsigned hexadecimal integer, with or without 0x, stored in .u */
+	GARG_FLOAT,			/**< Decimal floating point number (1.5, -2e3), stored in .f */
+	GARG_ENUM,			/**< One of the keywords, index stored in .e */
+	GARG_FLAG,			/**< Option (for example '-v') anywhere in the arguments, .e is 1 if present */
+	GARG_STR			/**< Any text, pointer stored in .s */
+};
+
+/**
+ * @brief Argument schema entry
+ *
+ * A command's arguments are described by an array of these. Flags may appear
+ * anywhere, all other types are positional in the order of the array.
+ */
+typedef struct gshell_arg {
+	const _GMEMX char *name;		/**< Name shown in the usage text, the option itself for GARG_FLAG */
+	uint8_t type;					/**< enum \a garg_type */
+	uint8_t optional;				/**< Non-zero if the argument may be omitted (only trailing positionals) */
+	int32_t min;					/**< GARG_INT/GARG_HEX: smallest allowed value, unchecked if min and max are zero */
+	int32_t max;					/**< GARG_INT/GARG_HEX: largest allowed value (compared unsigned for GARG_HEX) */
+	const _GMEMX char *keywords;	/**< GARG_ENUM: keywords seperated by '|', for example "on|off|toggle" */
+} gshell_arg_t;
+
+/**
+ * @brief Converted argument value, in the order of the argument schema
+ */
+typedef union gshell_argval {
+	int32_t i;		/**< GARG_INT */
+	uint32_t u;		/**< GARG_HEX */
+	float f;		/**< GARG_FLOAT */
+	uint8_t e;		/**< GARG_ENUM keyword index, GARG_FLAG presence */
+	const char *s;	/**< GARG_STR */
+} gshell_argval_t;
+#endif
+
+/**
+ * @brief Shell command structure
+ * 
+ * Structure containing the command's name, a pointer to the function as well as a basic description.
+ * The optional members depend on the configuration, better use designated initialisers
+ * when any of them is enabled.
+ */
+typedef struct gshell_cmd {
+	const _GMEMX char *cmdName;						/**< String - command name (case sensitive) */
+	uint8_t (*handler)(uint8_t argc, char *argv[]);	/**< function pointer to the command's funciton */
+	const _GMEMX char *desc;						/**< String - basic, short description of the command */
+	struct gshell_cmd *next;						/**< Don't assign this yourself! Used in dynamic command list */
+#ifdef G_ENABLE_ARGSCHEMA
+	const _GMEMX gshell_arg_t *args;				/**< Optional argument schema, NULL to pass the arguments unchecked */
+	uint8_t argsCount;								/**< Amount of entries in \a args , \a G_MAX_ARGS at most */
+#endif
+#ifdef G_ENABLE_CMDCONTEXT
+	/** Optional handler with user context and argument lengths, called instead of \a handler if set */
+	uint8_t (*handlerCtx)(void *ctx, uint8_t argc, char *argv[], const uint8_t argl[]);
+	void *ctx;										/**< User context pointer passed to \a handlerCtx */
+#endif
+#ifdef G_ENABLE_SUBCOMMANDS
+	struct gshell_cmd *sub;							/**< Don't assign this yourself! First subcommand of a command group */
+	int16_t id;										/**< Don't assign this yourself! Command ID, set during registration */
+#endif
+#ifdef G_ENABLE_WORKERS
+	uint8_t blocking;								/**< Non-zero to run the command on a worker thread */
+#endif
+} gshell_cmd_t;
+
+/**
+ * @brief logging level
+ * 
+ * Basic logging levels, highlighted by different colours and formats
+ */
+enum glog_level{
+	GLOG_NORMAL	= 0,	/**< No Text, normal color */
+	GLOG_INFO	= 1,	/**< 'INFO' Text, normal color */
+	GLOG_OK		= 2,	/**< 'OK' Text, green color */
+	GLOG_WARN	= 3,	/**< 'WARN' text, yellow color */
+	GLOG_ERROR	= 4,	/**< 'ERROR' text, red color */
+	GLOG_FATAL	= 5		/**< 'FATAL' text, red and blink */
+};
+
+
+/**
+ * @brief Terminal capability profile
+ *
+ * Selects how much ANSI decoration is sent to the terminal. Requires \a G_ENABLE_TERMPROFILES
+ */
+enum gshell_termprofile{
+	GSHELL_TERM_ANSI	= 0,	/**< Full ANSI output: colours, text formatting and line control */
+	GSHELL_TERM_MINIMAL	= 1,	/**< Line control only (clear line), no colours or text formatting */
+	GSHELL_TERM_PLAIN	= 2		/**< Plain text, no escape sequences at all */
+};
+
+#ifdef G_ENABLE_LOGFORMAT
+/**
+ * @brief Log output format
+ *
+ * The structured formats carry the same fields: "level" (name as text), "ts"
+ * (if a timestamp function has been given), "msg" and, if logged with \a glog_src ,
+ * "file" and "line".
+ */
+enum gshell_logformat{
+	GSHELL_LOGFMT_TEXT	= 0,	/**< Formatted text with level prefix, the default */
+	GSHELL_LOGFMT_JSON	= 1,	/**< One JSON object per line (JSON Lines) */
+	GSHELL_LOGFMT_CBOR	= 2		/**< One CBOR map per record (CBOR sequence, RFC 8742) */
+};
+#endif
+
+#if defined(G_ENABLE_LOGSINKS) || defined(G_ENABLE_LOGFORMAT)
+/**
+ * @brief Formatted log record
+ *
+ * Passed over to the log sinks, only valid during the sink call.
+ */
+typedef struct gshell_logrec {
+	enum glog_level level;	/**< Logging level of the record */
+	uint32_t timestamp;		/**< Millisecond tick, zero if no timestamp function has been given */
+	const char *text;		/**< Formatted message, without level prefix or line ending, NULL-terminated */
+	uint16_t length;		/**< Length of the message */
+	const _GMEMX char *file;	/**< Source file (program memory), NULL if not logged with \a glog_src */
+	uint16_t line;			/**< Source line, zero if not logged with \a glog_src */
+} gshell_logrec_t;
+#endif
+
+#ifdef G_ENABLE_LOGSINKS
+
+/**
+ * @brief Flush policy of a buffered log sink
+ */
+enum gshell_sinkflush{
+	GSINK_FLUSH_RECORD	= 0,	/**< Flush after every record */
+	GSINK_FLUSH_FULL	= 1,	/**< Flush once the next record doesn't fit into the buffer anymore */
+	GSINK_FLUSH_MANUAL	= 2		/**< Only flush on \a gshell_flushSinks , records are dropped while the buffer is full */
+};
+
+/**
+ * @brief Log sink
+ *
+ * A sink receives the records at or above \a minLevel in two possible ways, both
+ * can be used at the same time:
+ * - \a write is called right away with the record (for fast sinks, like a RAM or file log)
+ * - If \a buf is given, the record is stored as text line ("[ WARN ] [000001234] text\r\n")
+ *   within the buffer and passed over to \a flush according to \a flushPolicy .
+ *   \a flush may take less than offered (for example a non-blocking UART), the rest
+ *   is kept for the next flush.
+ */
+typedef struct gshell_sink {
+	void (*write)(void *ctx, const gshell_logrec_t *record);				/**< Receives every record right away, optional */
+	uint16_t (*flush)(void *ctx, const char *data, uint16_t length);		/**< Receives the buffered text, returns the amount of bytes taken */
+	void *ctx;							/**< User context passed over to write and flush */
+	enum glog_level minLevel;			/**< Lowest logging level passed over to this sink */
+	enum gshell_sinkflush flushPolicy;	/**< When the buffer is passed over to flush */
+	char *buf;							/**< Text buffer, NULL for an unbuffered sink */
+	uint16_t bufSize;					/**< Size of the text buffer */
+	uint16_t bufFill;					/**< Amount of buffered bytes, internal */
+	uint16_t dropped;					/**< Amount of records dropped due to a full buffer */
+#ifdef G_ENABLE_LOGFORMAT
+	enum gshell_logformat format;		/**< Format of the buffered records */
+#endif
+	struct gshell_sink *next;			/**< Next sink, internal */
+} gshell_sink_t;
+#endif
+
+#define _G_ESCSEQ_BUFLEN	8
+
+/**
+ * @brief Terminal session
+ *
+ * State of a single terminal: output function, input buffer, prompt and terminal
+ * profile. \a gshell_init sets up the default session, further ones can be used with
+ * \a G_ENABLE_SESSIONS . The fields are internal, use the gshell functions instead.
+ */
+typedef struct gshell_session {
+	void (*fp_putChar)(char);			/**< Functionspointer to send a char */
+	uint8_t rx_index;					/**< Receive Buffer Index */
+	char rx_buf[G_RX_BUFSIZE];			/**< Receive Buffer, G_RX_BUFSIZE Bytes */
+	uint8_t isActive:1;					/**< Enable the whole shell, including any basic printing or reading */
+	uint8_t promtEnabled:1;				/**< Enable the shell promt, controls input processing by the user */
+#ifdef G_ENABLE_TERMPROFILES
+	uint8_t termProfile;				/**< enum gshell_termprofile in use */
+	uint8_t daState;					/**< Device Attributes response parser state, 0 if no query is pending */
+	uint32_t daSince;					/**< Timestamp of the Device Attributes query */
+	uint8_t outEscLen;					/**< Amount of characters in outEscBuf, non-zero while filtering a escape sequence */
+	char outEscBuf[_G_ESCSEQ_BUFLEN];	/**< Holds back a outgoing escape sequence until its final character */
+#endif
+#ifdef G_ENABLE_LOGFORMAT
+	uint8_t logFormat;					/**< enum gshell_logformat of the log output */
+#endif
+#ifdef G_ENABLE_TXQUEUES
+	uint8_t txCur;						/**< Queue being sent, kept until its line is complete */
+	struct {
+		uint16_t head;					/**< Next position to write, not masked */
+		uint16_t tail;					/**< Next position to send, not masked */
+		char buf[G_TXQUEUE_SIZE];		/**< Queued characters */
+	} txq[3];							/**< Output queues: output, log messages, errors */
+	uint8_t txPromt;					/**< Promt and input erased by a log message, redrawn once the queues are empty */
+#endif
+#ifdef G_ENABLE_DEFERPROMPT
+	uint8_t promtDeferred;				/**< Promt and input not redrawn yet after the last log message */
+	uint32_t lastLog;					/**< Timestamp of the last log message, for the deferred redraw */
+#endif
+#ifdef G_ENABLE_SESSIONS
+	void *user;							/**< Free to use by the application, not touched by gshell */
+#endif
+} gshell_session_t;
+
+#define GSHELL_CMDRET_MASK      0x7F
+#define GSHELL_CMDRET_VAL(x)    (uint8_t)(x >> 8)
+/**
+ * @brief gshell-return status
+ *
+ * Information about buffer status or cmd function returns
+ */
+enum gshell_return{
+	GSHELL_OK		= 0,	/**< Everything okay, nothing to report */
+	GSHELL_INACTIVE,		/**< gshell inactive, character inputs ignored */
+	GSHELL_BUFFULL,			/**< text input buffer full! */
+	GSHELL_RUBBISH,			/**< Unrecognised data/command, discarded */
+	GSHELL_CMDINV,			/**< Unrecognised command / command not found */
+	GSHELL_ESCSEQ,			/**< Is processing a ANSI Escape Sequence */
+	GSHELL_ARGINV,			/**< Arguments didn't match the command's argument schema */
+	GSHELL_CMDQUEUED,		/**< Command handed over to a worker thread, its result follows later */
+	GSHELL_CMDRET	= 0x80	/**< Command returned Value, lower 7-bits contain command ID */
+};
+
+/**
+ * @brief Command result
+ *
+ * Filled in by \a gshell_processShellEx when a command returned a value
+ */
+typedef struct gshell_result {
+	int16_t cmdID;			/**< Full 16-bit ID of the command that returned the value */
+	uint8_t value;			/**< Value returned by the command */
+} gshell_result_t;
+
+#ifdef G_ENABLE_RESULTQUEUE
+#define GSHELL_RESF_VALUE		0x01	/**< Record flag: \a value has been posted with \a gshell_setResult */
+#define GSHELL_RESF_SCHEDULED	0x02	/**< Record flag: Run by 'watch' / 'repeat' */
+
+/**
+ * @brief Completion record, taken out of the queue with \a gshell_popResult
+ */
+typedef struct gshell_resultrec {
+	uint32_t value;			/**< Value posted with \a gshell_setResult , 0 if none */
+	uint32_t timestamp;		/**< Millisecond timestamp of the completion, 0 without timestamp function */
+	int16_t cmdID;			/**< Full 16-bit ID of the command */
+	uint8_t status;			/**< Value returned by the command handler */
+	uint8_t flags;			/**< GSHELL_RESF_ flags */
+} gshell_resultrec_t;
+#endif
+
+/* Static command list. Use as followed in a seperate file (eg. 'commands.c':
+ *
+ * #include "gshell.h"
+ *
+ * void cli_cmd_hello(uint8_t argc, char *argv[])
+ * {
+	 gshell_putString_f("Hello World!\r\n");
+ * }
+ *
+ * static const gshell_cmd_t shell_command_list[] = {
+ *	 {G_XARR("hello"),	cli_cmd_hello,	G_XARR("Say Hello")}
+ * // Simply add more commands here
+ * };
+ * 
+ * const gshell_cmd_t *const gshell_list_commands = shell_command_list;
+ * const uint8_t gshell_list_num_commands = sizeof(shell_command_list) / sizeof(shell_command_list[0]);
+ */
+#ifdef ENABLE_STATIC_COMMANDS
+extern const gshell_cmd_t *const gshell_list_commands;
+extern const uint8_t gshell_list_num_commands;
+#endif 
+
+
+/**
+ * @brief Initialise the shell
+ * 
+ * Initialise the console's internal variables and passes over the function to send
+ * a character and to get a millisecond-timestamp for the logging functions.
+ * If no millisecond-timestamp is wished, replace it with 'NULL' instead.
+ * 
+ * @param putchar			Function pointer to print a character
+ * @param get_msTimeStamp	Function pointer to get the milliseconds timestamp as uint32_t
+ *
+ * The built-in commands are registered right after 'help' (ID 0), in the order
+ * 'dmesg' (if \a G_ENABLE_LOGHISTORY ), 'trace' (if \a G_ENABLE_TRACE ), 'logsite' (if
+ * \a G_ENABLE_LOGSITES ), 'watch' and 'repeat' (if \a G_ENABLE_WATCH ). Your commands
+ * follow after.
+ */
+int8_t gshell_init(void (*put_char)(char), uint32_t (*get_msTimeStamp)(void));
+
+/**
+ * @brief Register a command
+ * 
+ * Register a console command yourself by passing over the pointer of your
+ * gshell_cmd_t command definition.
+ *
+ * @param cmd	Pointer to a initialised gshell_cmd_t struct
+ * @return		Returns the ID of the command, which is the amount of commands
+ *				registered before. If the value is negative, the command couldn't be added
+ *				(no space left or more schema entries than \a G_MAX_ARGS ).
+ */
+int16_t gshell_register_cmd(gshell_cmd_t *cmd);
+
+#ifdef G_ENABLE_SUBCOMMANDS
+/**
+ * @brief Register a subcommand
+ *
+ * Adds a command to the own command list of a group. The group itself is a
+ * normal command, registered with \a gshell_register_cmd or as a subcommand
+ * of another group. Entering 'group cmd ...' calls the subcommand's handler with
+ * argv[0] being the subcommand's name. A group without handler lists its
+ * subcommands, as does 'help group'. Static commands can't be groups.
+ *
+ * @param group	Pointer to the registered command group
+ * @param cmd	Pointer to a initialised gshell_cmd_t struct
+ * @return		Returns the ID of the command. If the value is negative,
+ *				the command couldn't be added.
+ */
+int16_t gshell_register_subcmd(gshell_cmd_t *group, gshell_cmd_t *cmd);
+#endif
+
+/**
+ * @brief Returns the ID of a command
+ *
+ * Searches the internal command list for the command name passed
+ * over to this function and returns the corresponding command ID
+ * when it's found, otherwise returns -1
+ *
+ * @param cmd_name	Name of the command
+ * @return			-1 if not found, non-negative ID otherwise
+ */
+int16_t gshell_getCmdIDbyName(const char* cmd_name);
+
+/**
+ * @brief Returns the ID of a command
+ *
+ * Searches the internal command list for the matching command
+ * structure passed over to this function. Returns the command
+ * ID when it's found, otherwise returns -1
+ *
+ * @param cmd		Pointer to the gshell_cmd_t command
+ * @return			-1 if not found, non-negative ID otherwise
+ */
+int16_t gshell_getCmdIDbyStruct(gshell_cmd_t *cmd);
+
+#ifdef G_ENABLE_ARGSCHEMA
+/**
+ * @brief Converted arguments of the running command
+ *
+ * Call from within a command handler that has a argument schema. The values
+ * are in the order of the schema entries and only valid during the handler call.
+ *
+ * @return	Array of converted values, one per schema entry
+ */
+const gshell_argval_t *gshell_args(void);
+
+/**
+ * @brief Checks if a schema argument has been given
+ *
+ * @param index	Index of the schema entry
+ * @return		Non-zero if the argument (or flag) was present
+ */
+uint8_t gshell_argGiven(uint8_t index);
+#endif
+
+#ifdef G_ENABLE_LOGHISTORY
+/**
+ * @brief Clears the log history
+ */
+void gshell_logHistoryClear(void);
+
+/**
+ * @brief Amount of records in the log history
+ *
+ * Right after \a gshell_init , these are the records that survived the reset.
+ *
+ * @return	Amount of records stored
+ */
+uint16_t gshell_logHistoryCount(void);
+#endif
+
+#ifdef G_ENABLE_TRACE
+/**
+ * @brief Trace event types, see \a gshell_trace_begin
+ */
+enum gshell_tracetype{
+	GTRACE_BEGIN	= 'B',	/**< Start of a span */
+	GTRACE_END		= 'E',	/**< End of the latest span of the same context */
+	GTRACE_INSTANT	= 'i'	/**< Single point in time */
+};
+
+/**
+ * @brief Set the clock of the trace events
+ *
+ * Defaults to the milliseconds tick of \a gshell_init . A faster clock, like
+ * a cycle counter or a free-running timer, gives more useful spans.
+ *
+ * @param get_tick			Function pointer returning the current tick
+ * @param ticksPerSecond	Frequency of the tick
+ */
+void gshell_traceClock(uint32_t (*get_tick)(void), uint32_t ticksPerSecond);
+
+/**
+ * @brief Record a trace event
+ *
+ * Stores the name pointer, the tick and the context ID, overwriting the oldest
+ * event once the ring is full. Use the macros below instead.
+ *
+ * @param type	enum \a gshell_tracetype
+ * @param name	Program-memory-pointer to the event name, not copied. NULL for the end of a span
+ * @param ctx	Context ID (thread / task / interrupt), shown as separate track
+ */
+void gshell_traceEvent(enum gshell_tracetype type, const _GMEMX char *name, uint8_t ctx);
+
+/**
+ * @brief Start a trace span
+ *
+ * Spans of the same context have to be nested, each \a gshell_trace_begin
+ * is closed by a \a gshell_trace_end .
+ *
+ * @param __n	Name of the span, stored in program memory
+ */
+#define gshell_trace_begin(__n)				gshell_traceEvent(GTRACE_BEGIN, G_XSTR(__n), 0)
+
+/**
+ * @brief End the latest trace span
+ */
+#define gshell_trace_end()					gshell_traceEvent(GTRACE_END, NULL, 0)
+
+/**
+ * @brief Record a instant trace event
+ *
+ * @param __n	Name of the event, stored in program memory
+ */
+#define gshell_trace_instant(__n)			gshell_traceEvent(GTRACE_INSTANT, G_XSTR(__n), 0)
+
+/**
+ * @brief Start / end a trace span within another context (for example a interrupt)
+ *
+ * @param __n	Name of the span, stored in program memory
+ * @param __c	Context ID, 0 is the main context
+ */
+#define gshell_trace_beginCtx(__n,__c)		gshell_traceEvent(GTRACE_BEGIN, G_XSTR(__n), __c)
+#define gshell_trace_endCtx(__c)			gshell_traceEvent(GTRACE_END, NULL, __c)
+#endif
+
+/**
+ * @brief Set Shell Active
+ *
+ * Enables or disables the whole terminal and logging functionality
+ * Enabled by default when initialising gshell (\a gshell_init )
+ *
+ * @param activeStatus	0 to disable, non-zero to enable the terminal
+ */
+void gshell_setActive(uint8_t activeStatus);
+
+/**
+ * @brief Enable or disable the promt
+ *
+ * Enables or disables the console promt and text input
+ *
+ * @param promtStatus	0 to disable, non-zero to enable the promt
+ */
+void gshell_setPromt(uint8_t promtStatus);
+
+#ifdef G_ENABLE_SESSIONS
+/**
+ * @brief Initialise a terminal session
+ *
+ * The session starts active, with the prompt disabled and a empty input buffer.
+ * Nothing is printed, select it and enable the prompt afterwards.
+ *
+ * @param session	Session to initialise, has to stay valid while in use
+ * @param put_char	Function pointer to send a character to this terminal
+ */
+void gshell_sessionInit(gshell_session_t *session, void (*put_char)(char));
+
+/**
+ * @brief Release a terminal session
+ *
+ * Call before the memory of the session is freed or reused. Stops 'watch' /
+ * 'repeat' if they run on it and selects the default session in its place.
+ *
+ * @param session	Session which is closed
+ */
+void gshell_sessionClose(gshell_session_t *session);
+
+/**
+ * @brief Select the terminal session
+ *
+ * All following input processing and output (commands, logging, prompt) uses
+ * the selected session.
+ *
+ * @param session	Session to select, NULL for the default session of \a gshell_init
+ * @return			Previously selected session
+ */
+gshell_session_t *gshell_sessionSelect(gshell_session_t *session);
+
+/**
+ * @brief Returns the selected terminal session
+ */
+gshell_session_t *gshell_sessionGet(void);
+#endif
+
+#ifdef G_ENABLE_WORKERS
+/**
+ * @brief Set the dispatcher of blocking commands
+ *
+ * Called instead of the handler of a command with \a blocking set, after its
+ * arguments have been checked. \a argv points into the input buffer and has to be
+ * copied. Return non-zero if the command has been taken over (processing then
+ * returns \a GSHELL_CMDQUEUED ), zero to execute it right away instead.
+ *
+ * @param dispatch	Dispatcher function, NULL to execute all commands right away
+ */
+void gshell_setDispatcher(uint8_t (*dispatch)(const gshell_cmd_t *cmd, int16_t cmdID, uint8_t argc, char *argv[]));
+
+/**
+ * @brief Execute a command taken over by the dispatcher
+ *
+ * Call on the worker thread with the selected session receiving the output.
+ *
+ * @param cmd		Command to execute
+ * @param argc		Amount of arguments, including the command name
+ * @param argv		Arguments, argv[0] being the command name
+ * @return			Return value of the command
+ */
+uint8_t gshell_runCmd(const gshell_cmd_t *cmd, uint8_t argc, char *argv[]);
+
+/**
+ * @brief Set the lock of the log sinks and the log history
+ *
+ * Logging from worker threads shares the sinks and the history with all other
+ * threads, \a lock is called with 1 before and 0 after using them. Adding and
+ * removing sinks, 'dmesg' and clearing the history take it as well. It is never
+ * taken twice by the same thread, a non-recursive mutex is enough.
+ *
+ * @param lock	Lock function, NULL if logging happens on a single thread only
+ */
+void gshell_setLock(void (*lock)(uint8_t acquire));
+#endif
+
+#ifdef G_ENABLE_TXQUEUES
+/**
+ * @brief Send queued output
+ *
+ * Sends up to \a maxChars queued characters of the selected session through its
+ * output function, error messages first. Call from the main loop or whenever the
+ * transmitter is ready for more. Not interrupt safe. A full queue is sent right away
+ * by the printing function itself.
+ *
+ * @param maxChars	Maximum amount of characters to send, 0 to send everything
+ * @return			Amount of characters sent
+ */
+uint16_t gshell_txDrain(uint16_t maxChars);
+
+/**
+ * @brief Returns the amount of queued output characters of the selected session
+ */
+uint16_t gshell_txPending(void);
+#endif
+
+/**
+ * @brief Print text produced outside of a command
+ *
+ * Erases the prompt and the user input, prints \a str and restores both, just
+ * like log messages do. Meant for output arriving later on, for example of a
+ * command executed on a worker thread.
+ *
+ * @param str	Text to print, should end with a newline
+ */
+void gshell_putStringAsync(const char *str);
+
+#ifdef G_ENABLE_TERMPROFILES
+/**
+ * @brief Set the terminal profile
+ *
+ * Selects the plain-text variants of the logging prefixes, promt and help output
+ * for the compact profiles. Escape sequences within any other printed text are
+ * filtered out as well (all of them on \a GSHELL_TERM_PLAIN, text formatting
+ * on \a GSHELL_TERM_MINIMAL). Defaults to \a GSHELL_TERM_ANSI
+ *
+ * @param profile	enum \a gshell_termprofile to use
+ */
+void gshell_setTermProfile(enum gshell_termprofile profile);
+
+/**
+ * @brief Returns the active terminal profile
+ *
+ * @return	enum \a gshell_termprofile currently in use
+ */
+enum gshell_termprofile gshell_getTermProfile(void);
+
+/**
+ * @brief Detect the terminal profile
+ *
+ * Sends a Device Attributes query (ESC [ c) and switches to \a GSHELL_TERM_PLAIN .
+ * Once the terminal answers, which is processed by \a gshell_processShell ,
+ * the profile is switched to \a GSHELL_TERM_ANSI . Dumb terminals and serial
+ * loggers don't answer and stay on plain text. The detection ends with the first
+ * character that isn't part of a answer, or after 500 ms (with a timestamp function).
+ */
+void gshell_detectTermProfile(void);
+#endif
+
+/**
+ * @brief Character-received Callback Function
+ *
+ * Call this function with every character received by your system/peripheral or
+ * driver to let gshell process the user data input
+ *
+ * @param c		8-bit Character received via UART/Terminal/etc...
+ * @return		Lower 8-bit contain the enum gshell_return, upper 8-bit the
+ *				return value of the executed command. Only the lower 7 bits of the
+ *				command ID fit in, use \a gshell_processShellEx for more than 127 commands
+ */
+uint16_t gshell_processShell(char c);
+
+/**
+ * @brief Character-received Callback Function with full command result
+ *
+ * Same as \a gshell_processShell , but reports the command result with
+ * the full 16-bit command ID.
+ *
+ * @param c			8-bit Character received via UART/Terminal/etc...
+ * @param result	Filled in if \a GSHELL_CMDRET is returned
+ * @return			enum \a gshell_return status, \a GSHELL_CMDRET if a command returned a value
+ */
+enum gshell_return gshell_processShellEx(char c, gshell_result_t *result);
+
+/**
+ * @brief Process a block of received characters
+ *
+ * Same as calling \a gshell_processShellEx for every character, for drivers that
+ * receive data in chunks. Stops after a command has been executed, so its
+ * result can be handled - call it again with the rest of the data.
+ *
+ * @param data		Received characters
+ * @param length	Amount of received characters
+ * @param consumed	Amount of characters processed, optional (NULL)
+ * @param result	Filled in if \a GSHELL_CMDRET is returned
+ * @return			\a GSHELL_CMDRET if a command returned a value, otherwise the status of the last character
+ */
+enum gshell_return gshell_processShellBuffer(const char *data, uint16_t length, uint16_t *consumed, gshell_result_t *result);
+
+/**
+ * @brief Main loop processing
+ *
+ * Call regularly from the main loop. Processes the characters received with
+ * \a gshell_rxPush (if \a G_ENABLE_RXRING ), stopping after a executed command
+ * so its result can be handled - the rest follows on the next call. Runs the
+ * command of 'watch' / 'repeat' once it is due (if \a G_ENABLE_WATCH ) and redraws
+ * the promt after a burst of log messages (if \a G_ENABLE_DEFERPROMPT ).
+ *
+ * Only the selected session is served: with \a G_ENABLE_SESSIONS , call it once per
+ * session with that session selected. host/gshell_tty and host/gshell_server do so.
+ *
+ * @param result	Filled in if \a GSHELL_CMDRET is returned
+ * @return			\a GSHELL_CMDRET if a command returned a value, otherwise the status of the last character
+ */
+enum gshell_return gshell_poll(gshell_result_t *result);
+
+/** @brief \a gshell_nextDeadline : nothing scheduled, sleep until woken up */
+#define GSHELL_NODEADLINE	0xFFFFFFFFUL
+
+/**
+ * @brief Pending work reported by \a gshell_hasPendingWork , or-ed together
+ */
+enum gshell_work {
+	GSHELL_WORK_RX		= 0x01,		/**< Received characters wait in the ring, call \a gshell_poll */
+	GSHELL_WORK_TX		= 0x02,		/**< Output waits in the queues of the selected session, call \a gshell_txDrain */
+	GSHELL_WORK_SINKS	= 0x04,		/**< Log sinks hold buffered records, call \a gshell_flushSinks */
+	GSHELL_WORK_TIMER	= 0x08,		/**< 'watch' / 'repeat' of the selected session is due, call \a gshell_poll */
+	GSHELL_WORK_PROMPT	= 0x10		/**< The deferred promt of the selected session is due, call \a gshell_poll */
+};
+
+/**
+ * @brief Returns what gshell has to do right now
+ *
+ * For tickless main loops: once this returns 0 and \a gshell_nextDeadline is in
+ * the future, the shell has nothing to do until then - or until the wakeup
+ * callback ( \a gshell_setWakeup ) is called. Partially received escape sequences
+ * hold no timed state, they are resolved by the next character. The same goes for
+ * a pending terminal detection ( \a gshell_detectTermProfile ): any character other
+ * than the answer ends it, and its timeout is only checked when a character arrives.
+ *
+ * @return		\a gshell_work bits, 0 if there is nothing to do
+ */
+uint8_t gshell_hasPendingWork(void);
+
+/**
+ * @brief Returns the time until gshell_poll has scheduled work
+ *
+ * Meant for programming a wakeup timer before going to sleep. Only the timed
+ * work is taken into account, check \a gshell_hasPendingWork for the rest.
+ *
+ * @return		Milliseconds until the next scheduled run or deferred promt redraw, 0 if due,
+ *				\a GSHELL_NODEADLINE if nothing is scheduled
+ */
+uint32_t gshell_nextDeadline(void);
+
+/**
+ * @brief Set the wakeup callback
+ *
+ * Called when work becomes pending outside of the main loop: the receive ring
+ * or a output queue going from empty to non-empty, or a buffered log sink
+ * receiving its first record. Thus it may be called within the receive interrupt
+ * or by a log call within any interrupt, keep it short (set a flag, post an event).
+ * Set it before enabling the interrupts.
+ *
+ * @param wakeup	Callback, NULL to disable
+ */
+void gshell_setWakeup(void (*wakeup)(void));
+
+#ifdef G_ENABLE_RESULTQUEUE
+/**
+ * @brief Post the 32-bit result of the running command
+ *
+ * Call within a command handler. The value is queued together with the return
+ * value of the handler once it returns, even if that one is 0.
+ *
+ * @param value		Result of the command
+ */
+void gshell_setResult(uint32_t value);
+
+/**
+ * @brief Take the oldest record out of the completion queue
+ *
+ * @param record	Filled in if a record was waiting
+ * @return			1 if a record has been taken, 0 if the queue is empty
+ */
+uint8_t gshell_popResult(gshell_resultrec_t *record);
+
+/**
+ * @brief Returns the amount of records dropped due to a full completion queue
+ */
+uint16_t gshell_resultOverruns(void);
+
+#ifdef G_ENABLE_WORKERS
+/**
+ * @brief Returns the value posted by the command run last on this thread
+ *
+ * Call on the worker thread right after \a gshell_runCmd , then hand the value
+ * over to the input thread for \a gshell_resultReport .
+ *
+ * @param value		Filled in with the posted value, 0 if none
+ * @return			Non-zero if the command called \a gshell_setResult
+ */
+uint8_t gshell_resultPosted(uint32_t *value);
+
+/**
+ * @brief Queue the completion record of a command run by a worker
+ *
+ * Call on the input thread once the command executed by \a gshell_runCmd has
+ * returned. Nothing is queued if neither a value was returned nor posted.
+ *
+ * @param cmdID		ID of the command, as passed over to the dispatcher
+ * @param status	Return value of the command
+ * @param value		Value returned by \a gshell_resultPosted
+ * @param posted	Return value of \a gshell_resultPosted
+ */
+void gshell_resultReport(int16_t cmdID, uint8_t status, uint32_t value, uint8_t posted);
+#endif
+#endif
+
+#ifdef G_ENABLE_RXRING
+/**
+ * @brief Store a received character
+ *
+ * Lock-free for a single producer (the receive interrupt) and a single consumer
+ * (\a gshell_poll ). The character is dropped and counted if the ring is full.
+ *
+ * @param c		Received character
+ * @return		1 if stored, 0 on overrun
+ */
+uint8_t gshell_rxPush(char c);
+
+/**
+ * @brief Store a block of received characters
+ *
+ * Same as \a gshell_rxPush , but publishes all of them at once (for example
+ * from a DMA half / full transfer interrupt).
+ *
+ * @param data		Received characters
+ * @param length	Amount of received characters
+ * @return			Amount of characters stored, the rest is counted as overrun
+ */
+uint16_t gshell_rxPushBlock(const char *data, uint16_t length);
+
+/**
+ * @brief Returns the amount of characters dropped due to a full receive ring
+ */
+uint16_t gshell_rxOverruns(void);
+
+/**
+ * @brief Set the high-watermark callback of the receive ring
+ *
+ * The callback is called by \a gshell_rxPush / \a gshell_rxPushBlock (thus within
+ * the interrupt) when the fill level reaches \a level , for example to
+ * signal flow control to the sender.
+ *
+ * @param level		Fill level in bytes, 1 to G_RXRING_SIZE
+ * @param callback	Function receiving the fill level, NULL to disable
+ */
+void gshell_rxSetWatermark(uint16_t level, void (*callback)(uint16_t fill));
+#endif
+
+/**
+ * @brief Prints a single character
+ *
+ * Prints a single character, passes the character directly
+ * to the driver function passed over during initialisation.
+ * If the terminal isn't set 'active', nothing will be printed.
+ *
+ * @param c		8-bit Character to send
+ */
+void gshell_putChar(char c);
+
+/**
+ * @brief Sends a (S)RAM string
+ *
+ * Sends a string stored in volatile RAM/Memory.
+ * If the terminal isn't set 'active', nothing will be printed.
+ *
+ * @param str	Pointer to array of characters, NULL-Character at the end
+ */
+void gshell_putStringRAM(const char *str);
+
+/**
+ * @brief Sends a flash string
+ *
+ * Sends a string stored in non-volatile flash memory. Use the macro
+ * \a gshell_putString to automatically mark the text within there as
+ * progmem. Otherwise use the \a G_XSTR macro.
+ * If the terminal isn't set 'active', nothing will be printed.
+ *
+ * @param progmem_s	Pointer to the program memory holding the flash string
+ */
+void gshell_putString_flash(const _GMEMX char *progmem_s);
+
+/**
+ * @brief Makro for \a gshell_putString_flash
+ * 
+ * Stores the text automatically via a macro in flash memory for
+ * the \a gshell_putString_flash function.
+ * 
+ * @param __f 	Text to send, automatically saved in flash
+ */
+#define gshell_putString(__f)	gshell_putString_flash(G_XSTR(__f))
+
+/**
+ * @brief Printf-functionality from program memory
+ *
+ * Basic (vs)printf functionality, where the main string is
+ * stored in flash memory instead of RAM. Requires the string to be
+ * put in the program memory if the macro \a gshell_printf isn't used.
+ * If the terminal isn't set 'active', nothing will be printed.
+ *
+ * @param progmem_s	Pointer to the program memory holding the flash string
+ * @param ...		Additional, optional printf-style arguments
+ */
+void gshell_printf_flash(const _GMEMX char *progmem_s, ...);
+
+/**
+ * @brief Printf-functionality & auto-flash string saving
+ * 
+ * Similar as \a gshell_printf_f but stores the text automatically
+ * in the program memory.
+ * 
+ * @param __f		printf-formatting text to process
+ * @param ...		Additional, optional printf-style arguments
+ */
+#define gshell_printf(__f, ...)	gshell_printf_flash(G_XSTR(__f),__VA_ARGS__);
+
+/**
+ * @brief Prints a unsigned decimal number
+ *
+ * Table driven, without going through vsprintf like \a gshell_printf .
+ *
+ * @param value		Number to print
+ */
+void gshell_putU32(uint32_t value);
+
+/**
+ * @brief Prints a signed decimal number
+ *
+ * @param value		Number to print
+ */
+void gshell_putI32(int32_t value);
+
+/**
+ * @brief Prints a number as upper case hex digits, without prefix
+ *
+ * @param value		Number to print
+ * @param width		Amount of digits (zero padded) from 1 to 8, 0 for as many as required
+ */
+void gshell_putHex(uint32_t value, uint8_t width);
+
+/**
+ * @brief Prints a memory buffer as hexdump
+ *
+ * Prints 16 bytes per line, preceded by their address and followed by their
+ * ASCII representation. Each line is formatted as a whole before printing.
+ *
+ * @param data		Buffer to print
+ * @param length	Amount of bytes to print
+ * @param base		Address shown for the first byte
+ */
+void gshell_hexdump(const void *data, uint16_t length, uint32_t base);
+
+/**
+ * @brief Logging functionality
+ *
+ * Basic logging function that prints out the text together with the logging level
+ * and optionally a milliseconds timestamp. Uses vsprintf, so additonal arguments and
+ * variables can be printed similar like printf. Expects a const string pointer (to
+ * flash memory).
+ *
+ * @param loglvl	glog_level logging level
+ * @param logText	Program-memory-pointer to the logging text & printf-formatting 
+ * @param ...		Additional, optional printf-style arguments
+ */
+void gshell_log_flash(enum glog_level loglvl, const _GMEMX char *logText, ...);
+
+#ifdef G_ENABLE_TIMESTAMP64
+/**
+ * @brief Timestamp modes of the log messages
+ */
+enum gshell_tsmode {
+	GSHELL_TS_ABSOLUTE	= 0,	/**< Time since the time source started, "[    12.345678] " */
+	GSHELL_TS_DELTA		= 1		/**< Time since the previous log message, "[+    0.000123] " */
+};
+
+/**
+ * @brief Set the high-resolution time source of the log messages
+ *
+ * Replaces the millisecond tick in the log prefix of the terminal. The records
+ * passed over to sinks, the history and 'watch' keep using the millisecond tick.
+ *
+ * @param get_ticks			Function pointer returning the current tick (microseconds,
+ *							a cycle counter, ...), NULL to print the millisecond tick again
+ * @param ticksPerSecond	Frequency of the tick, 1000000 for microseconds
+ */
+void gshell_setTimeSource(uint64_t (*get_ticks)(void), uint32_t ticksPerSecond);
+
+/**
+ * @brief Set the timestamp mode of the log messages
+ *
+ * @param mode	enum \a gshell_tsmode , \a GSHELL_TS_ABSOLUTE by default
+ */
+void gshell_setTimestampMode(enum gshell_tsmode mode);
+#endif
+
+#ifdef G_ENABLE_LOGFORMAT
+/**
+ * @brief Logging functionality with source location
+ *
+ * Same as \a gshell_log_flash , but the record carries the source file and line.
+ * Formatted text shows them as "[file:line]" in front of the message.
+ *
+ * @param loglvl	glog_level logging level
+ * @param file		Program-memory-pointer to the source file name
+ * @param line		Source line
+ * @param logText	Program-memory-pointer to the logging text & printf-formatting
+ * @param ...		Additional, optional printf-style arguments
+ */
+void gshell_logSrc_flash(enum glog_level loglvl, const _GMEMX char *file, uint16_t line, const _GMEMX char *logText, ...);
+
+/**
+ * @brief Set the log output format of the terminal
+ *
+ * Structured records bypass the escape filter of the terminal profile. JSON lines
+ * clear the prompt before and reprint it after the record, CBOR records are sent
+ * without any prompt handling. Use them on a terminal (or session) read by a program.
+ *
+ * @param format	enum \a gshell_logformat to use, \a GSHELL_LOGFMT_TEXT by default
+ */
+void gshell_setLogFormat(enum gshell_logformat format);
+
+/**
+ * @brief Returns the log output format of the terminal
+ */
+enum gshell_logformat gshell_getLogFormat(void);
+
+/**
+ * @brief Encode a log record
+ *
+ * Encodes the record as JSON line (with line ending) or CBOR map, for example
+ * within a log sink. Works like snprintf: at most \a size bytes are written
+ * (no NULL-terminator), the full length is returned.
+ *
+ * @param format	\a GSHELL_LOGFMT_JSON or \a GSHELL_LOGFMT_CBOR
+ * @param record	Record to encode
+ * @param buf		Output buffer
+ * @param size		Size of the output buffer
+ * @return			Length of the encoded record, larger than size if it didn't fit
+ */
+uint16_t gshell_logEncode(enum gshell_logformat format, const gshell_logrec_t *record, uint8_t *buf, uint16_t size);
+#endif
+
+#ifdef G_ENABLE_LOGSINKS
+/**
+ * @brief Add a log sink
+ *
+ * The sink receives the log records after formatting, also while the terminal
+ * is inactive (see \a gshell_setActive ). The structure is used as-is and has to
+ * stay valid until it is removed again.
+ *
+ * @param sink	Sink to add, \a bufFill , \a dropped and \a next are reset
+ * @return		0 on success, -1 if the sink is already registered
+ */
+int8_t gshell_addSink(gshell_sink_t *sink);
+
+/**
+ * @brief Remove a log sink, without flushing it
+ *
+ * @param sink	Sink to remove
+ */
+void gshell_removeSink(gshell_sink_t *sink);
+
+/**
+ * @brief Flush all buffered log sinks
+ *
+ * Passes the buffered text of every sink over to its flush function. Call it
+ * regularly from the main loop for sinks with \a GSINK_FLUSH_MANUAL .
+ */
+void gshell_flushSinks(void);
+
+/**
+ * @brief Set the lowest logging level printed on the terminal
+ *
+ * The log sinks have their own filter, see \a gshell_sink_t
+ *
+ * @param minLevel	Lowest enum \a glog_level printed, GLOG_NORMAL (default) prints all
+ */
+void gshell_setLogLevel(enum glog_level minLevel);
+#endif
+
+#ifdef G_ENABLE_LOGSITES
+/**
+ * @brief Log call site, placed into the 'gshell_logsites' section by the glog macros
+ */
+typedef struct gshell_logsite {
+	const _GMEMX char *file;		/**< Source file */
+	const _GMEMX char *format;		/**< Logging text & printf-formatting */
+	uint16_t line;					/**< Source line */
+	uint8_t level;					/**< enum glog_level */
+	uint8_t enabled;				/**< Non-zero if the log line is printed */
+} gshell_logsite_t;
+
+/**
+ * @brief Switch log call sites on or off
+ *
+ * @param file		End of the source file path ("uart.c", "drivers/uart.c"), "*" for all files
+ * @param line		Source line, 0 for all lines of the file
+ * @param enable	Non-zero to enable, zero to disable
+ * @return			Amount of matching call sites
+ */
+uint16_t gshell_logsiteSet(const char *file, uint16_t line, uint8_t enable);
+
+/* Source file of a call site. A plain literal is merged with the other sites of the
+ * file, AVR needs its own copy in program memory per site */
+#ifdef AVR
+	#define _GSITE_FILEDECL		static const _GMEMX char __gsFile[] _PRGMX = __FILE__;
+	#define _GSITE_FILE			__gsFile
+#else
+	#define _GSITE_FILEDECL
+	#define _GSITE_FILE			__FILE__
+#endif
+
+/* Registers the call site and makes the call only if it is enabled */
+#define _glog_site(__call,__l,__f)	do {											\
+		_GSITE_FILEDECL																\
+		static const _GMEMX char __gsFmt[] _PRGMX = __f;							\
+		static gshell_logsite_t __gsSite											\
+			__attribute__((section("gshell_logsites"), used, aligned(__alignof__(gshell_logsite_t)))) = \
+			{_GSITE_FILE, __gsFmt, __LINE__, __l, 1};								\
+		if (__gsSite.enabled)	__call;												\
+	} while (0)
+#define _glog(__l,__f,...)		_glog_site(gshell_log_flash(__l,__gsFmt, ##__VA_ARGS__),__l,__f)
+#define _glog_src(__l,__f,...)	_glog_site(gshell_logSrc_flash(__l,_GSITE_FILE,__LINE__,__gsFmt, ##__VA_ARGS__),__l,__f)
+#else
+#define _glog(__l,__f,...)		gshell_log_flash(__l,G_XSTR(__f), ##__VA_ARGS__)
+#define _glog_src(__l,__f,...)	gshell_logSrc_flash(__l,G_XSTR(__FILE__),__LINE__,G_XSTR(__f), ##__VA_ARGS__)
+#endif
+
+/**
+ * @brief Logging macro
+ * 
+ * Basically \a gshell_log_flash but with a macro to store the (printf) text
+ * in the flash memory & passing the flash memory pointer to the function 
+ * \a gshell_log_flash.
+ * 
+ * @param __l		enum \a glog_level logging level
+ * @param logText	Logging text & printf-formatting 
+ * @param ...		Additional, optional printf-style arguments
+ */
+#define glog(__l,__f,...)		_glog(__l,__f, ##__VA_ARGS__)
+
+/**
+ * @brief Logging macro level NORMAL
+ * 
+ * Basically \a gshell_log_flash but with a macro to store the (printf) text
+ * in the flash memory & passing the flash memory pointer to the function 
+ * \a gshell_log_flash.
+ * 
+ * @param logText	Logging text & printf-formatting 
+ * @param ...		Additional, optional printf-style arguments
+ */
+#define glog_norm(__f,...)		_glog(GLOG_NORMAL,__f, ##__VA_ARGS__)
+
+/**
+ * @brief Logging macro level INFO
+ * 
+ * Basically \a gshell_log_flash but with a macro to store the (printf) text
+ * in the flash memory & passing the flash memory pointer to the function 
+ * \a gshell_log_flash.
+ * 
+ * @param logText	Logging text & printf-formatting 
+ * @param ...		Additional, optional printf-style arguments
+ */
+#define glog_info(__f,...)		_glog(GLOG_INFO,__f, ##__VA_ARGS__)
+
+/**
+ * @brief Logging macro level OK
+ * 
+ * Basically \a gshell_log_flash but with a macro to store the (printf) text
+ * in the flash memory & passing the flash memory pointer to the function 
+ * \a gshell_log_flash.
+ * 
+ * @param logText	Logging text & printf-formatting 
+ * @param ...		Additional, optional printf-style arguments
+ */
+#define glog_ok(__f,...)		_glog(GLOG_OK,__f, ##__VA_ARGS__)
+
+/**
+ * @brief Logging macro level WARNING
+ * 
+ * Basically \a gshell_log_flash but with a macro to store the (printf) text
+ * in the flash memory & passing the flash memory pointer to the function 
+ * \a gshell_log_flash.
+ * 
+ * @param logText	Logging text & printf-formatting 
+ * @param ...		Additional, optional printf-style arguments
+ */
+#define glog_warn(__f,...)		_glog(GLOG_WARN,__f, ##__VA_ARGS__)
+
+/**
+ * @brief Logging macro level ERROR
+ * 
+ * Basically \a gshell_log_flash but with a macro to store the (printf) text
+ * in the flash memory & passing the flash memory pointer to the function 
+ * \a gshell_log_flash.
+ * 
+ * @param logText	Logging text & printf-formatting 
+ * @param ...		Additional, optional printf-style arguments
+ */
+#define glog_error(__f,...)		_glog(GLOG_ERROR,__f, ##__VA_ARGS__)
+
+/**
+ * @brief Logging macro level FATAL
+ * 
+ * Basically \a gshell_log_flash but with a macro to store the (printf) text
+ * in the flash memory & passing the flash memory pointer to the function 
+ * \a gshell_log_flash.
+ * 
+ * @param logText	Logging text & printf-formatting 
+ * @param ...		Additional, optional printf-style arguments
+ */
+#define glog_fatal(__f,...)		_glog(GLOG_FATAL,__f, ##__VA_ARGS__)
+
+/**
+ * @brief Logging file/function/line
+ *
+ * Prints the exact file, function and line via the logging function.
+ * The text is automatically stored in flash / program memory.
+ * Expects a logging level as argument.
+ *
+ * @param __l		enum \a glog_level logging level
+ */
+#ifdef G_ENABLE_LOGFORMAT
+#define glog_ffl(__l)			\
+	_glog_src(__l, "In function [%s]", __FUNCTION__)
+#else
+#define glog_ffl(__l)			\
+	_glog(__l, "In [" __FILE__ "], function [%s] line [%d]", __FUNCTION__, __LINE__)
+#endif
+
+#ifdef G_ENABLE_LOGFORMAT
+/**
+ * @brief Logging macro with source file and line
+ *
+ * Same as \a glog , but the record also carries __FILE__ and __LINE__,
+ * see \a gshell_logSrc_flash
+ *
+ * @param __l		enum \a glog_level logging level
+ * @param logText	Logging text & printf-formatting
+ * @param ...		Additional, optional printf-style arguments
+ */
+#define glog_src(__l,__f,...)	_glog_src(__l,__f, ##__VA_ARGS__)
+#endif
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GSHELL_H_
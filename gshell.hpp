@@ -0,0 +1,368 @@
+/**
+ * @file gshell.hpp
+ * @brief C++ wrapper of the gshell library
+ *
+ * Wraps the C core into a \a gshell::Shell class. The command names and
+ * descriptions are collected in a constexpr \a gshell::CommandTable, which is
+ * sorted by name hash at compile time. Handlers are callables (lambdas with
+ * captures included) that are stored inline within the shell object without
+ * any heap allocation, and receive their arguments as a span of string_views.
+ * The argument lengths are taken over from the tokenizer of the C core.
+ *
+ * Requires C++20 and \a G_ENABLE_CMDCONTEXT to be enabled in gshell.h.
+ *
+ * Usage:
+ *
+ * static constexpr auto commands = gshell::makeCommandTable(
+ *	gshell::CommandDef("led",	"Switch the LED on or off"),
+ *	gshell::CommandDef("reg",	"Read a register")
+ * );
+ * static gshell::Shell<commands.size()> shell(commands);
+ *
+ * shell.bind(commands.find("led"), [&board](gshell::Args args) -> uint8_t {
+ *	board.setLed(args.size() > 1 && args[1] == "on");
+ *	return 0;
+ * });
+ * gshell_init(&uart_putchar, &millis);
+ * shell.begin();
+ *
+ * \author gfcwfzkm
+ * \copyright GNU Lesser General Public License v2.1
+ */
+#ifndef GSHELL_HPP_
+#define GSHELL_HPP_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "gshell.h"
+
+#if __cplusplus < 202002L
+	#error "gshell.hpp requires C++20 (std::span)"
+#endif
+
+#ifndef G_ENABLE_CMDCONTEXT
+	#error "gshell.hpp requires G_ENABLE_CMDCONTEXT to be enabled in gshell.h"
+#endif
+
+/**
+ * @brief Inline storage size of a command handler in bytes
+ *
+ * Callables with a larger capture list are rejected at compile time.
+ */
+#ifndef GSHELL_HANDLER_STORAGE
+	#define GSHELL_HANDLER_STORAGE	(4 * sizeof(void *))
+#endif
+
+namespace gshell {
+
+/**
+ * @brief Arguments passed to a command handler, the command name being the first one
+ */
+using Args = std::span<const std::string_view>;
+
+/**
+ * @brief FNV-1a hash of a command name, usable at compile time
+ */
+constexpr uint32_t hash(std::string_view str) noexcept
+{
+	uint32_t u32Hash = 2166136261u;
+	for (char c : str)
+	{
+		u32Hash ^= static_cast<uint8_t>(c);
+		u32Hash *= 16777619u;
+	}
+	return u32Hash;
+}
+
+/**
+ * @brief Fixed-size callable storage without heap allocation
+ *
+ * Similar to std::function, but the callable is always placed into the
+ * inline buffer of \a Capacity bytes. Not copyable, as the C core keeps
+ * pointers to it.
+ */
+template <typename Signature, std::size_t Capacity = GSHELL_HANDLER_STORAGE>
+class InlineFunction;
+
+template <typename R, typename... A, std::size_t Capacity>
+class InlineFunction<R(A...), Capacity>
+{
+public:
+	InlineFunction() noexcept = default;
+	InlineFunction(const InlineFunction &) = delete;
+	InlineFunction &operator=(const InlineFunction &) = delete;
+	~InlineFunction() { reset(); }
+
+	/**
+	 * @brief Stores a callable, replacing the previous one
+	 */
+	template <typename F>
+	void emplace(F &&fn)
+	{
+		using Fn = std::decay_t<F>;
+		static_assert(sizeof(Fn) <= Capacity, "Callable too large, increase GSHELL_HANDLER_STORAGE");
+		static_assert(alignof(Fn) <= alignof(std::max_align_t), "Callable over-aligned for the inline storage");
+		static_assert(std::is_invocable_r_v<R, Fn &, A...>, "Callable has the wrong signature");
+
+		reset();
+		::new (static_cast<void *>(storage)) Fn(std::forward<F>(fn));
+		invoker = [](void *obj, A... args) -> R {
+			return (*static_cast<Fn *>(obj))(std::forward<A>(args)...);
+		};
+		destroyer = [](void *obj) {
+			static_cast<Fn *>(obj)->~Fn();
+		};
+	}
+
+	/**
+	 * @brief Destroys the stored callable, if any
+	 */
+	void reset() noexcept
+	{
+		if (destroyer != nullptr)
+		{
+			destroyer(storage);
+		}
+		invoker = nullptr;
+		destroyer = nullptr;
+	}
+
+	explicit operator bool() const noexcept { return invoker != nullptr; }
+
+	R operator()(A... args) { return invoker(storage, std::forward<A>(args)...); }
+
+private:
+	alignas(std::max_align_t) unsigned char storage[Capacity];
+	R (*invoker)(void *, A...) = nullptr;
+	void (*destroyer)(void *) = nullptr;
+};
+
+/**
+ * @brief Command handler type, returns the value reported by \a gshell_processShell
+ */
+using Handler = InlineFunction<uint8_t(Args)>;
+
+/**
+ * @brief Name and description of a command, hashed at compile time
+ */
+struct CommandDef
+{
+	const char *name;		/**< NUL-terminated command name, passed on to the C core */
+	const char *desc;		/**< NUL-terminated description for the help command */
+	std::size_t nameLength;	/**< Length of the name without terminator */
+	uint32_t nameHash;		/**< \a gshell::hash of the name */
+
+	template <std::size_t N, std::size_t M>
+	constexpr CommandDef(const char (&cmdName)[N], const char (&cmdDesc)[M]) noexcept
+		: name(cmdName), desc(cmdDesc), nameLength(N - 1), nameHash(hash(std::string_view(cmdName, N - 1)))
+	{}
+
+	constexpr std::string_view nameView() const noexcept { return std::string_view(name, nameLength); }
+};
+
+namespace detail {
+	// Not constexpr on purpose: reaching it during constant evaluation fails the build
+	inline void duplicate_command_name() noexcept {}
+
+	constexpr bool lessThan(const CommandDef &a, const CommandDef &b) noexcept
+	{
+		return (a.nameHash != b.nameHash) ? (a.nameHash < b.nameHash) : (a.nameView() < b.nameView());
+	}
+}
+
+/**
+ * @brief Command table, sorted by the hash of the command names
+ *
+ * Build it with \a gshell::makeCommandTable as a constexpr variable. Duplicate
+ * command names are reported at compile time, and \a find can be used in constant
+ * expressions to get the index of a command.
+ */
+template <std::size_t N>
+class CommandTable
+{
+public:
+	/** Returned by \a find if no command matches */
+	static constexpr std::size_t npos = N;
+
+	constexpr explicit CommandTable(const std::array<CommandDef, N> &defs) noexcept : entries(defs)
+	{
+		std::sort(entries.begin(), entries.end(), detail::lessThan);
+		for (std::size_t i = 1; i < N; i++)
+		{
+			if (entries[i - 1].nameView() == entries[i].nameView())
+			{
+				detail::duplicate_command_name();
+			}
+		}
+	}
+
+	/**
+	 * @brief Binary search for a command by its name
+	 *
+	 * @param name	Name of the command
+	 * @return		Index of the command, \a npos if not found
+	 */
+	constexpr std::size_t find(std::string_view name) const noexcept
+	{
+		const uint32_t u32Hash = hash(name);
+		std::size_t lo = 0;
+		std::size_t hi = N;
+
+		while (lo < hi)
+		{
+			std::size_t mid = lo + (hi - lo) / 2;
+			if (entries[mid].nameHash < u32Hash)
+			{
+				lo = mid + 1;
+			}
+			else
+			{
+				hi = mid;
+			}
+		}
+		// Several names could share the same hash, compare each of them
+		for (; (lo < N) && (entries[lo].nameHash == u32Hash); lo++)
+		{
+			if (entries[lo].nameView() == name)
+			{
+				return lo;
+			}
+		}
+		return npos;
+	}
+
+	constexpr std::size_t size() const noexcept { return N; }
+	constexpr const CommandDef &operator[](std::size_t index) const noexcept { return entries[index]; }
+
+private:
+	std::array<CommandDef, N> entries;
+};
+
+/**
+ * @brief Creates a sorted \a gshell::CommandTable from command definitions
+ */
+template <typename... Defs>
+constexpr auto makeCommandTable(const Defs &...defs) noexcept
+{
+	return CommandTable<sizeof...(Defs)>(std::array<CommandDef, sizeof...(Defs)>{ defs... });
+}
+
+/**
+ * @brief Shell object forwarding to the C core
+ *
+ * Holds the \a gshell_cmd_t structures and the inline handlers of a command
+ * table. The C core keeps pointers into this object, so it can neither be
+ * copied nor moved and must outlive the shell (a static instance is best).
+ */
+template <std::size_t N>
+class Shell
+{
+public:
+	constexpr explicit Shell(const CommandTable<N> &cmdTable) noexcept : table(cmdTable) {}
+	Shell(const Shell &) = delete;
+	Shell &operator=(const Shell &) = delete;
+
+	/**
+	 * @brief Binds a callable to a command
+	 *
+	 * @param index	Index from \a CommandTable::find
+	 * @param fn	Callable taking \a gshell::Args and returning uint8_t
+	 * @return		False if the index is invalid
+	 */
+	template <typename F>
+	bool bind(std::size_t index, F &&fn)
+	{
+		if (index >= N)
+		{
+			return false;
+		}
+		handlers[index].emplace(std::forward<F>(fn));
+		return true;
+	}
+
+	/**
+	 * @brief Binds a callable to a command, looked up by name
+	 */
+	template <typename F>
+	bool bind(std::string_view name, F &&fn)
+	{
+		return bind(table.find(name), std::forward<F>(fn));
+	}
+
+	/**
+	 * @brief Registers all commands of the table at the C core
+	 *
+	 * Call after \a gshell_init . The commands are registered in the order
+	 * of the table, so the command IDs follow the table index.
+	 *
+	 * @return	ID of the first command, negative if a command couldn't be added
+	 */
+	int16_t begin() noexcept
+	{
+		int16_t i16FirstID = -1;
+
+		for (std::size_t i = 0; i < N; i++)
+		{
+			cmds[i] = gshell_cmd_t{};
+			cmds[i].cmdName = table[i].name;
+			cmds[i].desc = table[i].desc;
+			cmds[i].handlerCtx = &Shell::dispatch;
+			cmds[i].ctx = &handlers[i];
+
+			int16_t i16ID = gshell_register_cmd(&cmds[i]);
+			if (i16ID < 0)
+			{
+				return i16ID;
+			}
+			if (i == 0)
+			{
+				i16FirstID = i16ID;
+			}
+		}
+		return i16FirstID;
+	}
+
+	/**
+	 * @brief Returns the C core command ID of a table entry, -1 if not registered
+	 */
+	int16_t id(std::size_t index) noexcept
+	{
+		return (index < N) ? gshell_getCmdIDbyStruct(&cmds[index]) : -1;
+	}
+
+	const CommandTable<N> &commands() const noexcept { return table; }
+
+private:
+	// Called by the C core, turns argv/argl into string_views for the handler
+	static uint8_t dispatch(void *ctx, uint8_t argc, char *argv[], const uint8_t argl[])
+	{
+		Handler &handler = *static_cast<Handler *>(ctx);
+		std::array<std::string_view, G_MAX_ARGS> views;
+
+		if (!handler)
+		{
+			return 0;
+		}
+		for (uint8_t i = 0; i < argc; i++)
+		{
+			views[i] = std::string_view(argv[i], argl[i]);
+		}
+		return handler(Args(views.data(), argc));
+	}
+
+	CommandTable<N> table;
+	std::array<gshell_cmd_t, N> cmds{};
+	std::array<Handler, N> handlers;
+};
+
+} // namespace gshell
+
+#endif // GSHELL_HPP_
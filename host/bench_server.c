@@ -0,0 +1,249 @@
+/**
+ * @brief Load benchmark of the gshell socket server
+ *
+ * Runs a gserver in a second thread and connects hundreds of loopback clients
+ * to it. Every client sends a command, waits for the prompt to come back and
+ * sends the next one (closed loop). Reports the commands per second and the
+ * latency percentiles of the command round trips.
+ *
+ * Build: gcc -O2 -DG_ENABLE_SESSIONS -pthread -o bench_server host/bench_server.c host/gshell_server.c gshell.c
+ * Usage: bench_server [-c clients] [-n commands per client] [-u]
+ *        -u uses a Unix socket instead of TCP
+ */
+
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "gshell_server.h"
+
+#define BENCH_CMD		"ping a b c\n"
+#define BENCH_PROMPT	"gshell> "
+
+typedef struct client {
+	int fd;
+	uint8_t matched;		/**< Characters of BENCH_PROMPT matched so far */
+	uint8_t started;		/**< Initial prompt received */
+	uint32_t remaining;		/**< Commands left to send */
+	uint64_t sentAt;		/**< Send time of the pending command in ns */
+} client_t;
+
+static gserver_t sServer;
+static volatile int iStop = 0;
+
+static void discard_putchar(char c)
+{
+	(void)(c);
+}
+
+static uint8_t cmd_ping(uint8_t argc, char *argv[])
+{
+	(void)(argc);
+	(void)(argv);
+	gshell_putString("pong" G_CRLF);
+	return 0;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec sTime;
+
+	clock_gettime(CLOCK_MONOTONIC, &sTime);
+	return (uint64_t)sTime.tv_sec * 1000000000ull + (uint64_t)sTime.tv_nsec;
+}
+
+static void *server_thread(void *arg)
+{
+	(void)(arg);
+	while (!__atomic_load_n(&iStop, __ATOMIC_ACQUIRE))
+	{
+		gserver_run(&sServer, 10);
+	}
+	return NULL;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+	uint64_t u64A = *(const uint64_t *)a;
+	uint64_t u64B = *(const uint64_t *)b;
+	return (u64A > u64B) - (u64A < u64B);
+}
+
+static int send_cmd(client_t *psClient)
+{
+	psClient->sentAt = now_ns();
+	return (send(psClient->fd, BENCH_CMD, sizeof(BENCH_CMD) - 1, MSG_NOSIGNAL) == (ssize_t)(sizeof(BENCH_CMD) - 1)) ? 0 : -1;
+}
+
+int main(int argc, char *argv[])
+{
+	static gshell_cmd_t sPingCmd = {"ping", cmd_ping, "Replies with pong", NULL};
+	const char *pcUnixPath = "/tmp/gshell_bench.sock";
+	struct sockaddr_storage sAddr;
+	socklen_t addrLen = sizeof(sAddr);
+	struct epoll_event sEvents[256];
+	struct epoll_event sEvent;
+	pthread_t sThread;
+	client_t *psClients;
+	uint64_t *pu64Lat;
+	uint64_t u64Start, u64Total;
+	uint32_t u32Clients = 200;
+	uint32_t u32Cmds = 100;
+	uint32_t u32Done = 0;
+	uint32_t u32LatCount = 0;
+	uint8_t bUnix = 0;
+	char cBuf[4096];
+	ssize_t iLength;
+	int iOpt, iCount, i, j, epfd;
+
+	while ((iOpt = getopt(argc, argv, "c:n:u")) != -1)
+	{
+		switch (iOpt)
+		{
+			case 'c':	u32Clients = (uint32_t)strtoul(optarg, NULL, 0);	break;
+			case 'n':	u32Cmds = (uint32_t)strtoul(optarg, NULL, 0);		break;
+			case 'u':	bUnix = 1;											break;
+			default:
+				fprintf(stderr, "Usage: %s [-c clients] [-n commands per client] [-u]\n", argv[0]);
+				return 2;
+		}
+	}
+	if ((u32Clients == 0) || (u32Cmds == 0))
+	{
+		return 2;
+	}
+
+	gshell_init(&discard_putchar, NULL);
+	gshell_register_cmd(&sPingCmd);
+	if (gserver_init(&sServer) < 0)
+	{
+		perror("gserver_init");
+		return 1;
+	}
+	if ((bUnix ? gserver_listenUnix(&sServer, pcUnixPath) : gserver_listenTcp(&sServer, "127.0.0.1", 0)) < 0)
+	{
+		perror("listen");
+		return 1;
+	}
+	getsockname(sServer.listenFd[0], (struct sockaddr *)&sAddr, &addrLen);
+	pthread_create(&sThread, NULL, server_thread, NULL);
+
+	psClients = calloc(u32Clients, sizeof(client_t));
+	pu64Lat = calloc((size_t)u32Clients * u32Cmds, sizeof(uint64_t));
+	epfd = epoll_create1(EPOLL_CLOEXEC);
+	if ((psClients == NULL) || (pu64Lat == NULL) || (epfd < 0))
+	{
+		return 1;
+	}
+
+	// Connect all clients first, the commands start once each got its prompt
+	for (i = 0; i < (int)u32Clients; i++)
+	{
+		psClients[i].fd = socket(bUnix ? AF_UNIX : AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if ((psClients[i].fd < 0) || (connect(psClients[i].fd, (struct sockaddr *)&sAddr, addrLen) < 0))
+		{
+			perror("connect");
+			return 1;
+		}
+		if (!bUnix)
+		{
+			iOpt = 1;
+			setsockopt(psClients[i].fd, IPPROTO_TCP, TCP_NODELAY, &iOpt, sizeof(iOpt));
+		}
+		psClients[i].remaining = u32Cmds;
+		sEvent.events = EPOLLIN;
+		sEvent.data.ptr = &psClients[i];
+		epoll_ctl(epfd, EPOLL_CTL_ADD, psClients[i].fd, &sEvent);
+	}
+
+	u64Start = now_ns();
+	while (u32Done < u32Clients)
+	{
+		iCount = epoll_wait(epfd, sEvents, 256, 5000);
+		if (iCount <= 0)
+		{
+			fprintf(stderr, "Timeout / error waiting for replies (%u of %u clients done)\n", u32Done, u32Clients);
+			return 1;
+		}
+		for (i = 0; i < iCount; i++)
+		{
+			client_t *psClient = (client_t *)sEvents[i].data.ptr;
+
+			iLength = recv(psClient->fd, cBuf, sizeof(cBuf), 0);
+			if (iLength <= 0)
+			{
+				fprintf(stderr, "Connection lost\n");
+				return 1;
+			}
+			// Look for the prompt, it follows the output of every command
+			for (j = 0; j < iLength; j++)
+			{
+				if (cBuf[j] == BENCH_PROMPT[psClient->matched])
+				{
+					psClient->matched++;
+				}
+				else
+				{
+					psClient->matched = (cBuf[j] == BENCH_PROMPT[0]) ? 1 : 0;
+				}
+				if (psClient->matched < sizeof(BENCH_PROMPT) - 1)
+				{
+					continue;
+				}
+				psClient->matched = 0;
+
+				if (psClient->started)
+				{
+					pu64Lat[u32LatCount++] = now_ns() - psClient->sentAt;
+					psClient->remaining--;
+				}
+				psClient->started = 1;
+				if (psClient->remaining == 0)
+				{
+					epoll_ctl(epfd, EPOLL_CTL_DEL, psClient->fd, NULL);
+					u32Done++;
+				}
+				else if (send_cmd(psClient) < 0)
+				{
+					perror("send");
+					return 1;
+				}
+			}
+		}
+	}
+	u64Total = now_ns() - u64Start;
+
+	__atomic_store_n(&iStop, 1, __ATOMIC_RELEASE);
+	pthread_join(sThread, NULL);
+	for (i = 0; i < (int)u32Clients; i++)
+	{
+		close(psClients[i].fd);
+	}
+	gserver_close(&sServer);
+
+	qsort(pu64Lat, u32LatCount, sizeof(uint64_t), cmp_u64);
+	printf("%s, %u clients, %u commands in %.3f s\n", bUnix ? "Unix socket" : "TCP loopback",
+		   u32Clients, u32LatCount, (double)u64Total / 1e9);
+	printf("Throughput: %.0f commands/s\n", (double)u32LatCount * 1e9 / (double)u64Total);
+	printf("Latency:    p50 %.1f us, p99 %.1f us, max %.1f us\n",
+		   (double)pu64Lat[u32LatCount / 2] / 1e3,
+		   (double)pu64Lat[(uint32_t)((uint64_t)u32LatCount * 99 / 100)] / 1e3,
+		   (double)pu64Lat[u32LatCount - 1] / 1e3);
+
+	free(pu64Lat);
+	free(psClients);
+	close(epfd);
+	return 0;
+}
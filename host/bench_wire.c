@@ -0,0 +1,288 @@
+/**
+ * @brief Wire-cost benchmark of the gshell output path
+ *
+ * Runs scripted operations (log messages with and without prompt, key strokes,
+ * commands, hexdumps) against a output function that only counts the bytes.
+ * Reports the bytes per operation, how many of them belong to escape sequences
+ * and how long they take on a serial link of the given baudrate - on slow links
+ * the bytes on the wire are the limit, not the CPU. Use -c and diff the output
+ * to judge a change of the output path against a baseline.
+ *
+ * Build: gcc -O2 -o bench_wire host/bench_wire.c gshell.c
+ * Usage: bench_wire [-b baudrate] [-f bits per character] [-n iterations] [-c]
+ *                   [-t ansi|minimal|plain]
+ *        -c prints CSV, -t requires G_ENABLE_TERMPROFILES
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../gshell.h"
+
+#define BENCH_TYPED		"led set 1 on"	/* Half typed command line, replayed after log messages */
+
+typedef struct scenario {
+	const char *name;
+	const char *typed;		/**< Input typed before the operation, NULL for none */
+	uint8_t prompt;			/**< Prompt enabled during the operation */
+	void (*run)(void);		/**< The operation itself */
+} scenario_t;
+
+/* Counting output function */
+static struct {
+	uint64_t bytes;			/**< Bytes sent */
+	uint64_t escBytes;		/**< Bytes belonging to escape sequences */
+	uint8_t escState;		/**< 0 outside, 1 after ESC, 2 within a CSI sequence */
+} sWire;
+
+static void wire_putchar(char c)
+{
+	sWire.bytes++;
+	switch (sWire.escState)
+	{
+		case 0:
+			if (c == '\x1b')
+			{
+				sWire.escState = 1;
+				sWire.escBytes++;
+			}
+			break;
+		case 1:
+			// ESC [ starts a CSI sequence, anything else is a two byte sequence
+			sWire.escState = (c == '[') ? 2 : 0;
+			sWire.escBytes++;
+			break;
+		default:
+			// Parameters until the final byte
+			sWire.escBytes++;
+			if ((c >= 0x40) && (c <= 0x7E))
+			{
+				sWire.escState = 0;
+			}
+			break;
+	}
+}
+
+static uint32_t fake_millis(void)
+{
+	return 123456;
+}
+
+static uint8_t cmd_ping(uint8_t argc, char *argv[])
+{
+	(void)(argc);
+	(void)(argv);
+	gshell_putString("pong" G_CRLF);
+	return 0;
+}
+
+static uint8_t cmd_dummy(uint8_t argc, char *argv[])
+{
+	(void)(argc);
+	(void)(argv);
+	return 0;
+}
+
+static void feed(const char *str)
+{
+	gshell_processShellBuffer(str, (uint16_t)strlen(str), NULL, NULL);
+}
+
+static void op_logWarn(void)
+{
+	glog_warn("Battery low: %u mV", 3300);
+}
+
+static void op_logInfo(void)
+{
+	glog_info("Link up");
+}
+
+static void op_printf(void)
+{
+	gshell_printf("adc0: %u, adc1: %u" G_CRLF, 1023, 512);
+}
+
+static void op_putU32(void)
+{
+	gshell_putString("adc0: ");
+	gshell_putU32(1023);
+	gshell_putString(", adc1: ");
+	gshell_putU32(512);
+	gshell_putString(G_CRLF);
+}
+
+static void op_hexdump(void)
+{
+	static const uint8_t au8Data[64] = {0x12, 0x34, 0x56, 0x78, 'g', 's', 'h', 'e', 'l', 'l'};
+
+	gshell_hexdump(au8Data, sizeof(au8Data), 0x20000000);
+}
+
+static void op_keystroke(void)
+{
+	feed("x\b");
+}
+
+static void op_ping(void)
+{
+	feed("ping\n");
+}
+
+static void op_help(void)
+{
+	feed("help\n");
+}
+
+static void op_unknown(void)
+{
+	feed("pnig\n");
+}
+
+static const scenario_t sScenarios[] = {
+	{"glog_warn, prompt off",			NULL,			0, op_logWarn},
+	{"glog_warn, prompt on",			NULL,			1, op_logWarn},
+	{"glog_warn, prompt on + input",	BENCH_TYPED,	1, op_logWarn},
+	{"glog_info, prompt on",			NULL,			1, op_logInfo},
+	{"gshell_printf line",				NULL,			0, op_printf},
+	{"gshell_putU32 line",				NULL,			0, op_putU32},
+	{"gshell_hexdump 64 bytes",			NULL,			0, op_hexdump},
+	{"key stroke + backspace",			NULL,			1, op_keystroke},
+	{"command 'ping'",					NULL,			1, op_ping},
+	{"unknown command",					NULL,			1, op_unknown},
+	{"command 'help'",					NULL,			1, op_help},
+};
+
+static uint64_t now_ns(void)
+{
+	struct timespec sTime;
+
+	clock_gettime(CLOCK_MONOTONIC, &sTime);
+	return (uint64_t)sTime.tv_sec * 1000000000ull + (uint64_t)sTime.tv_nsec;
+}
+
+/* Sends everything queued, the queues are part of the output path */
+static void drain(void)
+{
+#ifdef G_ENABLE_TXQUEUES
+	gshell_txDrain(0);
+#endif
+}
+
+int main(int argc, char *argv[])
+{
+	static gshell_cmd_t sPingCmd = {"ping", cmd_ping, "Replies with pong", NULL};
+	static gshell_cmd_t sCmds[8];
+	static char cNames[8][12];
+	uint32_t u32Baud = 115200;
+	uint32_t u32FrameBits = 10;
+	uint32_t u32Iter = 100;
+	uint32_t u32_cnt;
+	uint64_t u64Start, u64Cpu;
+	double dBytes, dEsc, dWireUs;
+	uint8_t bCsv = 0;
+	size_t sIdx;
+	int iOpt;
+#ifdef G_ENABLE_TERMPROFILES
+	enum gshell_termprofile eProfile = GSHELL_TERM_ANSI;
+#endif
+
+	while ((iOpt = getopt(argc, argv, "b:f:n:ct:")) != -1)
+	{
+		switch (iOpt)
+		{
+			case 'b':	u32Baud = (uint32_t)strtoul(optarg, NULL, 0);		break;
+			case 'f':	u32FrameBits = (uint32_t)strtoul(optarg, NULL, 0);	break;
+			case 'n':	u32Iter = (uint32_t)strtoul(optarg, NULL, 0);		break;
+			case 'c':	bCsv = 1;											break;
+#ifdef G_ENABLE_TERMPROFILES
+			case 't':
+				eProfile = (strcmp(optarg, "plain") == 0) ? GSHELL_TERM_PLAIN :
+						   (strcmp(optarg, "minimal") == 0) ? GSHELL_TERM_MINIMAL : GSHELL_TERM_ANSI;
+				break;
+#endif
+			default:
+				fprintf(stderr, "Usage: %s [-b baudrate] [-f bits per character] [-n iterations] [-c] [-t ansi|minimal|plain]\n", argv[0]);
+				return 2;
+		}
+	}
+	if ((u32Baud == 0) || (u32FrameBits == 0) || (u32Iter == 0))
+	{
+		return 2;
+	}
+
+	gshell_init(&wire_putchar, &fake_millis);
+#ifdef G_ENABLE_TERMPROFILES
+	gshell_setTermProfile(eProfile);
+#endif
+	gshell_register_cmd(&sPingCmd);
+	// A few more commands, so 'help' has a realistic list to print
+	for (sIdx = 0; sIdx < sizeof(sCmds) / sizeof(sCmds[0]); sIdx++)
+	{
+		snprintf(cNames[sIdx], sizeof(cNames[sIdx]), "command%u", (unsigned)sIdx);
+		sCmds[sIdx].cmdName = cNames[sIdx];
+		sCmds[sIdx].handler = cmd_dummy;
+		sCmds[sIdx].desc = "Does something useful";
+		gshell_register_cmd(&sCmds[sIdx]);
+	}
+
+	if (bCsv)
+	{
+		printf("operation,bytes,escape_bytes,wire_us,cpu_ns\n");
+	}
+	else
+	{
+		printf("Link: %u baud, %u bits per character, %u iterations\n", u32Baud, u32FrameBits, u32Iter);
+		printf("%-32s %10s %14s %12s %10s\n", "Operation", "Bytes/op", "Escape/op", "Wire us/op", "CPU ns/op");
+	}
+
+	for (sIdx = 0; sIdx < sizeof(sScenarios) / sizeof(sScenarios[0]); sIdx++)
+	{
+		const scenario_t *psScen = &sScenarios[sIdx];
+
+		// Set up the terminal state, not counted
+		gshell_setPromt(psScen->prompt);
+		if (psScen->typed != NULL)
+		{
+			feed(psScen->typed);
+		}
+		drain();
+
+		memset(&sWire, 0, sizeof(sWire));
+		u64Start = now_ns();
+		for (u32_cnt = 0; u32_cnt < u32Iter; u32_cnt++)
+		{
+			psScen->run();
+			drain();
+		}
+		u64Cpu = now_ns() - u64Start;
+
+		dBytes = (double)sWire.bytes / u32Iter;
+		dEsc = (double)sWire.escBytes / u32Iter;
+		dWireUs = dBytes * u32FrameBits * 1e6 / u32Baud;
+		if (bCsv)
+		{
+			printf("\"%s\",%.1f,%.1f,%.1f,%.0f\n", psScen->name, dBytes, dEsc, dWireUs, (double)u64Cpu / u32Iter);
+		}
+		else
+		{
+			printf("%-32s %10.1f %7.1f (%3.0f%%) %12.1f %10.0f\n", psScen->name, dBytes, dEsc,
+				   (dBytes > 0) ? dEsc * 100.0 / dBytes : 0.0, dWireUs, (double)u64Cpu / u32Iter);
+		}
+
+		// Remove the typed input again, not counted
+		if (psScen->typed != NULL)
+		{
+			for (u32_cnt = 0; psScen->typed[u32_cnt] != '\0'; u32_cnt++)
+			{
+				feed("\b");
+			}
+		}
+		drain();
+	}
+	return 0;
+}
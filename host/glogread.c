@@ -0,0 +1,129 @@
+/**
+ * @brief Reader for gshell memory-mapped log files
+ *
+ * Prints the records of log files written by gshell_maplog, one line per
+ * record. With -r, the rotated files (file.N ... file.1) are printed first,
+ * so the output is in chronological order.
+ *
+ * Build: gcc -O2 -o glogread host/glogread.c
+ * Usage: glogread [-r] <file> [<file> ...]
+ */
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "gshell_maplog.h"
+
+static const char *const levelNames[6] = {
+	"      ", " INFO ", "  OK  ", " WARN ", "ERROR!", "PANIC!"
+};
+
+/* Prints all records of a single file, returns -1 if it isn't a valid log file */
+static int print_file(const char *path)
+{
+	struct stat sStat;
+	const gmaplog_header_t *psHeader;
+	const gmaplog_record_t *psRecord;
+	const uint8_t *pu8Map;
+	uint32_t u32Offset;
+	uint32_t u32End;
+	int fd;
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		return -1;
+	}
+	if ((fstat(fd, &sStat) < 0) || (sStat.st_size < (off_t)sizeof(gmaplog_header_t)))
+	{
+		close(fd);
+		return -1;
+	}
+	pu8Map = mmap(NULL, sStat.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (pu8Map == MAP_FAILED)
+	{
+		return -1;
+	}
+
+	psHeader = (const gmaplog_header_t *)pu8Map;
+	if ((psHeader->magic != GMAPLOG_MAGIC) || (psHeader->version != GMAPLOG_VERSION) ||
+		(psHeader->fileSize != (uint32_t)sStat.st_size))
+	{
+		fprintf(stderr, "%s: not a gshell log file\n", path);
+		munmap((void *)pu8Map, sStat.st_size);
+		return -1;
+	}
+
+	// Only the records up to the published write offset are complete
+	u32End = psHeader->writeOffset;
+	if (u32End > psHeader->fileSize)
+	{
+		u32End = psHeader->fileSize;
+	}
+	for (u32Offset = psHeader->headerSize; u32Offset + sizeof(gmaplog_record_t) <= u32End; )
+	{
+		psRecord = (const gmaplog_record_t *)(pu8Map + u32Offset);
+		if (u32Offset + sizeof(gmaplog_record_t) + psRecord->length > u32End)
+		{
+			break;
+		}
+		printf("%10u [%s] [%09u] %.*s\n", psRecord->sequence,
+			   levelNames[(psRecord->level < 6) ? psRecord->level : 0],
+			   psRecord->timestamp, (int)psRecord->length, (const char *)(psRecord + 1));
+		u32Offset += (sizeof(gmaplog_record_t) + psRecord->length + 3u) & ~3u;
+	}
+
+	munmap((void *)pu8Map, sStat.st_size);
+	return 0;
+}
+
+int main(int argc, char *argv[])
+{
+	char cPath[GMAPLOG_PATHLEN + 8];
+	int iRotated = 0;
+	int iArg = 1;
+	int iRet = 0;
+	int iGen;
+
+	if ((argc > 1) && (strcmp(argv[1], "-r") == 0))
+	{
+		iRotated = 1;
+		iArg++;
+	}
+	if (iArg >= argc)
+	{
+		fprintf(stderr, "Usage: %s [-r] <file> [<file> ...]\n", argv[0]);
+		return 2;
+	}
+
+	for (; iArg < argc; iArg++)
+	{
+		if (iRotated)
+		{
+			// Find the oldest rotated file, then print them from oldest to newest
+			for (iGen = 1; iGen < 256; iGen++)
+			{
+				snprintf(cPath, sizeof(cPath), "%s.%d", argv[iArg], iGen);
+				if (access(cPath, R_OK) != 0)
+				{
+					break;
+				}
+			}
+			for (iGen--; iGen > 0; iGen--)
+			{
+				snprintf(cPath, sizeof(cPath), "%s.%d", argv[iArg], iGen);
+				print_file(cPath);
+			}
+		}
+		if (print_file(argv[iArg]) < 0)
+		{
+			iRet = 1;
+		}
+	}
+	return iRet;
+}
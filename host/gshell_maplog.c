@@ -0,0 +1,203 @@
+/**
+ * @file gshell_maplog.c
+ * @brief Memory-mapped persistent log file for Linux hosts
+ * @author gfcwfzkm
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "gshell_maplog.h"
+
+#ifndef G_ENABLE_LOGSINKS
+	#error "gshell_maplog requires G_ENABLE_LOGSINKS to be enabled in gshell.h"
+#endif
+
+/* Records are aligned to 4 bytes */
+#define _GML_ALIGN(x)	(((x) + 3u) & ~3u)
+
+/* Maps the file at log->path, creates / resets it if it's not a valid log */
+static int _gmaplog_map(gmaplog_t *log, uint32_t u32Sequence, uint32_t u32Rotations)
+{
+	struct stat sStat;
+	uint8_t bValid = 0;
+
+	log->fd = open(log->path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (log->fd < 0)
+	{
+		return -1;
+	}
+	if ((fstat(log->fd, &sStat) < 0) || ((sStat.st_size != log->size) && (ftruncate(log->fd, log->size) < 0)))
+	{
+		close(log->fd);
+		return -1;
+	}
+
+	log->map = mmap(NULL, log->size, PROT_READ | PROT_WRITE, MAP_SHARED, log->fd, 0);
+	if (log->map == MAP_FAILED)
+	{
+		close(log->fd);
+		return -1;
+	}
+	log->header = (gmaplog_header_t *)log->map;
+
+	// Continue a existing file if the header makes sense
+	if (sStat.st_size == log->size)
+	{
+		bValid = (log->header->magic == GMAPLOG_MAGIC) && (log->header->version == GMAPLOG_VERSION) &&
+				 (log->header->headerSize == sizeof(gmaplog_header_t)) && (log->header->fileSize == log->size) &&
+				 (log->header->writeOffset >= sizeof(gmaplog_header_t)) && (log->header->writeOffset <= log->size);
+	}
+	if (!bValid)
+	{
+		memset(log->header, 0, sizeof(gmaplog_header_t));
+		log->header->version = GMAPLOG_VERSION;
+		log->header->headerSize = sizeof(gmaplog_header_t);
+		log->header->fileSize = log->size;
+		log->header->writeOffset = sizeof(gmaplog_header_t);
+		log->header->sequence = u32Sequence;
+		log->header->rotations = u32Rotations;
+		// Magic last, a torn initialisation is then simply redone
+		__atomic_store_n(&log->header->magic, GMAPLOG_MAGIC, __ATOMIC_RELEASE);
+	}
+	return 0;
+}
+
+static void _gmaplog_unmap(gmaplog_t *log)
+{
+	if (log->map != NULL)
+	{
+		munmap(log->map, log->size);
+		log->map = NULL;
+		log->header = NULL;
+	}
+	if (log->fd >= 0)
+	{
+		close(log->fd);
+		log->fd = -1;
+	}
+}
+
+/* Shifts the rotated files by one (log.N-1 -> log.N ... log -> log.1) and starts a new file */
+static int _gmaplog_rotate(gmaplog_t *log)
+{
+	char cOld[GMAPLOG_PATHLEN + 4];
+	char cNew[GMAPLOG_PATHLEN + 4];
+	uint32_t u32Sequence = log->header->sequence;
+	uint32_t u32Rotations = log->header->rotations + 1;
+	uint8_t u8Gen;
+
+	_gmaplog_unmap(log);
+
+	if (log->keep == 0)
+	{
+		// Nothing to keep, start over within the same file
+		if (truncate(log->path, 0) < 0)
+		{
+			return -1;
+		}
+	}
+	else
+	{
+		for (u8Gen = log->keep; u8Gen > 1; u8Gen--)
+		{
+			snprintf(cOld, sizeof(cOld), "%s.%u", log->path, u8Gen - 1);
+			snprintf(cNew, sizeof(cNew), "%s.%u", log->path, u8Gen);
+			rename(cOld, cNew);
+		}
+		snprintf(cNew, sizeof(cNew), "%s.1", log->path);
+		if (rename(log->path, cNew) < 0)
+		{
+			return -1;
+		}
+	}
+
+	return _gmaplog_map(log, u32Sequence, u32Rotations);
+}
+
+int gmaplog_open(gmaplog_t *log, const char *path, uint32_t size, uint8_t keep)
+{
+	memset(log, 0, sizeof(gmaplog_t));
+	log->fd = -1;
+
+	if ((size < GMAPLOG_MINSIZE) || (strlen(path) >= GMAPLOG_PATHLEN))
+	{
+		errno = EINVAL;
+		return -1;
+	}
+	strcpy(log->path, path);
+	log->size = size;
+	log->keep = keep;
+
+	return _gmaplog_map(log, 0, 0);
+}
+
+int gmaplog_write(gmaplog_t *log, uint8_t level, uint32_t timestamp, const char *text, uint16_t length)
+{
+	gmaplog_record_t *psRecord;
+	uint32_t u32Offset;
+	uint32_t u32Needed;
+
+	if (log->map == NULL)
+	{
+		return -1;
+	}
+
+	// Messages that can't fit even into a empty file are cut
+	if (sizeof(gmaplog_header_t) + sizeof(gmaplog_record_t) + length > log->size)
+	{
+		length = (uint16_t)(log->size - sizeof(gmaplog_header_t) - sizeof(gmaplog_record_t));
+	}
+	u32Needed = _GML_ALIGN(sizeof(gmaplog_record_t) + length);
+
+	if (log->header->writeOffset + u32Needed > log->size)
+	{
+		if (_gmaplog_rotate(log) < 0)
+		{
+			return -1;
+		}
+	}
+
+	// Copy the record first, then publish it by moving the write offset
+	u32Offset = log->header->writeOffset;
+	psRecord = (gmaplog_record_t *)(log->map + u32Offset);
+	psRecord->length = length;
+	psRecord->level = level;
+	psRecord->reserved = 0;
+	psRecord->sequence = log->header->sequence;
+	psRecord->timestamp = timestamp;
+	memcpy(psRecord + 1, text, length);
+
+	log->header->sequence++;
+	__atomic_store_n(&log->header->writeOffset, u32Offset + u32Needed, __ATOMIC_RELEASE);
+	return 0;
+}
+
+void gmaplog_sinkWrite(void *ctx, const gshell_logrec_t *record)
+{
+	gmaplog_write((gmaplog_t *)ctx, (uint8_t)record->level, record->timestamp, record->text, record->length);
+}
+
+int gmaplog_sync(gmaplog_t *log, uint8_t wait)
+{
+	if (log->map == NULL)
+	{
+		return -1;
+	}
+	return msync(log->map, log->size, wait ? MS_SYNC : MS_ASYNC);
+}
+
+void gmaplog_close(gmaplog_t *log)
+{
+	if (log->map != NULL)
+	{
+		msync(log->map, log->size, MS_SYNC);
+	}
+	_gmaplog_unmap(log);
+}
@@ -0,0 +1,134 @@
+/**
+ * @file gshell_maplog.h
+ * @brief Memory-mapped persistent log file for Linux hosts
+ *
+ * Stores the gshell log records in a pre-sized, memory-mapped file. Appending
+ * a record is a memcpy into the map and an update of the file header, there is
+ * no system call per log line. The kernel writes the pages back on its own,
+ * so the log survives a crash of the program. Once the file is full, it is
+ * rotated (log -> log.1 -> log.2 ...) and a new one is started.
+ *
+ * Requires \a G_ENABLE_LOGSINKS to be enabled in gshell.h. Use as followed:
+ *
+ * static gmaplog_t sLog;
+ * static gshell_sink_t sLogSink = { .write = gmaplog_sinkWrite, .ctx = &sLog, .minLevel = GLOG_ERROR };
+ * gmaplog_open(&sLog, "/var/log/gshell.glog", 1024 * 1024, 3);
+ * gshell_addSink(&sLogSink);
+ *
+ * The files can be read with the glogread tool (host/glogread.c).
+ *
+ * \author gfcwfzkm
+ * \copyright GNU Lesser General Public License v2.1
+ */
+#ifndef GSHELL_MAPLOG_H_
+#define GSHELL_MAPLOG_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../gshell.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GMAPLOG_MAGIC		0x474F4C47u	/**< 'GLOG' in little endian */
+#define GMAPLOG_VERSION		1
+#define GMAPLOG_MINSIZE		4096		/**< Smallest allowed file size */
+#define GMAPLOG_PATHLEN		256			/**< Maximum length of the file path */
+
+/**
+ * @brief File header, at the start of every log file
+ *
+ * \a writeOffset and \a sequence are updated after the record has been
+ * copied, so a crash never leaves a half-written record within the valid range.
+ */
+typedef struct gmaplog_header {
+	uint32_t magic;			/**< GMAPLOG_MAGIC */
+	uint16_t version;		/**< GMAPLOG_VERSION */
+	uint16_t headerSize;	/**< sizeof(gmaplog_header_t), records start here */
+	uint32_t fileSize;		/**< Size of the whole file in bytes */
+	uint32_t writeOffset;	/**< End of the last complete record */
+	uint32_t sequence;		/**< Sequence number of the next record, continues over rotations */
+	uint32_t rotations;		/**< Amount of rotations so far */
+} gmaplog_header_t;
+
+/**
+ * @brief Record header, followed by the message text and padded to 4 bytes
+ */
+typedef struct gmaplog_record {
+	uint16_t length;		/**< Length of the message text */
+	uint8_t level;			/**< enum glog_level */
+	uint8_t reserved;
+	uint32_t sequence;		/**< Sequence number of this record */
+	uint32_t timestamp;		/**< Millisecond tick of the record */
+} gmaplog_record_t;
+
+/**
+ * @brief Log file object
+ */
+typedef struct gmaplog {
+	int fd;								/**< File descriptor of the open file */
+	uint8_t *map;						/**< Memory-mapped file content */
+	gmaplog_header_t *header;			/**< Header at the start of the map */
+	uint32_t size;						/**< Size of the file / map */
+	uint8_t keep;						/**< Amount of rotated files to keep */
+	char path[GMAPLOG_PATHLEN];			/**< Path of the current file */
+} gmaplog_t;
+
+/**
+ * @brief Open or create a log file
+ *
+ * A existing, valid log file of the same size is continued, otherwise it is
+ * (re-)initialised.
+ *
+ * @param log	Log file object
+ * @param path	Path of the log file
+ * @param size	Size of the file in bytes, at least GMAPLOG_MINSIZE
+ * @param keep	Amount of rotated files to keep, zero to restart the file once full
+ * @return		0 on success, -1 on error (errno is set)
+ */
+int gmaplog_open(gmaplog_t *log, const char *path, uint32_t size, uint8_t keep);
+
+/**
+ * @brief Append a record to the log file
+ *
+ * @param log		Log file object
+ * @param level		enum glog_level of the record
+ * @param timestamp	Millisecond tick of the record
+ * @param text		Message text
+ * @param length	Length of the message text
+ * @return			0 on success, -1 if the rotation failed
+ */
+int gmaplog_write(gmaplog_t *log, uint8_t level, uint32_t timestamp, const char *text, uint16_t length);
+
+#ifdef G_ENABLE_LOGSINKS
+/**
+ * @brief Write function for a \a gshell_sink_t , expects a gmaplog_t as context
+ */
+void gmaplog_sinkWrite(void *ctx, const gshell_logrec_t *record);
+#endif
+
+/**
+ * @brief Schedules the write-back of the file to the storage
+ *
+ * Not required for crash safety of the program, only to narrow the window on a
+ * power loss or kernel crash.
+ *
+ * @param log	Log file object
+ * @param wait	Non-zero to wait for the write-back to finish
+ * @return		0 on success, -1 on error
+ */
+int gmaplog_sync(gmaplog_t *log, uint8_t wait);
+
+/**
+ * @brief Close the log file
+ *
+ * @param log	Log file object
+ */
+void gmaplog_close(gmaplog_t *log);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GSHELL_MAPLOG_H_
@@ -0,0 +1,321 @@
+/**
+ * @file gshell_plugin.c
+ * @brief Lazy-loaded command modules for Linux hosts
+ * @author gfcwfzkm
+ */
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "gshell_plugin.h"
+
+#define _GPL_BLANKS		" \t"
+#define _GPL_MAXCMD		0x7FFF		/* Commands allowed by gshell */
+
+/* Loaded manifests, searched by the handler stub which has no context */
+static gplugin_t *psPlugins = NULL;
+static uint16_t u16Loaded = 0;
+
+/* Reads the whole file into a terminated, allocated buffer */
+static char *_gplugin_readFile(const char *path)
+{
+	struct stat sStat;
+	char *pcText;
+	size_t sLen = 0;
+	ssize_t sRead;
+	int iFd;
+
+	iFd = open(path, O_RDONLY | O_CLOEXEC);
+	if (iFd < 0)
+	{
+		return NULL;
+	}
+	if (fstat(iFd, &sStat) < 0)
+	{
+		close(iFd);
+		return NULL;
+	}
+	pcText = malloc((size_t)sStat.st_size + 1);
+	if (pcText == NULL)
+	{
+		close(iFd);
+		return NULL;
+	}
+	while (sLen < (size_t)sStat.st_size)
+	{
+		sRead = read(iFd, pcText + sLen, (size_t)sStat.st_size - sLen);
+		if (sRead < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			free(pcText);
+			close(iFd);
+			return NULL;
+		}
+		if (sRead == 0)
+		{
+			break;
+		}
+		sLen += (size_t)sRead;
+	}
+	pcText[sLen] = '\0';
+	close(iFd);
+	return pcText;
+}
+
+/* Cuts the next word off *ppcPos, NULL if there is none */
+static char *_gplugin_word(char **ppcPos)
+{
+	char *pcWord = *ppcPos + strspn(*ppcPos, _GPL_BLANKS);
+	char *pcEnd;
+
+	if (*pcWord == '\0')
+	{
+		return NULL;
+	}
+	pcEnd = pcWord + strcspn(pcWord, _GPL_BLANKS);
+	if (*pcEnd != '\0')
+	{
+		*pcEnd++ = '\0';
+	}
+	*ppcPos = pcEnd;
+	return pcWord;
+}
+
+/* Returns the module of the path, relative to the directory of the manifest, adds it if new */
+static gplugin_module_t *_gplugin_module(gplugin_t *plugins, const char *manifest, const char *path)
+{
+	const char *pcSlash = strrchr(manifest, '/');
+	size_t sDirLen = (pcSlash != NULL) ? (size_t)(pcSlash - manifest) + 1 : 2;
+	gplugin_module_t *module;
+	char *pcPath;
+	uint16_t u16_cnt;
+
+	if (path[0] == '/')
+	{
+		pcPath = strdup(path);
+	}
+	else
+	{
+		pcPath = malloc(sDirLen + strlen(path) + 1);
+		if (pcPath != NULL)
+		{
+			// No directory given, dlopen has to look in the current one rather than the library path
+			memcpy(pcPath, (pcSlash != NULL) ? manifest : "./", sDirLen);
+			strcpy(pcPath + sDirLen, path);
+		}
+	}
+	if (pcPath == NULL)
+	{
+		return NULL;
+	}
+
+	for (u16_cnt = 0; u16_cnt < plugins->moduleCount; u16_cnt++)
+	{
+		if (strcmp(plugins->modules[u16_cnt].path, pcPath) == 0)
+		{
+			free(pcPath);
+			return &plugins->modules[u16_cnt];
+		}
+	}
+	module = &plugins->modules[plugins->moduleCount++];
+	module->path = pcPath;
+	module->handle = NULL;
+	return module;
+}
+
+static void _gplugin_free(gplugin_t *plugins)
+{
+	uint16_t u16_cnt;
+
+	for (u16_cnt = 0; u16_cnt < plugins->moduleCount; u16_cnt++)
+	{
+		free(plugins->modules[u16_cnt].path);
+	}
+	free(plugins->modules);
+	free(plugins->entries);
+	free(plugins->text);
+	memset(plugins, 0, sizeof(gplugin_t));
+}
+
+static gplugin_entry_t *_gplugin_find(const char *name)
+{
+	gplugin_t *plugins;
+	uint16_t u16_cnt;
+
+	for (plugins = psPlugins; plugins != NULL; plugins = plugins->next)
+	{
+		for (u16_cnt = 0; u16_cnt < plugins->entryCount; u16_cnt++)
+		{
+			if (strcmp(plugins->entries[u16_cnt].cmd.cmdName, name) == 0)
+			{
+				return &plugins->entries[u16_cnt];
+			}
+		}
+	}
+	return NULL;
+}
+
+/* Opens the module of the entry if needed and looks up its handler, prints why if it fails */
+static int _gplugin_resolve(gplugin_entry_t *entry)
+{
+	gplugin_module_t *module = entry->module;
+	int (*fp_init)(void);
+	void *pvSym;
+
+	if (module->handle == NULL)
+	{
+		module->handle = dlopen(module->path, RTLD_NOW | RTLD_LOCAL);
+		if (module->handle == NULL)
+		{
+			gshell_printf("Can't load %s" G_CRLF, dlerror());
+			return -1;
+		}
+		*(void **)(&fp_init) = dlsym(module->handle, GPLUGIN_INITSYM);
+		if ((fp_init != NULL) && (fp_init() != 0))
+		{
+			gshell_printf("%s failed to initialise" G_CRLF, module->path);
+			dlclose(module->handle);
+			module->handle = NULL;
+			return -1;
+		}
+		u16Loaded++;
+	}
+
+	pvSym = dlsym(module->handle, entry->symbol);
+	if (pvSym == NULL)
+	{
+		gshell_printf("%s doesn't provide %s" G_CRLF, module->path, entry->symbol);
+		return -1;
+	}
+	*(void **)(&entry->handler) = pvSym;
+	return 0;
+}
+
+/* Handler of all plugin commands, argv[0] tells which one has been called */
+static uint8_t _gplugin_stub(uint8_t argc, char *argv[])
+{
+	gplugin_entry_t *entry = _gplugin_find(argv[0]);
+
+	if ((entry == NULL) || ((entry->handler == NULL) && (_gplugin_resolve(entry) != 0)))
+	{
+		return 0;
+	}
+	return entry->handler(argc, argv);
+}
+
+int gplugin_load(gplugin_t *plugins, const char *manifest)
+{
+	gplugin_entry_t *entry;
+	char *pcLine, *pcNext, *pcPos, *pcEnd;
+	char *pcName, *pcModule, *pcSymbol;
+	uint32_t u32Lines = 1;
+	uint16_t u16_cnt;
+
+	memset(plugins, 0, sizeof(gplugin_t));
+	plugins->text = _gplugin_readFile(manifest);
+	if (plugins->text == NULL)
+	{
+		return -1;
+	}
+
+	// One command per line at most, the arrays never move once registered
+	for (pcPos = plugins->text; (pcPos = strchr(pcPos, '\n')) != NULL; pcPos++, u32Lines++);
+	if (u32Lines > _GPL_MAXCMD)
+	{
+		u32Lines = _GPL_MAXCMD;
+	}
+	plugins->entries = calloc(u32Lines, sizeof(gplugin_entry_t));
+	plugins->modules = calloc(u32Lines, sizeof(gplugin_module_t));
+	if ((plugins->entries == NULL) || (plugins->modules == NULL))
+	{
+		_gplugin_free(plugins);
+		errno = ENOMEM;
+		return -1;
+	}
+
+	for (pcLine = plugins->text; pcLine != NULL; pcLine = pcNext)
+	{
+		pcNext = strchr(pcLine, '\n');
+		if (pcNext != NULL)
+		{
+			*pcNext++ = '\0';
+		}
+		pcPos = pcLine + strcspn(pcLine, "#\r");
+		*pcPos = '\0';
+
+		pcPos = pcLine;
+		pcName = _gplugin_word(&pcPos);
+		if (pcName == NULL)
+		{
+			// Empty line or comment
+			continue;
+		}
+		pcModule = _gplugin_word(&pcPos);
+		pcSymbol = _gplugin_word(&pcPos);
+		if ((pcSymbol == NULL) || (plugins->entryCount >= u32Lines))
+		{
+			_gplugin_free(plugins);
+			errno = EINVAL;
+			return -1;
+		}
+
+		// The rest of the line is the description, without the surrounding blanks
+		pcPos += strspn(pcPos, _GPL_BLANKS);
+		for (pcEnd = pcPos + strlen(pcPos); (pcEnd > pcPos) && strchr(_GPL_BLANKS, pcEnd[-1]); *--pcEnd = '\0');
+
+		entry = &plugins->entries[plugins->entryCount];
+		entry->module = _gplugin_module(plugins, manifest, pcModule);
+		if (entry->module == NULL)
+		{
+			_gplugin_free(plugins);
+			errno = ENOMEM;
+			return -1;
+		}
+		entry->symbol = pcSymbol;
+		entry->cmd.cmdName = pcName;
+		entry->cmd.handler = _gplugin_stub;
+		entry->cmd.desc = pcPos;
+		plugins->entryCount++;
+	}
+
+	// Known to the stub before gshell may call it
+	plugins->next = psPlugins;
+	psPlugins = plugins;
+
+	for (u16_cnt = 0; u16_cnt < plugins->entryCount; u16_cnt++)
+	{
+		if (gshell_register_cmd(&plugins->entries[u16_cnt].cmd) < 0)
+		{
+			// The ones before stay registered, gshell can't drop them again
+			plugins->entryCount = u16_cnt;
+			errno = ENOSPC;
+			return -1;
+		}
+	}
+	return plugins->entryCount;
+}
+
+int gplugin_preload(const char *name)
+{
+	gplugin_entry_t *entry = _gplugin_find(name);
+
+	if (entry == NULL)
+	{
+		return -1;
+	}
+	return (entry->handler != NULL) ? 0 : _gplugin_resolve(entry);
+}
+
+uint16_t gplugin_loadedModules(void)
+{
+	return u16Loaded;
+}
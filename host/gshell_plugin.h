@@ -0,0 +1,108 @@
+/**
+ * @file gshell_plugin.h
+ * @brief Lazy-loaded command modules for Linux hosts
+ *
+ * Registers the commands listed in a manifest without loading their code. The
+ * shared object providing a handler is opened with dlopen on the first call of
+ * one of its commands and stays loaded, so the startup time depends on the
+ * commands actually used rather than on the size of the catalog.
+ *
+ * Manifest, one command per line, '#' starts a comment:
+ *
+ * # name		module			symbol			description
+ * fwupdate		fw.so			cmd_fwupdate	Updates the device firmware
+ * fwinfo		fw.so			cmd_fwinfo		Prints the firmware version
+ * netstat		net.so			cmd_netstat		Lists the open connections
+ *
+ * Relative module paths are taken relative to the directory of the manifest. The
+ * handlers are ordinary gshell command handlers. Once a module has been opened,
+ * its optional 'int gplugin_init(void)' is called - a non-zero return closes the
+ * module again and the command fails. Modules call back into gshell, so link
+ * the program with -rdynamic (and -ldl). Use as followed:
+ *
+ * static gplugin_t sPlugins;
+ * gshell_init(&gtty_putChar, &millis);
+ * gplugin_load(&sPlugins, "/usr/lib/mytool/commands.manifest");
+ *
+ * Several manifests can be loaded, each into its own object. The commands can't
+ * be unregistered from gshell, so the objects and modules stay until the
+ * program exits. Modules are loaded on the input thread only.
+ *
+ * \author gfcwfzkm
+ * \copyright GNU Lesser General Public License v2.1
+ */
+#ifndef GSHELL_PLUGIN_H_
+#define GSHELL_PLUGIN_H_
+
+#include <stdint.h>
+#include "../gshell.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GPLUGIN_INITSYM		"gplugin_init"	/**< Optional initialisation function of a module */
+
+/**
+ * @brief Shared object listed in a manifest
+ */
+typedef struct gplugin_module {
+	char *path;								/**< Path passed over to dlopen */
+	void *handle;							/**< dlopen handle, NULL until the first call of one of its commands */
+} gplugin_module_t;
+
+/**
+ * @brief Command listed in a manifest. The fields are internal
+ */
+typedef struct gplugin_entry {
+	gshell_cmd_t cmd;						/**< Registered command, name and description point into the manifest text */
+	const char *symbol;						/**< Name of the handler within the module */
+	gplugin_module_t *module;				/**< Module providing the handler */
+	uint8_t (*handler)(uint8_t argc, char *argv[]);	/**< Resolved handler, NULL until the first call */
+} gplugin_entry_t;
+
+/**
+ * @brief Commands of one manifest. The fields are internal
+ */
+typedef struct gplugin {
+	char *text;								/**< Manifest content, split into strings in place */
+	gplugin_entry_t *entries;				/**< Commands */
+	gplugin_module_t *modules;				/**< Modules, each listed once */
+	uint16_t entryCount;					/**< Amount of commands */
+	uint16_t moduleCount;					/**< Amount of modules */
+	struct gplugin *next;					/**< Next loaded manifest */
+} gplugin_t;
+
+/**
+ * @brief Reads a manifest and registers its commands
+ *
+ * Call after \a gshell_init . No module is opened yet. Nothing is registered
+ * if a line of the manifest is malformed.
+ *
+ * @param plugins	Object holding the commands, has to stay valid
+ * @param manifest	Path of the manifest
+ * @return			Amount of registered commands, -1 on error (errno is set, EINVAL for a malformed manifest)
+ */
+int gplugin_load(gplugin_t *plugins, const char *manifest);
+
+/**
+ * @brief Opens the module of a command right away
+ *
+ * For commands which have to respond quickly on their first call. The handler
+ * is resolved as it would be on the first call.
+ *
+ * @param name		Name of the command
+ * @return			0 on success, -1 if the command is unknown or its module failed to load
+ */
+int gplugin_preload(const char *name);
+
+/**
+ * @brief Returns the amount of modules opened so far, over all manifests
+ */
+uint16_t gplugin_loadedModules(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GSHELL_PLUGIN_H_
@@ -0,0 +1,478 @@
+/**
+ * @file gshell_server.c
+ * @brief Multi-session gshell server for Linux hosts
+ * @author gfcwfzkm
+ */
+
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <errno.h>
+#include <limits.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "gshell_server.h"
+
+#ifndef G_ENABLE_SESSIONS
+	#error "gshell_server requires G_ENABLE_SESSIONS to be enabled in gshell.h"
+#endif
+
+/* Writes as much of the pending output as the socket takes right now */
+static void _gserver_flush(gserver_conn_t *conn)
+{
+	ssize_t iSent;
+
+	while (conn->outLen > 0)
+	{
+		iSent = send(conn->fd, conn->out, conn->outLen, MSG_NOSIGNAL | MSG_DONTWAIT);
+		if (iSent < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+			{
+				// Peer is gone, nobody is going to read the rest
+				conn->outLen = 0;
+				conn->closing = 1;
+			}
+			return;
+		}
+		if ((uint32_t)iSent < conn->outLen)
+		{
+			memmove(conn->out, conn->out + iSent, conn->outLen - iSent);
+		}
+		conn->outLen -= (uint32_t)iSent;
+	}
+}
+
+/* gshell output function of all connections, the selected session tells which one */
+static void _gserver_putChar(char c)
+{
+	gserver_conn_t *conn = (gserver_conn_t *)gshell_sessionGet()->user;
+
+	if (conn->outLen >= GSERVER_OUTBUF)
+	{
+		_gserver_flush(conn);
+		if (conn->outLen >= GSERVER_OUTBUF)
+		{
+			conn->dropped++;
+			return;
+		}
+	}
+	conn->out[conn->outLen++] = c;
+}
+
+/* Registers the epoll events required by the connection state, if they changed */
+static void _gserver_updateEvents(gserver_conn_t *conn)
+{
+	struct epoll_event sEvent;
+	uint32_t u32Events = 0;
+
+	// Stop reading while the client doesn't take its output
+	conn->waitOut = (conn->outLen > (GSERVER_OUTBUF / 2));
+	if (!conn->waitOut && !conn->closing)
+	{
+		u32Events |= EPOLLIN;
+	}
+	if ((conn->outLen > 0) || conn->closing)
+	{
+		// A closing connection without output is freed on the next writable event
+		u32Events |= EPOLLOUT;
+	}
+
+	if (u32Events != conn->events)
+	{
+		sEvent.events = u32Events;
+		sEvent.data.ptr = conn;
+		epoll_ctl(conn->server->epfd, EPOLL_CTL_MOD, conn->fd, &sEvent);
+		conn->events = u32Events;
+	}
+}
+
+static void _gserver_freeConn(gserver_t *srv, gserver_conn_t *conn)
+{
+	if (srv->onClose != NULL)
+	{
+		srv->onClose(conn);
+	}
+	epoll_ctl(srv->epfd, EPOLL_CTL_DEL, conn->fd, NULL);
+	close(conn->fd);
+	gshell_sessionClose(&conn->session);
+
+	if (conn->prev != NULL)
+	{
+		conn->prev->next = conn->next;
+	}
+	else
+	{
+		srv->conns = conn->next;
+	}
+	if (conn->next != NULL)
+	{
+		conn->next->prev = conn->prev;
+	}
+	srv->connCount--;
+	free(conn);
+}
+
+static void _gserver_accept(gserver_t *srv, int listenFd)
+{
+	struct epoll_event sEvent;
+	gshell_session_t *psPrevious;
+	gserver_conn_t *conn;
+	int iOne = 1;
+	int fd;
+
+	// Take all pending connections at once
+	while ((fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+	{
+		conn = calloc(1, sizeof(gserver_conn_t));
+		if (conn == NULL)
+		{
+			close(fd);
+			continue;
+		}
+		// Output is batched already, don't let Nagle delay it any further (fails on Unix sockets)
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &iOne, sizeof(iOne));
+
+		conn->fd = fd;
+		conn->server = srv;
+		conn->events = EPOLLIN;
+		sEvent.events = EPOLLIN;
+		sEvent.data.ptr = conn;
+		if (epoll_ctl(srv->epfd, EPOLL_CTL_ADD, fd, &sEvent) < 0)
+		{
+			close(fd);
+			free(conn);
+			continue;
+		}
+		conn->next = srv->conns;
+		if (srv->conns != NULL)
+		{
+			srv->conns->prev = conn;
+		}
+		srv->conns = conn;
+		srv->connCount++;
+
+		gshell_sessionInit(&conn->session, _gserver_putChar);
+		conn->session.user = conn;
+
+		psPrevious = gshell_sessionSelect(&conn->session);
+		if (srv->onConnect != NULL)
+		{
+			srv->onConnect(conn);
+		}
+		gshell_setPromt(1);
+#ifdef G_ENABLE_TXQUEUES
+		gshell_txDrain(0);
+#endif
+		gshell_sessionSelect(psPrevious);
+
+		_gserver_flush(conn);
+		_gserver_updateEvents(conn);
+	}
+}
+
+/* Reads and processes one chunk of input, returns -1 if the peer is gone */
+static int _gserver_input(gserver_t *srv, gserver_conn_t *conn)
+{
+	char cBuf[GSERVER_READBUF];
+	gshell_session_t *psPrevious;
+	gshell_result_t sResult;
+	ssize_t iLength;
+	uint16_t u16Pos;
+	uint16_t u16Used;
+
+	iLength = recv(conn->fd, cBuf, sizeof(cBuf), MSG_DONTWAIT);
+	if (iLength == 0)
+	{
+		return -1;
+	}
+	if (iLength < 0)
+	{
+		return ((errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR)) ? 0 : -1;
+	}
+
+	psPrevious = gshell_sessionSelect(&conn->session);
+	for (u16Pos = 0; (u16Pos < iLength) && !conn->closing; u16Pos += u16Used)
+	{
+		if ((gshell_processShellBuffer(cBuf + u16Pos, (uint16_t)(iLength - u16Pos), &u16Used, &sResult) == GSHELL_CMDRET) &&
+			(srv->onResult != NULL) && srv->onResult(conn, &sResult))
+		{
+			conn->closing = 1;
+		}
+	}
+#ifdef G_ENABLE_TXQUEUES
+	// The connection buffers the output itself, keep the queues empty
+	gshell_txDrain(0);
+#endif
+	gshell_sessionSelect(psPrevious);
+	return 0;
+}
+
+/* Runs the scheduled work of the connection's session ('watch' / 'repeat', deferred promt) */
+static void _gserver_poll(gserver_t *srv, gserver_conn_t *conn)
+{
+	gshell_session_t *psPrevious;
+	gshell_result_t sResult;
+
+	psPrevious = gshell_sessionSelect(&conn->session);
+	if ((gshell_poll(&sResult) == GSHELL_CMDRET) && (srv->onResult != NULL) && srv->onResult(conn, &sResult))
+	{
+		conn->closing = 1;
+	}
+#ifdef G_ENABLE_TXQUEUES
+	gshell_txDrain(0);
+#endif
+	gshell_sessionSelect(psPrevious);
+}
+
+/* Shortens the wait to the next scheduled work of the sessions */
+static int _gserver_timeout(gserver_t *srv, int timeoutMs)
+{
+	gshell_session_t *psPrevious = gshell_sessionGet();
+	gserver_conn_t *conn;
+	uint32_t u32Deadline;
+
+	for (conn = srv->conns; conn != NULL; conn = conn->next)
+	{
+		if (conn->closing || conn->waitOut)
+		{
+			continue;
+		}
+		gshell_sessionSelect(&conn->session);
+		u32Deadline = gshell_nextDeadline();
+		if ((u32Deadline != GSHELL_NODEADLINE) && ((timeoutMs < 0) || (u32Deadline < (uint32_t)timeoutMs)))
+		{
+			timeoutMs = (u32Deadline > INT_MAX) ? INT_MAX : (int)u32Deadline;
+		}
+	}
+	gshell_sessionSelect(psPrevious);
+	return timeoutMs;
+}
+
+static int _gserver_listen(gserver_t *srv, int fd)
+{
+	struct epoll_event sEvent;
+	uint8_t u8Slot;
+
+	for (u8Slot = 0; u8Slot < GSERVER_MAXLISTEN; u8Slot++)
+	{
+		if (srv->listenFd[u8Slot] < 0)
+		{
+			break;
+		}
+	}
+	if (u8Slot >= GSERVER_MAXLISTEN)
+	{
+		close(fd);
+		errno = ENOSPC;
+		return -1;
+	}
+	if (listen(fd, SOMAXCONN) < 0)
+	{
+		close(fd);
+		return -1;
+	}
+
+	// Listening sockets are told apart from connections by their slot address
+	sEvent.events = EPOLLIN;
+	sEvent.data.ptr = &srv->listenFd[u8Slot];
+	if (epoll_ctl(srv->epfd, EPOLL_CTL_ADD, fd, &sEvent) < 0)
+	{
+		close(fd);
+		return -1;
+	}
+	srv->listenFd[u8Slot] = fd;
+	return 0;
+}
+
+int gserver_init(gserver_t *srv)
+{
+	uint8_t u8Slot;
+
+	memset(srv, 0, sizeof(gserver_t));
+	for (u8Slot = 0; u8Slot < GSERVER_MAXLISTEN; u8Slot++)
+	{
+		srv->listenFd[u8Slot] = -1;
+	}
+	srv->epfd = epoll_create1(EPOLL_CLOEXEC);
+	return (srv->epfd < 0) ? -1 : 0;
+}
+
+int gserver_listenTcp(gserver_t *srv, const char *host, uint16_t port)
+{
+	struct sockaddr_in sAddr;
+	int iOne = 1;
+	int fd;
+
+	memset(&sAddr, 0, sizeof(sAddr));
+	sAddr.sin_family = AF_INET;
+	sAddr.sin_port = htons(port);
+	sAddr.sin_addr.s_addr = htonl(INADDR_ANY);
+	if ((host != NULL) && (inet_pton(AF_INET, host, &sAddr.sin_addr) != 1))
+	{
+		errno = EINVAL;
+		return -1;
+	}
+
+	fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+	{
+		return -1;
+	}
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &iOne, sizeof(iOne));
+	if (bind(fd, (struct sockaddr *)&sAddr, sizeof(sAddr)) < 0)
+	{
+		close(fd);
+		return -1;
+	}
+	return _gserver_listen(srv, fd);
+}
+
+int gserver_listenUnix(gserver_t *srv, const char *path)
+{
+	struct sockaddr_un sAddr;
+	int fd;
+
+	if (strlen(path) >= sizeof(sAddr.sun_path))
+	{
+		errno = ENAMETOOLONG;
+		return -1;
+	}
+	memset(&sAddr, 0, sizeof(sAddr));
+	sAddr.sun_family = AF_UNIX;
+	strcpy(sAddr.sun_path, path);
+
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+	{
+		return -1;
+	}
+	unlink(path);
+	if (bind(fd, (struct sockaddr *)&sAddr, sizeof(sAddr)) < 0)
+	{
+		close(fd);
+		return -1;
+	}
+	if (_gserver_listen(srv, fd) < 0)
+	{
+		unlink(path);
+		return -1;
+	}
+	strcpy(srv->unixPath, path);
+	return 0;
+}
+
+int gserver_run(gserver_t *srv, int timeoutMs)
+{
+	struct epoll_event sEvents[GSERVER_MAXEVENTS];
+	gserver_conn_t *conn;
+	gserver_conn_t *next;
+	int iCount;
+	int i;
+
+	iCount = epoll_wait(srv->epfd, sEvents, GSERVER_MAXEVENTS, _gserver_timeout(srv, timeoutMs));
+	if (iCount < 0)
+	{
+		return (errno == EINTR) ? 0 : -1;
+	}
+
+	for (i = 0; i < iCount; i++)
+	{
+		if ((sEvents[i].data.ptr >= (void *)&srv->listenFd[0]) &&
+			(sEvents[i].data.ptr <= (void *)&srv->listenFd[GSERVER_MAXLISTEN - 1]))
+		{
+			_gserver_accept(srv, *(int *)sEvents[i].data.ptr);
+			continue;
+		}
+
+		conn = (gserver_conn_t *)sEvents[i].data.ptr;
+		if (sEvents[i].events & EPOLLERR)
+		{
+			_gserver_freeConn(srv, conn);
+			continue;
+		}
+		if ((sEvents[i].events & (EPOLLIN | EPOLLHUP)) && !conn->waitOut && !conn->closing)
+		{
+			if (_gserver_input(srv, conn) < 0)
+			{
+				_gserver_freeConn(srv, conn);
+				continue;
+			}
+		}
+
+		// One write for everything the input produced
+		_gserver_flush(conn);
+		if (conn->closing && (conn->outLen == 0))
+		{
+			_gserver_freeConn(srv, conn);
+			continue;
+		}
+		_gserver_updateEvents(conn);
+	}
+
+	// Scheduled work of every session. No input event may follow, so its output is
+	// written right away. Sessions not taking their output are left alone meanwhile
+	for (conn = srv->conns; conn != NULL; conn = next)
+	{
+		next = conn->next;
+		if (conn->closing || conn->waitOut)
+		{
+			continue;
+		}
+		_gserver_poll(srv, conn);
+		_gserver_flush(conn);
+		if (conn->closing && (conn->outLen == 0))
+		{
+			_gserver_freeConn(srv, conn);
+			continue;
+		}
+		_gserver_updateEvents(conn);
+	}
+	return iCount;
+}
+
+void gserver_closeConn(gserver_conn_t *conn)
+{
+	// Picked up by gserver_run once the output has been written
+	conn->closing = 1;
+	_gserver_updateEvents(conn);
+}
+
+void gserver_close(gserver_t *srv)
+{
+	uint8_t u8Slot;
+
+	while (srv->conns != NULL)
+	{
+		_gserver_flush(srv->conns);
+		_gserver_freeConn(srv, srv->conns);
+	}
+	for (u8Slot = 0; u8Slot < GSERVER_MAXLISTEN; u8Slot++)
+	{
+		if (srv->listenFd[u8Slot] >= 0)
+		{
+			close(srv->listenFd[u8Slot]);
+			srv->listenFd[u8Slot] = -1;
+		}
+	}
+	if (srv->unixPath[0] != '\0')
+	{
+		unlink(srv->unixPath);
+		srv->unixPath[0] = '\0';
+	}
+	if (srv->epfd >= 0)
+	{
+		close(srv->epfd);
+		srv->epfd = -1;
+	}
+}
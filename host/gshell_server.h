@@ -0,0 +1,148 @@
+/**
+ * @file gshell_server.h
+ * @brief Multi-session gshell server for Linux hosts
+ *
+ * Serves gshell over TCP and / or Unix sockets, each connection getting its
+ * own terminal session (input buffer, prompt, terminal profile) while all of
+ * them share the registered commands. Everything runs in a single epoll loop:
+ * input is read and processed in chunks, the output of a connection is
+ * collected in its own buffer and written out once per loop iteration.
+ * A connection that doesn't read its output fast enough isn't read from
+ * until the output buffer has drained.
+ *
+ * Requires \a G_ENABLE_SESSIONS to be enabled in gshell.h. Use as followed:
+ *
+ * static gserver_t sServer;
+ * gshell_init(&stdout_putchar, &millis);
+ * gserver_init(&sServer);
+ * gserver_listenTcp(&sServer, "127.0.0.1", 2323);
+ * gserver_listenUnix(&sServer, "/run/gshell.sock");
+ * while (1)
+ * {
+ *	gserver_run(&sServer, 100);
+ * }
+ *
+ * Log messages go to the session selected at that time: the connection while
+ * a command of it is executed, otherwise the default session of gshell_init.
+ *
+ * \author gfcwfzkm
+ * \copyright GNU Lesser General Public License v2.1
+ */
+#ifndef GSHELL_SERVER_H_
+#define GSHELL_SERVER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "../gshell.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef GSERVER_OUTBUF
+	#define GSERVER_OUTBUF		8192	/**< Output buffer size per connection */
+#endif
+#ifndef GSERVER_READBUF
+	#define GSERVER_READBUF		4096	/**< Input chunk size read at once */
+#endif
+#define GSERVER_MAXLISTEN		2		/**< Amount of listening sockets per server */
+#define GSERVER_MAXEVENTS		64		/**< epoll events handled per loop iteration */
+
+struct gserver;
+
+/**
+ * @brief Client connection, one terminal session each
+ */
+typedef struct gserver_conn {
+	int fd;							/**< Socket of the connection */
+	struct gserver *server;			/**< Server the connection belongs to */
+	gshell_session_t session;		/**< gshell terminal session of the connection */
+	uint32_t outLen;				/**< Amount of bytes waiting in out */
+	uint32_t dropped;				/**< Bytes dropped as the output buffer was full */
+	uint32_t events;				/**< epoll events currently registered */
+	uint8_t closing:1;				/**< Close once the output has been written */
+	uint8_t waitOut:1;				/**< Input paused until the output has drained */
+	void *user;						/**< Free to use by the application */
+	struct gserver_conn *prev;
+	struct gserver_conn *next;
+	char out[GSERVER_OUTBUF];		/**< Output buffer */
+} gserver_conn_t;
+
+/**
+ * @brief Server object
+ */
+typedef struct gserver {
+	int epfd;									/**< epoll instance */
+	int listenFd[GSERVER_MAXLISTEN];			/**< Listening sockets, -1 if unused */
+	char unixPath[108];							/**< Path of the Unix socket, removed on close */
+	gserver_conn_t *conns;						/**< List of open connections */
+	uint32_t connCount;							/**< Amount of open connections */
+	/** Called after a new connection has been set up (session selected), optional */
+	void (*onConnect)(gserver_conn_t *conn);
+	/** Called when a command returned a value (session selected), return non-zero to close the connection */
+	uint8_t (*onResult)(gserver_conn_t *conn, const gshell_result_t *result);
+	/** Called before a connection is freed, optional */
+	void (*onClose)(gserver_conn_t *conn);
+} gserver_t;
+
+/**
+ * @brief Initialise the server object
+ *
+ * Call after \a gshell_init , set the callbacks afterwards if required.
+ *
+ * @param srv	Server object
+ * @return		0 on success, -1 on error (errno is set)
+ */
+int gserver_init(gserver_t *srv);
+
+/**
+ * @brief Listen on a TCP port
+ *
+ * @param srv	Server object
+ * @param host	Numeric IPv4 address to bind to, NULL for all addresses
+ * @param port	TCP port
+ * @return		0 on success, -1 on error (errno is set)
+ */
+int gserver_listenTcp(gserver_t *srv, const char *host, uint16_t port);
+
+/**
+ * @brief Listen on a Unix socket, a existing socket file is replaced
+ *
+ * @param srv	Server object
+ * @param path	Path of the socket file
+ * @return		0 on success, -1 on error (errno is set)
+ */
+int gserver_listenUnix(gserver_t *srv, const char *path);
+
+/**
+ * @brief Waits for and handles socket events
+ *
+ * Afterwards the scheduled work ( \a gshell_poll ) of every session is run, with
+ * that session selected, and its output written.
+ *
+ * @param srv		Server object
+ * @param timeoutMs	Maximum time to wait in milliseconds, -1 to wait forever. Shortened to
+ *					the \a gshell_nextDeadline of the sessions, so scheduled work runs in time
+ * @return			Amount of handled events, -1 on error
+ */
+int gserver_run(gserver_t *srv, int timeoutMs);
+
+/**
+ * @brief Closes a connection once its pending output has been written
+ *
+ * @param conn	Connection to close
+ */
+void gserver_closeConn(gserver_conn_t *conn);
+
+/**
+ * @brief Closes all connections and listening sockets
+ *
+ * @param srv	Server object
+ */
+void gserver_close(gserver_t *srv);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GSHELL_SERVER_H_
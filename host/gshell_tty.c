@@ -0,0 +1,258 @@
+/**
+ * @file gshell_tty.c
+ * @brief Raw terminal / serial port driver for Linux hosts
+ * @author gfcwfzkm
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "gshell_tty.h"
+
+/* Terminal used by gtty_putChar */
+static gtty_t *psActive = NULL;
+
+/* Supported baudrates */
+static const struct {
+	uint32_t baud;
+	speed_t speed;
+} baudTable[] = {
+	{9600, B9600}, {19200, B19200}, {38400, B38400}, {57600, B57600}, {115200, B115200},
+	{230400, B230400}, {460800, B460800}, {500000, B500000}, {921600, B921600},
+	{1000000, B1000000}, {2000000, B2000000}, {3000000, B3000000}, {4000000, B4000000}
+};
+
+/* Saves the terminal settings and switches to raw mode */
+static int _gtty_makeRaw(gtty_t *tty, uint8_t bKeepSignals, uint32_t baud)
+{
+	struct termios sRaw;
+	uint8_t u8Idx;
+
+	if (tcgetattr(tty->inFd, &tty->saved) < 0)
+	{
+		return -1;
+	}
+	sRaw = tty->saved;
+	cfmakeraw(&sRaw);
+	if (bKeepSignals)
+	{
+		sRaw.c_lflag |= ISIG;
+	}
+#ifndef G_CR_INSTEADOF_LF
+	// Terminals send CR on enter, gshell waits for LF
+	sRaw.c_iflag |= ICRNL;
+#endif
+	sRaw.c_cflag |= CLOCAL | CREAD;
+	sRaw.c_cc[VMIN] = 1;
+	sRaw.c_cc[VTIME] = 0;
+
+	if (baud != 0)
+	{
+		for (u8Idx = 0; u8Idx < sizeof(baudTable) / sizeof(baudTable[0]); u8Idx++)
+		{
+			if (baudTable[u8Idx].baud == baud)
+			{
+				break;
+			}
+		}
+		if (u8Idx >= sizeof(baudTable) / sizeof(baudTable[0]))
+		{
+			errno = EINVAL;
+			return -1;
+		}
+		cfsetispeed(&sRaw, baudTable[u8Idx].speed);
+		cfsetospeed(&sRaw, baudTable[u8Idx].speed);
+	}
+
+	if (tcsetattr(tty->inFd, TCSANOW, &sRaw) < 0)
+	{
+		return -1;
+	}
+	tty->restore = 1;
+	return 0;
+}
+
+/* Shortens the wait to the next scheduled work of gshell */
+static int _gtty_timeout(int timeoutMs)
+{
+	uint32_t u32Deadline = gshell_nextDeadline();
+
+	if ((u32Deadline != GSHELL_NODEADLINE) && ((timeoutMs < 0) || (u32Deadline < (uint32_t)timeoutMs)))
+	{
+		return (u32Deadline > INT_MAX) ? INT_MAX : (int)u32Deadline;
+	}
+	return timeoutMs;
+}
+
+int gtty_openStdio(gtty_t *tty)
+{
+	memset(tty, 0, sizeof(gtty_t));
+	tty->inFd = STDIN_FILENO;
+	tty->outFd = STDOUT_FILENO;
+	tty->wakeFd = -1;
+
+	// Pipes and files are used as they are
+	if (isatty(tty->inFd) && (_gtty_makeRaw(tty, 1, 0) < 0))
+	{
+		return -1;
+	}
+	psActive = tty;
+	return 0;
+}
+
+int gtty_openDevice(gtty_t *tty, const char *path, uint32_t baud)
+{
+	memset(tty, 0, sizeof(gtty_t));
+	tty->inFd = open(path, O_RDWR | O_NOCTTY | O_CLOEXEC);
+	if (tty->inFd < 0)
+	{
+		return -1;
+	}
+	tty->outFd = tty->inFd;
+	tty->wakeFd = -1;
+	tty->ownsFd = 1;
+
+	if (_gtty_makeRaw(tty, 0, baud) < 0)
+	{
+		close(tty->inFd);
+		return -1;
+	}
+	psActive = tty;
+	return 0;
+}
+
+void gtty_putChar(char c)
+{
+	if (psActive == NULL)
+	{
+		return;
+	}
+	if (psActive->outLen >= GTTY_OUTBUF)
+	{
+		gtty_flush(psActive);
+	}
+	psActive->outBuf[psActive->outLen++] = c;
+}
+
+int gtty_flush(gtty_t *tty)
+{
+	struct pollfd sPoll;
+	uint32_t u32Sent = 0;
+	ssize_t iWritten;
+
+	while (u32Sent < tty->outLen)
+	{
+		iWritten = write(tty->outFd, tty->outBuf + u32Sent, tty->outLen - u32Sent);
+		if (iWritten < 0)
+		{
+			if (errno == EINTR)
+			{
+				continue;
+			}
+			if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+			{
+				// Non-blocking descriptor, wait until the device takes more
+				sPoll.fd = tty->outFd;
+				sPoll.events = POLLOUT;
+				poll(&sPoll, 1, -1);
+				continue;
+			}
+			tty->outLen = 0;
+			return -1;
+		}
+		u32Sent += (uint32_t)iWritten;
+	}
+	tty->outLen = 0;
+	return 0;
+}
+
+int gtty_run(gtty_t *tty, int timeoutMs, gshell_result_t *result)
+{
+	struct pollfd sPoll[2];
+	ssize_t iRead;
+	uint16_t u16Used;
+	int iRet;
+
+	// Scheduled work of the terminal first ('watch' / 'repeat', deferred promt)
+	if (gshell_poll(result) == GSHELL_CMDRET)
+	{
+#ifdef G_ENABLE_TXQUEUES
+		gshell_txDrain(0);
+#endif
+		return (gtty_flush(tty) < 0) ? -1 : 1;
+	}
+
+	// Output produced since the last call (logging) goes out before waiting
+#ifdef G_ENABLE_TXQUEUES
+	gshell_txDrain(0);
+#endif
+	if (gtty_flush(tty) < 0)
+	{
+		return -1;
+	}
+
+	if (tty->inPos >= tty->inLen)
+	{
+		sPoll[0].fd = tty->inFd;
+		sPoll[0].events = POLLIN;
+		sPoll[0].revents = 0;
+		sPoll[1].fd = tty->wakeFd;
+		sPoll[1].events = POLLIN;
+		iRet = poll(sPoll, (tty->wakeFd >= 0) ? 2 : 1, _gtty_timeout(timeoutMs));
+		if (iRet <= 0)
+		{
+			return ((iRet == 0) || (errno == EINTR)) ? 0 : -1;
+		}
+		if (sPoll[0].revents == 0)
+		{
+			// Woken up by wakeFd, the caller has something else to do
+			return 0;
+		}
+
+		// Take everything available at once
+		iRead = read(tty->inFd, tty->inBuf, GTTY_INBUF);
+		if (iRead <= 0)
+		{
+			return ((iRead < 0) && ((errno == EINTR) || (errno == EAGAIN))) ? 0 : -1;
+		}
+		tty->inPos = 0;
+		tty->inLen = (uint16_t)iRead;
+	}
+
+	iRet = (gshell_processShellBuffer(tty->inBuf + tty->inPos, tty->inLen - tty->inPos, &u16Used, result) == GSHELL_CMDRET);
+	tty->inPos += u16Used;
+
+	// One write for the echo and output of the whole chunk
+#ifdef G_ENABLE_TXQUEUES
+	gshell_txDrain(0);
+#endif
+	if (gtty_flush(tty) < 0)
+	{
+		return -1;
+	}
+	return iRet;
+}
+
+void gtty_close(gtty_t *tty)
+{
+	gtty_flush(tty);
+	if (tty->restore)
+	{
+		tcsetattr(tty->inFd, TCSADRAIN, &tty->saved);
+		tty->restore = 0;
+	}
+	if (tty->ownsFd)
+	{
+		close(tty->inFd);
+		tty->ownsFd = 0;
+	}
+	if (psActive == tty)
+	{
+		psActive = NULL;
+	}
+}
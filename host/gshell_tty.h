@@ -0,0 +1,123 @@
+/**
+ * @file gshell_tty.h
+ * @brief Raw terminal / serial port driver for Linux hosts
+ *
+ * Runs gshell on the controlling terminal or on a serial device (/dev/ttyUSB0,
+ * a pty, ...). The device is put into raw mode with termios, received bytes
+ * are read in chunks whenever poll reports them and passed over to
+ * \a gshell_processShellBuffer . The output of gshell is collected and sent
+ * with a single write once the input has been processed (or the buffer is full).
+ *
+ * Only one terminal per program, as the gshell output function has no context.
+ * Use as followed:
+ *
+ * static gtty_t sTty;
+ * gshell_result_t sResult;
+ * gtty_openStdio(&sTty);				// or gtty_openDevice(&sTty, "/dev/ttyUSB0", 115200)
+ * gshell_init(&gtty_putChar, &millis);
+ * gshell_setPromt(1);
+ * while (gtty_run(&sTty, -1, &sResult) >= 0)
+ * {
+ *	// Command returned a value if gtty_run returned 1
+ * }
+ * gtty_close(&sTty);
+ *
+ * \author gfcwfzkm
+ * \copyright GNU Lesser General Public License v2.1
+ */
+#ifndef GSHELL_TTY_H_
+#define GSHELL_TTY_H_
+
+#include <stdint.h>
+#include <termios.h>
+#include "../gshell.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef GTTY_OUTBUF
+	#define GTTY_OUTBUF		4096	/**< Output buffer size, written at once */
+#endif
+#ifndef GTTY_INBUF
+	#define GTTY_INBUF		1024	/**< Input chunk size read at once */
+#endif
+
+/**
+ * @brief Terminal object
+ */
+typedef struct gtty {
+	int inFd;					/**< Input file descriptor */
+	int outFd;					/**< Output file descriptor, may be the same as inFd */
+	int wakeFd;					/**< Additional descriptor ending the wait once readable (e.g. gworker_fd), -1 if unused */
+	uint8_t ownsFd:1;			/**< File descriptor opened by gtty_openDevice */
+	uint8_t restore:1;			/**< Saved terminal settings have to be restored */
+	struct termios saved;		/**< Terminal settings before switching to raw mode */
+	uint16_t inPos;				/**< Position of the unprocessed input in inBuf */
+	uint16_t inLen;				/**< Amount of valid bytes in inBuf */
+	uint32_t outLen;			/**< Amount of bytes waiting in outBuf */
+	char inBuf[GTTY_INBUF];		/**< Received bytes, processed until a command has been executed */
+	char outBuf[GTTY_OUTBUF];	/**< Output waiting to be written */
+} gtty_t;
+
+/**
+ * @brief Use stdin / stdout as terminal
+ *
+ * Switches stdin into raw mode if it is a terminal. Ctrl-C still sends SIGINT.
+ *
+ * @param tty	Terminal object
+ * @return		0 on success, -1 on error (errno is set)
+ */
+int gtty_openStdio(gtty_t *tty);
+
+/**
+ * @brief Open a serial device as terminal
+ *
+ * @param tty	Terminal object
+ * @param path	Path of the device
+ * @param baud	Baudrate, 0 to keep the current one
+ * @return		0 on success, -1 on error (errno is set, EINVAL for a unsupported baudrate)
+ */
+int gtty_openDevice(gtty_t *tty, const char *path, uint32_t baud);
+
+/**
+ * @brief Output function for \a gshell_init
+ */
+void gtty_putChar(char c);
+
+/**
+ * @brief Writes the buffered output
+ *
+ * @param tty	Terminal object
+ * @return		0 on success, -1 on error
+ */
+int gtty_flush(gtty_t *tty);
+
+/**
+ * @brief Waits for input and processes it
+ *
+ * Runs the scheduled work of gshell ( \a gshell_poll ), writes pending output, waits
+ * up to \a timeoutMs for input and passes all of it over to gshell. Stops after a
+ * executed command, the remaining input is processed on the next call without
+ * waiting. Returns 0 right away if \a wakeFd becomes readable.
+ *
+ * @param tty		Terminal object
+ * @param timeoutMs	Maximum time to wait in milliseconds, -1 to wait forever. Shortened to
+ *					\a gshell_nextDeadline , so scheduled work runs in time
+ * @param result	Filled in if a command returned a value
+ * @return			1 if a command returned a value, 0 if not, -1 on error or end of input
+ */
+int gtty_run(gtty_t *tty, int timeoutMs, gshell_result_t *result);
+
+/**
+ * @brief Writes the pending output and restores the terminal settings
+ *
+ * @param tty	Terminal object
+ */
+void gtty_close(gtty_t *tty);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GSHELL_TTY_H_
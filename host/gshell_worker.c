@@ -0,0 +1,386 @@
+/**
+ * @file gshell_worker.c
+ * @brief Worker thread pool for blocking commands on Linux hosts
+ * @author gfcwfzkm
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "gshell_worker.h"
+
+/* Pool used by the gshell dispatcher, which has no context */
+static gworker_pool_t *psPool = NULL;
+
+/* Lock of the log sinks and history, shared by all threads */
+static pthread_mutex_t sLogLock = PTHREAD_MUTEX_INITIALIZER;
+
+static void _gworker_logLock(uint8_t acquire)
+{
+	if (acquire)
+	{
+		pthread_mutex_lock(&sLogLock);
+	}
+	else
+	{
+		pthread_mutex_unlock(&sLogLock);
+	}
+}
+
+/* Tells the input thread that output or a result waits, pool locked */
+static void _gworker_wake(gworker_pool_t *pool)
+{
+	uint64_t u64One = 1;
+
+	(void)(write(pool->wakeFd, &u64One, sizeof(u64One)) < 0);
+}
+
+/* Moves the collected line into the job output, waits while the output is full */
+static void _gworker_flushLine(gworker_job_t *job)
+{
+	gworker_pool_t *pool = psPool;
+	uint16_t u16Pos = 0;
+	uint32_t u32Len;
+
+	pthread_mutex_lock(&pool->lock);
+	while (u16Pos < job->lineLen)
+	{
+		if (job->outLen >= GWORKER_OUTBUF)
+		{
+			if (pool->stop)
+			{
+				// Nobody is going to print it anymore
+				break;
+			}
+			_gworker_wake(pool);
+			pthread_cond_wait(&pool->drained, &pool->lock);
+			continue;
+		}
+		u32Len = job->lineLen - u16Pos;
+		if (u32Len > GWORKER_OUTBUF - job->outLen)
+		{
+			u32Len = GWORKER_OUTBUF - job->outLen;
+		}
+		memcpy(job->out + job->outLen, job->line + u16Pos, u32Len);
+		job->outLen += u32Len;
+		u16Pos += (uint16_t)u32Len;
+	}
+	_gworker_wake(pool);
+	pthread_mutex_unlock(&pool->lock);
+	job->lineLen = 0;
+}
+
+/* gshell output function of all jobs, the session selected by the worker tells which one */
+static void _gworker_putChar(char c)
+{
+	gworker_job_t *job = (gworker_job_t *)gshell_sessionGet()->user;
+
+	job->line[job->lineLen++] = c;
+	if ((c == '\n') || (job->lineLen >= GWORKER_LINEBUF))
+	{
+		_gworker_flushLine(job);
+	}
+}
+
+static void *_gworker_thread(void *arg)
+{
+	gworker_pool_t *pool = (gworker_pool_t *)arg;
+	gworker_job_t *job;
+	uint8_t u8Value;
+#ifdef G_ENABLE_RESULTQUEUE
+	uint32_t u32Result;
+	uint8_t u8Posted;
+#endif
+
+	pthread_mutex_lock(&pool->lock);
+	while (1)
+	{
+		for (job = pool->jobs; job != NULL; job = job->next)
+		{
+			if (job->state == GWORKER_QUEUED)
+			{
+				break;
+			}
+		}
+		if (job == NULL)
+		{
+			if (pool->stop)
+			{
+				break;
+			}
+			pthread_cond_wait(&pool->work, &pool->lock);
+			continue;
+		}
+		job->state = GWORKER_RUNNING;
+		pthread_mutex_unlock(&pool->lock);
+
+		// All output of this thread goes into the job
+		gshell_sessionSelect(&job->session);
+		u8Value = gshell_runCmd(job->cmd, job->argc, job->argv);
+#ifdef G_ENABLE_RESULTQUEUE
+		// Thread-local, picked up here and queued by gworker_poll on the input thread
+		u8Posted = gshell_resultPosted(&u32Result);
+#endif
+#ifdef G_ENABLE_TXQUEUES
+		gshell_txDrain(0);
+#endif
+		if (job->lineLen > 0)
+		{
+			_gworker_flushLine(job);
+		}
+		gshell_sessionSelect(NULL);
+
+		pthread_mutex_lock(&pool->lock);
+		job->value = u8Value;
+#ifdef G_ENABLE_RESULTQUEUE
+		job->resultPosted = u8Posted;
+		job->result = u32Result;
+#endif
+		job->state = GWORKER_DONE;
+		_gworker_wake(pool);
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return NULL;
+}
+
+/* gshell dispatcher, called on the input thread with the session of the command selected */
+static uint8_t _gworker_dispatch(const gshell_cmd_t *cmd, int16_t cmdID, uint8_t argc, char *argv[])
+{
+	gworker_pool_t *pool = psPool;
+	gworker_job_t *job;
+	gworker_job_t **ppsTail;
+	uint16_t u16Pos = 0;
+	uint8_t u8_cnt;
+#ifdef G_ENABLE_TERMPROFILES
+	enum gshell_termprofile eProfile = gshell_getTermProfile();
+#endif
+
+	if ((pool == NULL) || (pool->jobCount >= GWORKER_MAXJOBS))
+	{
+		return 0;
+	}
+	job = calloc(1, sizeof(gworker_job_t));
+	if (job == NULL)
+	{
+		return 0;
+	}
+
+	// The arguments point into the input buffer, which is reused right away
+	for (u8_cnt = 0; (u8_cnt < argc) && (u8_cnt < G_MAX_ARGS); u8_cnt++)
+	{
+		uint16_t u16Len = (uint16_t)strlen(argv[u8_cnt]) + 1;
+
+		if (u16Pos + u16Len > G_RX_BUFSIZE)
+		{
+			break;
+		}
+		memcpy(job->args + u16Pos, argv[u8_cnt], u16Len);
+		job->argv[u8_cnt] = job->args + u16Pos;
+		u16Pos += u16Len;
+	}
+	job->argc = u8_cnt;
+	job->cmd = cmd;
+	job->cmdID = cmdID;
+	job->origin = gshell_sessionGet();
+
+	// Prompt stays off, so every log message of the job ends with a newline
+	gshell_sessionInit(&job->session, _gworker_putChar);
+	job->session.user = job;
+#ifdef G_ENABLE_TERMPROFILES
+	gshell_sessionSelect(&job->session);
+	gshell_setTermProfile(eProfile);
+	gshell_sessionSelect(job->origin);
+#endif
+
+	pthread_mutex_lock(&pool->lock);
+	for (ppsTail = &pool->jobs; *ppsTail != NULL; ppsTail = &(*ppsTail)->next);
+	*ppsTail = job;
+	pool->jobCount++;
+	pthread_cond_signal(&pool->work);
+	pthread_mutex_unlock(&pool->lock);
+	return 1;
+}
+
+int gworker_start(gworker_pool_t *pool, uint8_t threads)
+{
+	uint8_t u8_cnt;
+
+	if ((threads == 0) || (threads > GWORKER_MAXTHREADS) || (psPool != NULL))
+	{
+		errno = EINVAL;
+		return -1;
+	}
+	memset(pool, 0, sizeof(gworker_pool_t));
+	pool->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (pool->wakeFd < 0)
+	{
+		return -1;
+	}
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->work, NULL);
+	pthread_cond_init(&pool->drained, NULL);
+	psPool = pool;
+
+	for (u8_cnt = 0; u8_cnt < threads; u8_cnt++)
+	{
+		if (pthread_create(&pool->threads[u8_cnt], NULL, _gworker_thread, pool) != 0)
+		{
+			break;
+		}
+		pool->threadCount++;
+	}
+	if (pool->threadCount == 0)
+	{
+		gworker_stop(pool);
+		errno = EAGAIN;
+		return -1;
+	}
+
+	gshell_setLock(_gworker_logLock);
+	gshell_setDispatcher(_gworker_dispatch);
+	return 0;
+}
+
+int gworker_fd(gworker_pool_t *pool)
+{
+	return pool->wakeFd;
+}
+
+int gworker_poll(gworker_pool_t *pool, gshell_result_t *result)
+{
+	char cBuf[GWORKER_OUTBUF + sizeof(G_CRLF)];
+	gshell_session_t *psOrigin;
+	gshell_session_t *psPrevious;
+	gworker_job_t **ppsJob;
+	gworker_job_t *job;
+	uint64_t u64Count;
+	uint32_t u32Len;
+	uint8_t bDone;
+
+	pthread_mutex_lock(&pool->lock);
+	(void)(read(pool->wakeFd, &u64Count, sizeof(u64Count)) < 0);
+
+	ppsJob = &pool->jobs;
+	while ((job = *ppsJob) != NULL)
+	{
+		bDone = (job->state == GWORKER_DONE);
+
+		// Complete lines only, unless the job is done or its output full
+		for (u32Len = job->outLen; (u32Len > 0) && (job->out[u32Len - 1] != '\n'); u32Len--);
+		if (bDone || (job->outLen >= GWORKER_OUTBUF))
+		{
+			u32Len = job->outLen;
+		}
+
+		if (u32Len > 0)
+		{
+			memcpy(cBuf, job->out, u32Len);
+			memmove(job->out, job->out + u32Len, job->outLen - u32Len);
+			job->outLen -= u32Len;
+			if (cBuf[u32Len - 1] != '\n')
+			{
+				memcpy(cBuf + u32Len, G_CRLF, sizeof(G_CRLF) - 1);
+				u32Len += sizeof(G_CRLF) - 1;
+			}
+			cBuf[u32Len] = '\0';
+			psOrigin = job->origin;
+			pthread_cond_broadcast(&pool->drained);
+
+			// Printing may take a while, the workers go on meanwhile
+			pthread_mutex_unlock(&pool->lock);
+			if (psOrigin != NULL)
+			{
+				psPrevious = gshell_sessionSelect(psOrigin);
+				gshell_putStringAsync(cBuf);
+#ifdef G_ENABLE_TXQUEUES
+				gshell_txDrain(0);
+#endif
+				gshell_sessionSelect(psPrevious);
+			}
+			pthread_mutex_lock(&pool->lock);
+			continue;
+		}
+
+		if (!bDone)
+		{
+			ppsJob = &job->next;
+			continue;
+		}
+
+		// Output printed, report the result like gshell_processShellEx does
+		*ppsJob = job->next;
+		pool->jobCount--;
+#ifdef G_ENABLE_RESULTQUEUE
+		if (job->origin != NULL)
+		{
+			gshell_resultReport(job->cmdID, job->value, job->result, job->resultPosted);
+		}
+#endif
+		if ((job->value != 0) && (job->origin != NULL))
+		{
+			result->cmdID = job->cmdID;
+			result->value = job->value;
+			free(job);
+			// There may be more, keep the descriptor readable
+			_gworker_wake(pool);
+			pthread_mutex_unlock(&pool->lock);
+			return 1;
+		}
+		free(job);
+	}
+	pthread_mutex_unlock(&pool->lock);
+	return 0;
+}
+
+void gworker_cancelSession(gworker_pool_t *pool, gshell_session_t *session)
+{
+	gworker_job_t *job;
+
+	pthread_mutex_lock(&pool->lock);
+	for (job = pool->jobs; job != NULL; job = job->next)
+	{
+		if (job->origin == session)
+		{
+			job->origin = NULL;
+		}
+	}
+	pthread_mutex_unlock(&pool->lock);
+}
+
+void gworker_stop(gworker_pool_t *pool)
+{
+	gworker_job_t *job;
+	uint8_t u8_cnt;
+
+	gshell_setDispatcher(NULL);
+
+	pthread_mutex_lock(&pool->lock);
+	pool->stop = 1;
+	pthread_cond_broadcast(&pool->work);
+	pthread_cond_broadcast(&pool->drained);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (u8_cnt = 0; u8_cnt < pool->threadCount; u8_cnt++)
+	{
+		pthread_join(pool->threads[u8_cnt], NULL);
+	}
+	pool->threadCount = 0;
+	gshell_setLock(NULL);
+
+	while ((job = pool->jobs) != NULL)
+	{
+		pool->jobs = job->next;
+		free(job);
+	}
+	pool->jobCount = 0;
+	pthread_mutex_destroy(&pool->lock);
+	pthread_cond_destroy(&pool->work);
+	pthread_cond_destroy(&pool->drained);
+	close(pool->wakeFd);
+	pool->wakeFd = -1;
+	psPool = NULL;
+}
@@ -0,0 +1,168 @@
+/**
+ * @file gshell_worker.h
+ * @brief Worker thread pool for blocking commands on Linux hosts
+ *
+ * Commands with \a blocking set are queued as jobs and executed by a small pool
+ * of threads, while the input thread goes on accepting and editing commands.
+ * The output of a job is collected in its own buffer and passed line by line to
+ * the session the command was entered on, above the prompt. Once the command
+ * returned, its value is reported by \a gworker_poll with the command ID, just
+ * like \a gshell_processShellEx does for the other commands. With
+ * \a G_ENABLE_RESULTQUEUE , \a gworker_poll also queues its completion record,
+ * including a value posted by \a gshell_setResult on the worker.
+ *
+ * Requires \a G_ENABLE_WORKERS (and thus \a G_ENABLE_SESSIONS ) to be enabled in
+ * gshell.h. Only one pool per program, use as followed:
+ *
+ * static gworker_pool_t sPool;
+ * static gshell_cmd_t sSelfTest = {"selftest", cmd_selftest, "Runs the self-test", NULL, 1};
+ * gshell_init(&gtty_putChar, &millis);
+ * gshell_register_cmd(&sSelfTest);
+ * gworker_start(&sPool, 4);
+ * sTty.wakeFd = gworker_fd(&sPool);		// Wakes gtty_run once a job has output
+ * while (gtty_run(&sTty, -1, &sResult) >= 0)
+ * {
+ *	while (gworker_poll(&sPool, &sResult))
+ *	{
+ *		// Blocking command returned a value
+ *	}
+ * }
+ * gworker_stop(&sPool);
+ *
+ * Jobs may print and log, but must not change the gshell configuration or the
+ * command list. Log sinks and the log history are locked by the pool.
+ *
+ * \author gfcwfzkm
+ * \copyright GNU Lesser General Public License v2.1
+ */
+#ifndef GSHELL_WORKER_H_
+#define GSHELL_WORKER_H_
+
+#include <pthread.h>
+#include <stdint.h>
+#include "../gshell.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef G_ENABLE_WORKERS
+	#error "gshell_worker requires G_ENABLE_WORKERS to be enabled in gshell.h"
+#endif
+
+#ifndef GWORKER_OUTBUF
+	#define GWORKER_OUTBUF		4096	/**< Output buffer per job, the job waits while it is full */
+#endif
+#ifndef GWORKER_LINEBUF
+	#define GWORKER_LINEBUF		128		/**< Output collected by the worker before taking the lock */
+#endif
+#define GWORKER_MAXTHREADS		8		/**< Maximum amount of worker threads */
+#define GWORKER_MAXJOBS			16		/**< Queued and running jobs, further blocking commands run right away */
+
+/**
+ * @brief Job state
+ */
+enum gworker_state {
+	GWORKER_QUEUED = 0,		/**< Waiting for a free worker */
+	GWORKER_RUNNING,		/**< Executed by a worker */
+	GWORKER_DONE			/**< Command returned, output and result not picked up yet */
+};
+
+/**
+ * @brief Job, one per dispatched command. The fields are internal
+ */
+typedef struct gworker_job {
+	const gshell_cmd_t *cmd;			/**< Command to execute */
+	int16_t cmdID;						/**< ID of the command */
+	uint8_t argc;						/**< Amount of arguments */
+	uint8_t value;						/**< Return value of the command */
+#ifdef G_ENABLE_RESULTQUEUE
+	uint8_t resultPosted;				/**< gshell_setResult has been called by the command */
+	uint32_t result;					/**< Value posted by the command */
+#endif
+	uint8_t state;						/**< enum gworker_state */
+	char *argv[G_MAX_ARGS];				/**< Arguments, pointing into args */
+	char args[G_RX_BUFSIZE];			/**< Copy of the arguments */
+	gshell_session_t *origin;			/**< Session the command was entered on, NULL if cancelled */
+	gshell_session_t session;			/**< Session of the job, its output goes into out */
+	uint16_t lineLen;					/**< Amount of bytes in line */
+	uint32_t outLen;					/**< Amount of bytes in out */
+	struct gworker_job *next;
+	char line[GWORKER_LINEBUF];			/**< Output not yet moved to out, used by the worker only */
+	char out[GWORKER_OUTBUF];			/**< Output waiting to be printed */
+} gworker_job_t;
+
+/**
+ * @brief Worker pool object
+ */
+typedef struct gworker_pool {
+	pthread_t threads[GWORKER_MAXTHREADS];	/**< Worker threads */
+	uint8_t threadCount;					/**< Amount of started worker threads */
+	uint8_t stop;							/**< Workers exit once the queue is empty */
+	uint8_t jobCount;						/**< Amount of jobs in the list */
+	pthread_mutex_t lock;					/**< Protects the job list and the job output */
+	pthread_cond_t work;					/**< Signalled when a job has been queued */
+	pthread_cond_t drained;					/**< Signalled when job output has been printed */
+	gworker_job_t *jobs;					/**< Jobs in the order they were dispatched */
+	int wakeFd;								/**< eventfd, readable while output or results wait */
+} gworker_pool_t;
+
+/**
+ * @brief Start the worker threads and take over the blocking commands
+ *
+ * Call after \a gshell_init .
+ *
+ * @param pool		Pool object
+ * @param threads	Amount of worker threads, 1 to GWORKER_MAXTHREADS
+ * @return			0 on success, -1 on error (errno is set)
+ */
+int gworker_start(gworker_pool_t *pool, uint8_t threads);
+
+/**
+ * @brief Returns the descriptor to wait on for \a gworker_poll
+ *
+ * Readable as long as job output or results wait to be picked up. Add it to the
+ * poll / epoll loop, or set it as \a wakeFd of a gtty terminal.
+ *
+ * @param pool	Pool object
+ */
+int gworker_fd(gworker_pool_t *pool);
+
+/**
+ * @brief Prints the job output and reports the returned values
+ *
+ * Call from the input thread (the one calling the gshell input functions).
+ * Stops after a command that returned a value, call again until it returns 0.
+ *
+ * @param pool		Pool object
+ * @param result	Filled in if a command returned a value
+ * @return			1 if a command returned a value, 0 if not
+ */
+int gworker_poll(gworker_pool_t *pool, gshell_result_t *result);
+
+/**
+ * @brief Drop the output and results of the jobs entered on a session
+ *
+ * Call before the session is freed (e.g. within the onClose callback of gserver),
+ * the jobs themselves run to completion.
+ *
+ * @param pool		Pool object
+ * @param session	Session that is going away
+ */
+void gworker_cancelSession(gworker_pool_t *pool, gshell_session_t *session);
+
+/**
+ * @brief Waits for the queued and running jobs and stops the worker threads
+ *
+ * Output and results not picked up yet are dropped, blocking commands are
+ * executed right away afterwards.
+ *
+ * @param pool	Pool object
+ */
+void gworker_stop(gworker_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // GSHELL_WORKER_H_
@@ -4,6 +4,8 @@
  * A basic demo program to give a quick idea how the shell can be implemented
  * and interacted with. Should work on all operating systems. All of the code is
  * extensively documented.
+ *
+ * Build on Linux: gcc -o gshell_demo main.c gshell.c host/gshell_tty.c
  */
 
 #include <stdio.h>
@@ -12,32 +14,35 @@
 #include "gshell.h"
 
 /* We need an unbuffered input! For this case, conio's getch
- * is used while ncurses' getchar does the job on linux. */
+ * is used on windows, while the raw terminal driver of the host
+ * folder does the job on linux. */
 #ifdef _WIN32
 	#include <conio.h>		// Function 'getch'
 	#define get_unbuffered	getch
 #else
-	#include <curses.h>
-	#define get_unbuffered	getchar
+	#include "host/gshell_tty.h"
 #endif
 
-/* Each dynamic command is added from 1 upwards. Since the
- * way each command is added is defined, the IDs can be
- * noted down here already. Further checks could be programmed
- * to make sure our "guess" is correct, or note down each returned
- * ID during runtime.
- * ID Zero is reserved to the default help command */
-#define CMD_ID_EXIT     1
-#define CMD_ID_TEST		2
+/* Position of each command within the command array below. The command IDs
+ * are assigned during registration, after the built-in commands of gshell
+ * (help and, depending on gshell.h, dmesg, trace, ...), so the IDs returned
+ * by gshell_register_cmd are noted down rather than guessed. */
+enum {
+	CMD_EXIT = 0,
+	CMD_TEST,
+	CMD_AMOUNT
+};
 
 /* Glue-Code
  * Gshell_init expects a function to print a single character
- * back to the terminal.
+ * back to the terminal. On linux, gtty_putChar is used instead.
  */
+#ifdef _WIN32
 void glue_putchar(char ch)
 {
 	putchar(ch);
 }
+#endif
 
 /* exit-program command */
 uint8_t cli_cmd_exit(uint8_t argc, char* argv[])
@@ -68,52 +73,77 @@ uint8_t cli_cmd_test(uint8_t argc, char* argv[])
 int main()
 {
 	uint8_t u8AppRunning = 0;	// Keeps the while-loop running
-	uint16_t u16CmdRetVal;		// gshell return value
-	gshell_cmd_t gCmdArr[] = {	// gshell command structure, packed in an array
+	gshell_result_t sCmdResult;	// Result of a executed command
+	uint8_t u8CmdReturned;		// Non-zero if a command returned a value
+	int16_t i16CmdIDs[CMD_AMOUNT];	// IDs assigned to the commands of gCmdArr
+#ifndef _WIN32
+	gtty_t sTty;				// Raw terminal on stdin / stdout
+#endif
+	gshell_cmd_t gCmdArr[CMD_AMOUNT] = {	// gshell command structure, packed in an array
 		{"exit",	cli_cmd_exit,	"Exits the program and returns to the computer's console", NULL},
 		{"test",	cli_cmd_test,	"Test command, prints back all arguments", NULL},
 	};
 
 	// Initialising gshell - passing over the function pointer to print a character,
 	// - not passing over a function to get the milliseconds tick in uint32_t
+#ifdef _WIN32
 	gshell_init(&glue_putchar, NULL);
+#else
+	gtty_openStdio(&sTty);
+	gshell_init(&gtty_putChar, NULL);
+#endif
 
 	// Enabling the terminal promt
 	gshell_setPromt(1);
 
-	// Initialising all commands within the array, reporting it's ID
-	for (uint8_t u8CmdsToRegister = 0; u8CmdsToRegister < (sizeof(gCmdArr) / sizeof(gCmdArr[0])); u8CmdsToRegister++)
+	// Initialising all commands within the array, noting down and reporting it's ID
+	for (uint8_t u8CmdsToRegister = 0; u8CmdsToRegister < CMD_AMOUNT; u8CmdsToRegister++)
 	{
-		glog_info("Registered shell command '%s' with the ID %"PRIi8,
-				gCmdArr[u8CmdsToRegister].cmdName, gshell_register_cmd(&gCmdArr[u8CmdsToRegister]));
+		i16CmdIDs[u8CmdsToRegister] = gshell_register_cmd(&gCmdArr[u8CmdsToRegister]);
+		glog_info("Registered shell command '%s' with the ID %"PRIi16,
+				gCmdArr[u8CmdsToRegister].cmdName, i16CmdIDs[u8CmdsToRegister]);
 	}
 
 	glog_ok("Program initialised.");
 	while (u8AppRunning == 0)
 	{
-		// Calling gshell_processShell with the newest received character
+#ifdef _WIN32
+		// Calling gshell_processShellEx with the newest received character
 		// We need an unbuffered "getchar" function for this to work well on
 		// computers.
-		u16CmdRetVal = gshell_processShell((char)get_unbuffered());
+		u8CmdReturned = (gshell_processShellEx((char)get_unbuffered(), &sCmdResult) == GSHELL_CMDRET);
+#else
+		// Processing everything typed so far, the terminal driver stops after each executed
+		// command. Ending the program if the input has been closed.
+		int iTtyRet = gtty_run(&sTty, -1, &sCmdResult);
+		if (iTtyRet < 0)
+		{
+			break;
+		}
+		u8CmdReturned = (uint8_t)iTtyRet;
+#endif
 
 		// Checking if any command has returned a value
-		if (u16CmdRetVal & GSHELL_CMDRET)
+		if (u8CmdReturned)
 		{
 			// Process the return value, checking first which command ID returned a value
-			switch (u16CmdRetVal & GSHELL_CMDRET_MASK)
+			if (sCmdResult.cmdID == i16CmdIDs[CMD_EXIT])
 			{
-				case CMD_ID_EXIT:
-					// Exit-Command, return value is used to quit the endless while loop
-					u8AppRunning = GSHELL_CMDRET_VAL(u16CmdRetVal);
-					break;
-				default:
-					glog_ffl(GLOG_WARN);	// file-function-line print
-					glog_warn("Unhandled shell-command! Function-ID: 0x%02X Return-Value: 0x%02X",
-							  u16CmdRetVal & GSHELL_CMDRET_MASK, GSHELL_CMDRET_VAL(u16CmdRetVal));
-					break;
+				// Exit-Command, return value is used to quit the endless while loop
+				u8AppRunning = sCmdResult.value;
+			}
+			else
+			{
+				glog_ffl(GLOG_WARN);	// file-function-line print
+				glog_warn("Unhandled shell-command! Function-ID: 0x%02X Return-Value: 0x%02X",
+						  sCmdResult.cmdID, sCmdResult.value);
 			}
 		}
 	}
 
+#ifndef _WIN32
+	// Restoring the terminal settings
+	gtty_close(&sTty);
+#endif
 	return 0;
 }
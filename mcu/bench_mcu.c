@@ -0,0 +1,328 @@
+/**
+ * @brief Cycle and stack benchmark of gshell on simulated microcontrollers
+ *
+ * Runs scripted input and log workloads on the target and reports the cycles per
+ * received character, per command dispatch and per log message, together with
+ * the peak stack depth of each workload (below the frame of main). The output of gshell only gets counted
+ * while measuring, the results are printed on the UART afterwards.
+ *
+ * Targets:
+ *  - AVR (ATmega2560 under simavr), cycles counted by Timer1 at the CPU clock.
+ *    simavr is cycle accurate.
+ *  - Cortex-M3 (lm3s6965evb under qemu-system-arm), ticks counted by SysTick at the
+ *    CPU clock. qemu isn't cycle accurate: run it with '-icount shift=0' and the
+ *    figures are executed instructions (scaled by the clock rate of the board)
+ *    rather than cycles.
+ *
+ * Build and run all configurations with mcu/bench_mcu.sh, which also reports the
+ * flash / RAM footprint of each configuration macro.
+ *
+ * Not run on either target yet, see the README: the figures are unverified
+ * until a baseline has been measured and committed.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "../gshell.h"
+
+#define BENCH_ITER			64			/* Repetitions of each workload */
+#define BENCH_STACKPAINT	1536		/* Bytes below the stack pointer checked for use */
+#define BENCH_PATTERN		0xA5
+
+/****** TARGET SUPPORT ******/
+#if defined(__AVR__)
+#include <avr/interrupt.h>
+#include <avr/io.h>
+
+static volatile uint16_t u16Overflows;
+
+ISR(TIMER1_OVF_vect)
+{
+	u16Overflows++;
+}
+
+static void target_init(void)
+{
+	UBRR0 = 0;
+	UCSR0B = (1 << TXEN0);
+	TCCR1A = 0;
+	TCCR1B = (1 << CS10);				// CPU clock, no prescaler
+	TIMSK1 = (1 << TOIE1);
+	sei();
+}
+
+static void target_putc(char c)
+{
+	while (!(UCSR0A & (1 << UDRE0)));
+	UDR0 = c;
+}
+
+static uint32_t target_cycles(void)
+{
+	uint16_t u16High, u16Low;
+	uint8_t u8Sreg = SREG;
+
+	cli();
+	u16Low = TCNT1;
+	u16High = u16Overflows;
+	if ((TIFR1 & (1 << TOV1)) && (u16Low < 0x8000))
+	{
+		// Overflowed while reading, the interrupt is still pending
+		u16High++;
+	}
+	SREG = u8Sreg;
+	return ((uint32_t)u16High << 16) | u16Low;
+}
+
+static void target_exit(void)
+{
+	// simavr stops on sleep with interrupts disabled
+	cli();
+	__asm__ volatile ("sleep");
+}
+
+#elif defined(__arm__)
+#define UART0_DR		(*(volatile uint32_t *)0x4000C000)
+#define UART0_CTL		(*(volatile uint32_t *)0x4000C030)
+#define SYST_CSR		(*(volatile uint32_t *)0xE000E010)
+#define SYST_RVR		(*(volatile uint32_t *)0xE000E014)
+#define SYST_CVR		(*(volatile uint32_t *)0xE000E018)
+
+static volatile uint32_t u32Overflows;
+
+void SysTick_Handler(void)
+{
+	u32Overflows++;
+}
+
+static void target_init(void)
+{
+	UART0_CTL = 0x301;					// UART, transmitter and receiver enabled
+	SYST_RVR = 0x00FFFFFF;
+	SYST_CVR = 0;
+	SYST_CSR = 0x07;					// CPU clock, interrupt, enabled
+}
+
+static void target_putc(char c)
+{
+	UART0_DR = (uint32_t)(uint8_t)c;
+}
+
+static uint32_t target_cycles(void)
+{
+	uint32_t u32High, u32Val;
+
+	do
+	{
+		u32High = u32Overflows;
+		u32Val = SYST_CVR;
+	} while (u32High != u32Overflows);
+	return (u32High << 24) | (0x00FFFFFF - u32Val);
+}
+
+static void target_exit(void)
+{
+	// Semihosting SYS_EXIT, ADP_Stopped_ApplicationExit
+	register uint32_t r0 __asm__("r0") = 0x18;
+	register uint32_t r1 __asm__("r1") = 0x20026;
+
+	__asm__ volatile ("bkpt 0xAB" : : "r"(r0), "r"(r1));
+	while (1);
+}
+
+/* Startup: copy .data, clear .bss, vector table, see lm3s6965.ld */
+extern uint32_t _sidata, _sdata, _edata, _sbss, _ebss, _estack;
+int main(void);
+
+void Reset_Handler(void)
+{
+	uint32_t *pu32Src = &_sidata;
+	uint32_t *pu32Dst;
+
+	for (pu32Dst = &_sdata; pu32Dst < &_edata; *pu32Dst++ = *pu32Src++);
+	for (pu32Dst = &_sbss; pu32Dst < &_ebss; *pu32Dst++ = 0);
+	main();
+	target_exit();
+}
+
+static void Default_Handler(void)
+{
+	target_exit();
+}
+
+__attribute__((section(".isr_vector"), used))
+static void (* const vectors[16])(void) = {
+	(void (*)(void))&_estack, Reset_Handler, Default_Handler, Default_Handler,
+	Default_Handler, Default_Handler, Default_Handler, 0, 0, 0, 0,
+	Default_Handler, Default_Handler, 0, Default_Handler, SysTick_Handler
+};
+
+#else
+	#error "bench_mcu supports AVR and Cortex-M targets only"
+#endif
+
+/****** MEASUREMENT ******/
+enum bench_out {
+	OUT_UART = 0,		/* Printed on the UART */
+	OUT_COUNT,			/* Counted only, while measuring */
+	OUT_DROP			/* Dropped, while setting up a workload */
+};
+static uint8_t u8OutMode;
+static uint32_t u32OutBytes;
+
+static void bench_putChar(char c)
+{
+	if (u8OutMode == OUT_COUNT)
+	{
+		u32OutBytes++;
+	}
+	else if (u8OutMode == OUT_UART)
+	{
+		target_putc(c);
+	}
+}
+
+static uint32_t bench_millis(void)
+{
+	return 123456;
+}
+
+static uint8_t cmd_nop(uint8_t argc, char *argv[])
+{
+	(void)(argc);
+	(void)(argv);
+	return 0;
+}
+
+static gshell_cmd_t sNopCmd = {G_XARR("nop"), cmd_nop, G_XARR("Does nothing"), NULL};
+
+static uintptr_t uStackRef;				/* Address of a local of main, stack depths count from there */
+
+/* Fills the stack below its own frame with the pattern */
+static __attribute__((noinline)) void stack_paint(void)
+{
+	volatile uint8_t u8Marker;
+	uintptr_t uStart = (uintptr_t)&u8Marker - 64;
+	uint16_t u16_cnt;
+
+	for (u16_cnt = 0; u16_cnt < BENCH_STACKPAINT; u16_cnt++)
+	{
+		*(volatile uint8_t *)(uStart - u16_cnt) = BENCH_PATTERN;
+	}
+}
+
+/* Deepest stack use since stack_paint, in bytes below main. Called at the same
+ * depth as stack_paint, so the painted area is the same */
+static __attribute__((noinline)) uint16_t stack_used(void)
+{
+	volatile uint8_t u8Marker;
+	uintptr_t uAddr = (uintptr_t)&u8Marker - 64 - (BENCH_STACKPAINT - 1);
+	uint16_t u16_cnt;
+
+	for (u16_cnt = 0; u16_cnt < BENCH_STACKPAINT - 1; u16_cnt++, uAddr++)
+	{
+		if (*(volatile uint8_t *)uAddr != BENCH_PATTERN)
+		{
+			break;
+		}
+	}
+	return (uint16_t)(uStackRef - uAddr);
+}
+
+static void feed(const char *str)
+{
+	while (*str)
+	{
+		gshell_processShell(*str++);
+	}
+}
+
+/* Prints one result line, output not counted */
+static void report(const char *name, uint32_t u32Cycles, uint32_t u32Ops, uint16_t u16Stack)
+{
+	u8OutMode = OUT_UART;
+	gshell_putStringRAM(name);
+	gshell_putString(": ");
+	gshell_putU32(u32Cycles / u32Ops);
+	gshell_putString(" cycles/op, ");
+	gshell_putU32(u32OutBytes / u32Ops);
+	gshell_putString(" bytes/op, stack ");
+	gshell_putU32(u16Stack);
+	gshell_putString(G_CRLF);
+}
+
+int main(void)
+{
+	volatile uint8_t u8StackRef;
+	uint32_t u32Start, u32Cycles;
+	uint16_t u16Stack;
+	uint8_t u8_cnt;
+
+	uStackRef = (uintptr_t)&u8StackRef;
+	target_init();
+	gshell_init(bench_putChar, bench_millis);
+	gshell_register_cmd(&sNopCmd);
+	gshell_setPromt(1);
+	gshell_putString(G_CRLF "gshell MCU benchmark" G_CRLF);
+
+	// Characters typed in, echo only
+	u8OutMode = OUT_COUNT;
+	u32OutBytes = 0;
+	stack_paint();
+	u32Start = target_cycles();
+	for (u8_cnt = 0; u8_cnt < BENCH_ITER; u8_cnt++)
+	{
+		gshell_processShell('a');
+		gshell_processShell('\b');
+	}
+	u32Cycles = target_cycles() - u32Start;
+	u16Stack = stack_used();
+	report("processShell char", u32Cycles, 2 * BENCH_ITER, u16Stack);
+
+	// Dispatch: the newline of a typed command line, tokenizing up to the prompt
+	u32Cycles = 0;
+	u32OutBytes = 0;
+	stack_paint();
+	for (u8_cnt = 0; u8_cnt < BENCH_ITER; u8_cnt++)
+	{
+		u8OutMode = OUT_DROP;
+		feed("nop a \"b c\" d");
+		u8OutMode = OUT_COUNT;
+		u32Start = target_cycles();
+		gshell_processShell('\n');
+		u32Cycles += target_cycles() - u32Start;
+	}
+	u16Stack = stack_used();
+	report("dispatch", u32Cycles, BENCH_ITER, u16Stack);
+
+	// Log messages, prompt enabled: clear line, prefix, timestamp, prompt
+	u8OutMode = OUT_COUNT;
+	u32OutBytes = 0;
+	stack_paint();
+	u32Start = target_cycles();
+	for (u8_cnt = 0; u8_cnt < BENCH_ITER; u8_cnt++)
+	{
+		glog_warn("Battery low: %u mV", 3300u);
+	}
+	u32Cycles = target_cycles() - u32Start;
+	u16Stack = stack_used();
+	report("gshell_log_flash", u32Cycles, BENCH_ITER, u16Stack);
+
+	// Number output without vsprintf, for comparison
+	u8OutMode = OUT_COUNT;
+	u32OutBytes = 0;
+	stack_paint();
+	u32Start = target_cycles();
+	for (u8_cnt = 0; u8_cnt < BENCH_ITER; u8_cnt++)
+	{
+		gshell_putU32(3300);
+		gshell_putString(G_CRLF);
+	}
+	u32Cycles = target_cycles() - u32Start;
+	u16Stack = stack_used();
+	report("gshell_putU32", u32Cycles, BENCH_ITER, u16Stack);
+
+	gshell_putString("done" G_CRLF);
+	target_exit();
+	return 0;
+}
@@ -0,0 +1,84 @@
+#!/bin/sh
+# Cross-compiles mcu/bench_mcu.c for AVR (ATmega2560) and Cortex-M3 (lm3s6965evb),
+# once per configuration macro, runs it under simavr / qemu-system-arm and prints
+# the flash / RAM footprint of gshell.c next to the measured cycles and stack.
+#
+# Usage:    mcu/bench_mcu.sh [avr] [arm]        (both if none is given)
+# Requires: avr-gcc, avr-libc and simavr for AVR,
+#           arm-none-eabi-gcc (newlib-nano) and qemu-system-arm for Cortex-M.
+# The configurations can be replaced with CONFIGS="base G_ENABLE_TRACE ...".
+#
+# Not run on either target yet: no baseline has been measured, see the README.
+
+set -e
+cd "$(dirname "$0")/.."
+
+OUT=${OUT:-/tmp/gshell_bench_mcu}
+CONFIGS=${CONFIGS:-"base G_ENABLE_CMDCONTEXT G_ENABLE_TERMPROFILES G_ENABLE_SUBCOMMANDS G_ENABLE_ARGSCHEMA
+	G_ENABLE_LOGSINKS G_ENABLE_LOGFORMAT G_ENABLE_LOGHISTORY G_ENABLE_SESSIONS G_ENABLE_RXRING
+	G_ENABLE_TXQUEUES G_ENABLE_TRACE G_ENABLE_LOGSITES G_ENABLE_WATCH"}
+TARGETS=${*:-"avr arm"}
+mkdir -p "$OUT"
+
+run_target()
+{
+	target=$1
+	case $target in
+		avr)
+			CC=avr-gcc
+			SIZE=avr-size
+			CFLAGS="-mmcu=atmega2560 -DF_CPU=16000000UL -Os -std=gnu99"
+			LDFLAGS=""
+			;;
+		arm)
+			CC=arm-none-eabi-gcc
+			SIZE=arm-none-eabi-size
+			CFLAGS="-mcpu=cortex-m3 -mthumb -Os -std=gnu99 -ffunction-sections -fdata-sections"
+			LDFLAGS="-nostartfiles -T mcu/lm3s6965.ld --specs=nano.specs --specs=nosys.specs -Wl,--gc-sections"
+			;;
+	esac
+
+	printf '\n== %s ==\n' "$target"
+	if ! command -v $CC >/dev/null; then
+		printf '%s not found, skipped\n' "$CC"
+		return
+	fi
+	printf '%-24s %7s %6s\n' "Configuration" "Flash" "RAM"
+	for cfg in $CONFIGS; do
+		if [ "$cfg" = "base" ]; then
+			def=""
+		else
+			# The call-site section is placed by lm3s6965.ld only
+			[ "$cfg" = "G_ENABLE_LOGSITES" ] && [ "$target" = "avr" ] && continue
+			def="-D$cfg"
+		fi
+		elf="$OUT/bench_${target}_$cfg.elf"
+
+		# A configuration failing to build is reported, the others still run
+		if ! $CC $CFLAGS $def -c gshell.c -o "$OUT/gshell_${target}_$cfg.o" ||
+		   ! $CC $CFLAGS $def $LDFLAGS -o "$elf" mcu/bench_mcu.c gshell.c; then
+			printf '%-24s build failed\n' "$cfg"
+			continue
+		fi
+
+		# Footprint of the library alone: flash = text + data, RAM = data + bss
+		set -- $($SIZE "$OUT/gshell_${target}_$cfg.o" | tail -n 1)
+		flash=$(($1 + $2))
+		ram=$(($2 + $3))
+
+		if [ "$target" = "avr" ]; then
+			log=$(timeout 60 simavr -m atmega2560 -f 16000000 "$elf" 2>&1 || true)
+		else
+			# Virtual time advances per executed instruction, so SysTick ticks scale with them
+			log=$(timeout 60 qemu-system-arm -M lm3s6965evb -nographic -monitor none -semihosting \
+				-icount shift=0 -kernel "$elf" 2>&1 || true)
+		fi
+		printf '%-24s %7d %6d\n' "$cfg" "$flash" "$ram"
+		results=$(printf '%s\n' "$log" | tr -d '\r' | grep 'cycles/op' || true)
+		printf '%s\n' "${results:-no output}" | sed 's/^/    /'
+	done
+}
+
+for target in $TARGETS; do
+	run_target "$target"
+done